@@ -9,24 +9,52 @@
 #include "PVRLinkData.h"
 
 #include "tvlink/Settings.h"
+#include "tvlink/utilities/FileUtils.h"
 #include "tvlink/utilities/Logger.h"
 #include "tvlink/utilities/TimeUtils.h"
 #include "tvlink/utilities/WebUtils.h"
 
 #include "kodi/General.h"
 
-#include <ctime>
+#include <algorithm>
 #include <chrono>
+#include <ctime>
 
 using namespace tvlink;
 using namespace tvlink::data;
 using namespace tvlink::utilities;
 
+namespace
+{
+
+void LogStreamTelemetry(const char* function, const char* event, const StreamTelemetry::Snapshot& snapshot)
+{
+  Logger::Log(LEVEL_INFO, "%s - Live stream %s after %d (s): connect %d (ms), first byte %d (ms), throughput %d (kbit/s), %llu bytes in %u reads, "
+              "%u empty reads, %u stalls for %d (ms), %u reconnects with gaps of %d (ms), "
+              "%u TS packets with %u sync and %u continuity errors, bitrate %d (kbit/s) read as %d KB coalesced to %d KB, "
+              "buffer health %d%%, read sizes %s",
+              function, event, snapshot.m_sessionMillis / 1000, snapshot.m_connectMillis, snapshot.m_firstByteMillis, snapshot.m_throughputKbps,
+              static_cast<unsigned long long>(snapshot.m_totalBytes), snapshot.m_networkReads, snapshot.m_zeroByteReads,
+              snapshot.m_stalls, snapshot.m_stallMillis, snapshot.m_reconnects, snapshot.m_gapMillis,
+              snapshot.m_tsPackets, snapshot.m_tsSyncErrors, snapshot.m_tsContinuityErrors,
+              snapshot.m_bitrateKbps, snapshot.m_readSizeKB, snapshot.m_coalesceSizeKB, snapshot.GetBufferHealthPercent(), snapshot.FormatReadSizeHistogram().c_str());
+}
+
+} // unnamed namespace
+
 PVRLinkData::PVRLinkData()
 {
-  m_channels.Clear();
-  m_channelGroups.Clear();
-  m_epg.Clear();
+  // Generations are built one at a time, a loader blocks on its XMLTV fetch so
+  // one worker is always left over for it. Probes and pre-warm connects never
+  // block on other tasks, they only delay a fetch until their read finishes.
+  m_taskPool.SetCategoryLimit(TaskCategory::SCHEDULER, 1);
+  m_taskPool.SetCategoryLimit(TaskCategory::LOADER, 1);
+  m_taskPool.SetCategoryLimit(TaskCategory::FETCH, 1);
+  m_taskPool.SetCategoryLimit(TaskCategory::MAINTENANCE, 1);
+  m_taskPool.SetCategoryLimit(TaskCategory::PROBE, STREAM_PROBE_CONCURRENCY);
+  m_taskPool.SetCategoryLimit(TaskCategory::PREWARM, STREAM_PREWARM_CONCURRENCY);
+
+  PublishGeneration(std::make_shared<DataGeneration>(DataGeneration::PLACEHOLDER_VERSION));
 }
 
 ADDON_STATUS PVRLinkData::Create()
@@ -66,20 +94,25 @@ ADDON_STATUS PVRLinkData::Create()
 
   Settings::GetInstance().ReadFromAddon(kodi::addon::GetUserPath(), kodi::addon::GetAddonPath());
 
-  m_channels.Init();
-  m_channelGroups.Init();
-  m_playlistLoader.Init();
-  if (!m_playlistLoader.LoadPlayList())
-  {
-    m_channels.ChannelsLoadFailed();
-    m_channelGroups.ChannelGroupsLoadFailed();
-  }
-  m_epg.Init(EpgMaxPastDays(), EpgMaxFutureDays());
+  m_epgMaxPastDays = EpgMaxPastDays();
+  m_epgMaxFutureDays = EpgMaxFutureDays();
+
+  // Known stream types from earlier runs, so playback doesn't inspect them again
+  m_catchupController.LoadStreamEntries();
 
-  kodi::Log(ADDON_LOG_INFO, "%s Starting separate client update thread...", __FUNCTION__);
+  // In async mode Kodi is told about the channels, groups and EPG once the
+  // update thread has loaded them. Until then the last known channels from the
+  // snapshot are served, or if there is none the API calls report the server
+  // as unavailable so that Kodi keeps the data it already has.
+  const bool asyncStartup = Settings::GetInstance().UseAsyncStartup();
+  if (!asyncStartup)
+    LoadChannelsGroupsAndEPG(false, GetLoadCancellation());
+  else
+    LoadLastKnownChannels();
 
-  m_running = true;
-  m_thread = std::thread([&] { Process(); });
+  kodi::Log(ADDON_LOG_INFO, "%s Starting client update scheduler...", __FUNCTION__);
+
+  m_taskPool.Submit(TaskCategory::SCHEDULER, m_cancellation, [this, asyncStartup] { Process(asyncStartup); });
   iConnect_timeout = Settings::GetInstance().GetConnectTimeout(); // CURL connection timeout
 
   // ADDON_READ_TRUNCATED     - function returns before entire buffer has been filled
@@ -135,131 +168,378 @@ PVR_ERROR PVRLinkData::GetConnectionString(std::string& connection)
   return PVR_ERROR_NO_ERROR;
 }
 
-void PVRLinkData::Process()
+void PVRLinkData::Process(bool initialLoad)
 {
-  unsigned int refreshTimer = 0;
-  time_t lastRefreshTimeSeconds = std::time(nullptr);
-  int lastRefreshHour = Settings::GetInstance().GetM3URefreshHour(); //ignore if we start during same hour
+  // This loop only dispatches, the work itself runs on the other pool workers
+  if (initialLoad)
+  {
+    Logger::Log(LEVEL_INFO, "%s - Loading channels, groups and EPG in the background", __FUNCTION__);
+    const CancellationToken token = GetLoadCancellation();
+    m_taskPool.Submit(TaskCategory::LOADER, token, [this, token] { LoadChannelsGroupsAndEPG(true, token); });
+  }
 
-  while (m_running)
+  ScheduleRefreshes();
+
+  RefreshTask task;
+  while (m_scheduler.WaitForNextTask(task))
   {
-    std::this_thread::sleep_for(std::chrono::milliseconds(PROCESS_LOOP_WAIT_SECS * 1000));
+    switch (task)
+    {
+      case RefreshTask::PLAYLIST:
+      {
+        // A full reload supersedes any load still in progress or waiting to run,
+        // its own ScheduleRefreshes() puts back the deadlines those would have set
+        const CancellationToken token = RenewLoadCancellation();
+        m_taskPool.Submit(TaskCategory::LOADER, token, [this, token]
+        {
+          {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Settings::GetInstance().ReloadAddonSettings();
+          }
+
+          LoadChannelsGroupsAndEPG(true, token);
+
+          // The refresh settings may have changed so all deadlines are worked out again
+          ScheduleRefreshes();
+        });
+        break;
+      }
+      case RefreshTask::EPG:
+      {
+        const CancellationToken token = GetLoadCancellation();
+        m_taskPool.Submit(TaskCategory::LOADER, token, [this, token]
+        {
+          LoadEPG(token);
+          ScheduleEpgRefresh();
+        });
+        break;
+      }
+      case RefreshTask::CACHE_REVALIDATION:
+        m_taskPool.Submit(TaskCategory::MAINTENANCE, m_cancellation, [this]
+        {
+          RevalidateCaches();
+          ScheduleCacheRevalidation();
+        });
+        break;
+      case RefreshTask::CACHE_EVICTION:
+        m_taskPool.Submit(TaskCategory::MAINTENANCE, m_cancellation, [this]
+        {
+          int evicted = m_catchupController.EvictStreamEntries(STREAM_ENTRY_MAX_IDLE_SECS);
+          if (evicted > 0)
+            Logger::Log(LEVEL_DEBUG, "%s - Evicted %d idle stream entries", __FUNCTION__, evicted);
+          m_catchupController.SaveStreamEntries();
+          m_scheduler.Schedule(RefreshTask::CACHE_EVICTION, std::chrono::seconds(CACHE_EVICTION_INTERVAL_SECS), std::chrono::seconds(MAX_REFRESH_JITTER_SECS));
+        });
+        break;
+      case RefreshTask::STREAM_STATS:
+      {
+        const StreamTelemetry::Snapshot snapshot = m_liveStream.GetTelemetry().GetSnapshot();
+        if (snapshot.m_active)
+        {
+          LogStreamTelemetry(__FUNCTION__, "playing", snapshot);
+          m_scheduler.Schedule(RefreshTask::STREAM_STATS, std::chrono::seconds(STREAM_STATS_INTERVAL_SECS));
+        }
+        break;
+      }
+      case RefreshTask::PREWARM_EXPIRY:
+        m_taskPool.Submit(TaskCategory::MAINTENANCE, m_cancellation, [this]
+        {
+          // Handles warmed after this check live up to two timeouts, Adopt never hands those out
+          const std::chrono::seconds idleTimeout(Settings::GetInstance().GetPrewarmIdleTimeoutSecs());
+          if (m_streamPrewarmer.ExpireIdle(idleTimeout) > 0)
+            m_scheduler.Schedule(RefreshTask::PREWARM_EXPIRY, idleTimeout);
+        });
+        break;
+    }
+  }
+}
 
-    time_t currentRefreshTimeSeconds = std::time(nullptr);
-    std::tm timeInfo = SafeLocaltime(currentRefreshTimeSeconds);
-    refreshTimer += static_cast<unsigned int>(currentRefreshTimeSeconds - lastRefreshTimeSeconds);
-    lastRefreshTimeSeconds = currentRefreshTimeSeconds;
+void PVRLinkData::ScheduleRefreshes()
+{
+  const RefreshMode refreshMode = Settings::GetInstance().GetM3URefreshMode();
 
-    if (Settings::GetInstance().GetM3URefreshMode() == RefreshMode::REPEATED_REFRESH &&
-        refreshTimer >= (Settings::GetInstance().GetM3URefreshIntervalMins() * 60))
-      m_reloadChannelsGroupsAndEPG = true;
+  if (refreshMode == RefreshMode::REPEATED_REFRESH)
+  {
+    const int intervalSecs = Settings::GetInstance().GetM3URefreshIntervalMins() * 60;
+    m_scheduler.Schedule(RefreshTask::PLAYLIST, std::chrono::seconds(intervalSecs), std::chrono::seconds(std::min(intervalSecs / 10, MAX_REFRESH_JITTER_SECS)));
+  }
+  else if (refreshMode == RefreshMode::ONCE_PER_DAY)
+  {
+    // Next time the refresh hour starts, if we start during that hour it's tomorrow
+    const time_t now = std::time(nullptr);
+    std::tm refreshTime = SafeLocaltime(now);
+    if (refreshTime.tm_hour >= Settings::GetInstance().GetM3URefreshHour())
+      refreshTime.tm_mday++;
+    refreshTime.tm_hour = Settings::GetInstance().GetM3URefreshHour();
+    refreshTime.tm_min = 0;
+    refreshTime.tm_sec = 0;
+    refreshTime.tm_isdst = -1;
+
+    const time_t delaySecs = std::max<time_t>(std::mktime(&refreshTime) - now, 0);
+    m_scheduler.Schedule(RefreshTask::PLAYLIST, std::chrono::seconds(delaySecs), std::chrono::seconds(MAX_REFRESH_JITTER_SECS));
+  }
 
-    if (Settings::GetInstance().GetM3URefreshMode() == RefreshMode::ONCE_PER_DAY &&
-        lastRefreshHour != timeInfo.tm_hour && timeInfo.tm_hour == Settings::GetInstance().GetM3URefreshHour())
-      m_reloadChannelsGroupsAndEPG = true;
+  ScheduleEpgRefresh();
+  ScheduleCacheRevalidation();
+  m_scheduler.Schedule(RefreshTask::CACHE_EVICTION, std::chrono::seconds(CACHE_EVICTION_INTERVAL_SECS), std::chrono::seconds(MAX_REFRESH_JITTER_SECS));
+}
 
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_running && m_reloadChannelsGroupsAndEPG)
-    {
-      std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+void PVRLinkData::ScheduleEpgRefresh()
+{
+  // If refreshing is disabled the EPG is only loaded when Kodi asks for a new interval
+  if (Settings::GetInstance().GetM3URefreshMode() == RefreshMode::DISABLED)
+    m_scheduler.Cancel(RefreshTask::EPG);
+  else
+    m_scheduler.Schedule(RefreshTask::EPG, std::chrono::seconds(EPG_REFRESH_INTERVAL_SECS), std::chrono::seconds(MAX_REFRESH_JITTER_SECS));
+}
 
-      Settings::GetInstance().ReloadAddonSettings();
-      m_playlistLoader.ReloadPlayList();
-      m_epg.ReloadEPG();
+void PVRLinkData::ScheduleCacheRevalidation()
+{
+  // The M3U and XMLTV cache files are only used when refreshing is disabled
+  if (Settings::GetInstance().GetM3URefreshMode() == RefreshMode::DISABLED &&
+      (Settings::GetInstance().UseM3UCache() || Settings::GetInstance().UseEPGCache()))
+    m_scheduler.Schedule(RefreshTask::CACHE_REVALIDATION, std::chrono::seconds(CACHE_REVALIDATION_INTERVAL_SECS), std::chrono::seconds(MAX_REFRESH_JITTER_SECS));
+  else
+    m_scheduler.Cancel(RefreshTask::CACHE_REVALIDATION);
+}
 
-      m_reloadChannelsGroupsAndEPG = false;
-      refreshTimer = 0;
-    }
-    lastRefreshHour = timeInfo.tm_hour;
+void PVRLinkData::RevalidateCaches()
+{
+  if (Settings::GetInstance().UseM3UCache() &&
+      FileUtils::IsCachedFileStale(M3U_CACHE_FILENAME, Settings::GetInstance().GetM3ULocation()))
+  {
+    Logger::Log(LEVEL_INFO, "%s - Cached M3U is out of date, reloading channels, groups and EPG", __FUNCTION__);
+    m_scheduler.Schedule(RefreshTask::PLAYLIST, std::chrono::seconds(0));
+  }
+  else if (Settings::GetInstance().UseEPGCache() &&
+           FileUtils::IsCachedFileStale(XMLTV_CACHE_FILENAME, Settings::GetInstance().GetEpgLocation()))
+  {
+    Logger::Log(LEVEL_INFO, "%s - Cached XMLTV is out of date, reloading EPG", __FUNCTION__);
+    m_scheduler.Schedule(RefreshTask::EPG, std::chrono::seconds(0));
   }
 }
 
 PVRLinkData::~PVRLinkData()
 {
-  Logger::Log(LEVEL_DEBUG, "%s Stopping update thread...", __FUNCTION__);
-  m_running = false;
-  if (m_thread.joinable())
-    m_thread.join();
+  Logger::Log(LEVEL_DEBUG, "%s Stopping update tasks...", __FUNCTION__);
+  m_scheduler.Stop();
+  m_cancellation.Cancel();
+  GetLoadCancellation().Cancel();
+  m_taskPool.Shutdown();
+  m_catchupController.SaveStreamEntries();
+  m_streamPrewarmer.Clear();
+}
 
-  std::lock_guard<std::mutex> lock(m_mutex);
-  m_channels.Clear();
-  m_channelGroups.Clear();
-  m_epg.Clear();
+std::shared_ptr<const DataGeneration> PVRLinkData::GetGeneration() const
+{
+  return std::atomic_load(&m_generation);
+}
+
+void PVRLinkData::PublishGeneration(const std::shared_ptr<const DataGeneration>& generation)
+{
+  std::atomic_store(&m_generation, generation);
+}
+
+CancellationToken PVRLinkData::GetLoadCancellation()
+{
+  std::lock_guard<std::mutex> lock(m_loadCancellationMutex);
+  return m_loadCancellation;
+}
+
+CancellationToken PVRLinkData::RenewLoadCancellation()
+{
+  std::lock_guard<std::mutex> lock(m_loadCancellationMutex);
+  m_loadCancellation.Cancel();
+  m_loadCancellation = CancellationToken();
+  return m_loadCancellation;
+}
+
+void PVRLinkData::LoadChannelsGroupsAndEPG(bool triggerUpdates, const CancellationToken& token)
+{
+  // Everything is loaded into a new generation while the API calls keep
+  // reading from the current one, the swap below is the only shared write
+  auto generation = std::make_shared<DataGeneration>(++m_generationVersion);
+  bool epgLoaded = false;
+  const bool channelsLoaded = generation->LoadChannelsAndEpg(m_epgMaxPastDays, m_epgMaxFutureDays, m_epgWindowStart, m_epgWindowEnd, epgLoaded,
+                                                             m_taskPool, token);
+
+  // A superseded load never replaces what is already published
+  if (token.IsCancelled())
+  {
+    Logger::Log(LEVEL_INFO, "%s - Generation %u was cancelled, not publishing", __FUNCTION__, generation->GetVersion());
+    return;
+  }
+
+  PublishGeneration(generation);
+
+  Logger::Log(LEVEL_INFO, "%s - Published generation %u with %d channels", __FUNCTION__, generation->GetVersion(), generation->GetChannels().GetChannelsAmount());
+
+  // Probes of a superseded playlist are dropped along with its load
+  if (channelsLoaded)
+    m_catchupController.ProbeStreams(generation->GetChannels(), m_taskPool, token);
+
+  if (!triggerUpdates)
+    return;
+
+  if (channelsLoaded)
+  {
+    TriggerChannelUpdate();
+    TriggerChannelGroupsUpdate();
+  }
+
+  if (epgLoaded)
+    TriggerEpgUpdates(*generation);
+}
+
+void PVRLinkData::LoadLastKnownChannels()
+{
+  auto generation = std::make_shared<DataGeneration>(m_generationVersion + 1);
+  if (!generation->LoadChannelsFromSnapshot())
+    return;
+
+  m_generationVersion++;
+  PublishGeneration(generation);
+
+  Logger::Log(LEVEL_INFO, "%s - Published generation %u with %d last known channels", __FUNCTION__, generation->GetVersion(), generation->GetChannels().GetChannelsAmount());
+}
+
+void PVRLinkData::LoadEPG(const CancellationToken& token)
+{
+  std::shared_ptr<const DataGeneration> currentGeneration = GetGeneration();
+  if (currentGeneration->IsPlaceholder())
+  {
+    // Nothing to carry over yet
+    LoadChannelsGroupsAndEPG(true, token);
+    return;
+  }
+
+  // Channels and groups are carried over, only the EPG is loaded again
+  auto generation = std::make_shared<DataGeneration>(++m_generationVersion, *currentGeneration);
+  const bool epgLoaded = generation->LoadEpg(m_epgMaxPastDays, m_epgMaxFutureDays, m_epgWindowStart, m_epgWindowEnd, token);
+
+  if (token.IsCancelled())
+  {
+    Logger::Log(LEVEL_INFO, "%s - Generation %u was cancelled, not publishing", __FUNCTION__, generation->GetVersion());
+    return;
+  }
+
+  PublishGeneration(generation);
+
+  Logger::Log(LEVEL_INFO, "%s - Published generation %u with EPG for %ld to %ld", __FUNCTION__, generation->GetVersion(), static_cast<long>(m_epgWindowStart), static_cast<long>(m_epgWindowEnd));
+
+  if (generation->GetEpg().ChannelLogosUpdated())
+    TriggerChannelUpdate();
+
+  if (epgLoaded)
+    TriggerEpgUpdates(*generation);
+}
+
+void PVRLinkData::TriggerEpgUpdates(const DataGeneration& generation)
+{
+  for (const auto& channel : generation.GetChannels().GetChannelsList())
+    TriggerEpgUpdate(channel->GetUniqueId());
 }
 
 PVR_ERROR PVRLinkData::GetChannelsAmount(int& amount)
 {
-  std::lock_guard<std::mutex> lock(m_mutex);
-  amount = m_channels.GetChannelsAmount();
+  std::shared_ptr<const DataGeneration> generation = GetGeneration();
+  if (generation->IsPlaceholder())
+    return PVR_ERROR_SERVER_TIMEOUT;
+
+  amount = generation->GetChannels().GetChannelsAmount();
   return PVR_ERROR_NO_ERROR;
 }
 
 PVR_ERROR PVRLinkData::GetChannels(bool radio, kodi::addon::PVRChannelsResultSet& results)
 {
-  std::lock_guard<std::mutex> lock(m_mutex);
+  std::shared_ptr<const DataGeneration> generation = GetGeneration();
+  if (generation->IsPlaceholder())
+    return PVR_ERROR_SERVER_TIMEOUT;
 
-  return m_channels.GetChannels(results, radio);
+  return generation->GetChannels().GetChannels(results, radio);
 }
 
-bool PVRLinkData::GetChannel(const kodi::addon::PVRChannel& channel, Channel& myChannel)
+std::shared_ptr<const Channel> PVRLinkData::GetChannel(const kodi::addon::PVRChannel& channel)
 {
-  std::lock_guard<std::mutex> lock(m_mutex);
-
-  return m_channels.GetChannel(channel, myChannel);
+  return GetGeneration()->GetChannels().GetChannel(channel);
 }
 
-bool PVRLinkData::GetChannel(unsigned int uniqueChannelId, tvlink::data::Channel& myChannel)
+std::shared_ptr<const Channel> PVRLinkData::GetChannel(unsigned int uniqueChannelId)
 {
-  std::lock_guard<std::mutex> lock(m_mutex);
-
-  return m_channels.GetChannel(uniqueChannelId, myChannel);
+  return GetGeneration()->GetChannels().GetChannel(uniqueChannelId);
 }
 
 PVR_ERROR PVRLinkData::GetChannelGroupsAmount(int& amount)
 {
-  std::lock_guard<std::mutex> lock(m_mutex);
-  amount = m_channelGroups.GetChannelGroupsAmount();
+  std::shared_ptr<const DataGeneration> generation = GetGeneration();
+  if (generation->IsPlaceholder())
+    return PVR_ERROR_SERVER_TIMEOUT;
+
+  amount = generation->GetChannelGroups().GetChannelGroupsAmount();
   return PVR_ERROR_NO_ERROR;
 }
 
 PVR_ERROR PVRLinkData::GetChannelGroups(bool radio, kodi::addon::PVRChannelGroupsResultSet& results)
 {
-  std::lock_guard<std::mutex> lock(m_mutex);
+  std::shared_ptr<const DataGeneration> generation = GetGeneration();
+  if (generation->IsPlaceholder())
+    return PVR_ERROR_SERVER_TIMEOUT;
 
-  return m_channelGroups.GetChannelGroups(results, radio);
+  return generation->GetChannelGroups().GetChannelGroups(results, radio);
 }
 
 PVR_ERROR PVRLinkData::GetChannelGroupMembers(const kodi::addon::PVRChannelGroup& group, kodi::addon::PVRChannelGroupMembersResultSet& results)
 {
-  std::lock_guard<std::mutex> lock(m_mutex);
+  std::shared_ptr<const DataGeneration> generation = GetGeneration();
+  if (generation->IsPlaceholder())
+    return PVR_ERROR_SERVER_TIMEOUT;
 
-  return m_channelGroups.GetChannelGroupMembers(group, results);
+  return generation->GetChannelGroups().GetChannelGroupMembers(group, results);
 }
 
 PVR_ERROR PVRLinkData::GetEPGForChannel(int channelUid, time_t start, time_t end, kodi::addon::PVREPGTagsResultSet& results)
 {
-  std::lock_guard<std::mutex> lock(m_mutex);
+  // EPG updates are triggered for every channel once the first load completes
+  std::shared_ptr<const DataGeneration> generation = GetGeneration();
+  if (generation->IsPlaceholder())
+    return PVR_ERROR_SERVER_TIMEOUT;
 
-  return m_epg.GetEPGForChannel(channelUid, start, end, results);
+  if (start < m_epgWindowStart || end > m_epgWindowEnd)
+  {
+    // The EPG for the new time interval is loaded by the update thread, Kodi
+    // is asked to fetch it again once the new generation is published.
+    // Kodi asks for now +/- the EPG days, so the end moves on with every call.
+    // Loading a day beyond it keeps the calls that follow the reload inside
+    // the loaded window instead of starting the next reload.
+    // Doesn't matter if it loads or not, we shouldn't try the same interval twice
+    m_epgWindowStart = start;
+    m_epgWindowEnd = end + EPG_WINDOW_MARGIN_SECS;
+    m_scheduler.Schedule(RefreshTask::EPG, std::chrono::seconds(0));
+  }
+
+  return generation->GetEpg().GetEPGForChannel(channelUid, start, end, results);
 }
 
 PVR_ERROR PVRLinkData::GetEPGTagStreamProperties(const kodi::addon::PVREPGTag& tag, std::vector<kodi::addon::PVRStreamProperty>& properties)
 {
   Logger::Log(LEVEL_DEBUG, "%s - Tag startTime: %ld \tendTime: %ld", __FUNCTION__, tag.GetStartTime(), tag.GetEndTime());
 
-  if (GetChannel(static_cast<int>(tag.GetUniqueChannelId()), m_currentChannel))
+  std::shared_ptr<const DataGeneration> generation = GetGeneration();
+  std::shared_ptr<const Channel> channel = generation->GetChannels().GetChannel(static_cast<int>(tag.GetUniqueChannelId()));
+  if (channel)
   {
     Logger::Log(LEVEL_DEBUG, "%s - GetPlayEpgAsLive is %s", __FUNCTION__, Settings::GetInstance().CatchupPlayEpgAsLive() ? "enabled" : "disabled");
 
+    // The session only lives for this request and reads from the generation held above
+    CatchupSession catchupSession = m_catchupController.CreateSession(generation->GetEpg(), *channel);
+
     std::map<std::string, std::string> catchupProperties;
-    m_catchupController.ProcessEPGTagForTimeshiftedPlayback(tag, m_currentChannel, catchupProperties);
-    std::string orgUrl = m_currentChannel.GetStreamURL();
+    catchupSession.ProcessEPGTagForTimeshiftedPlayback(tag, catchupProperties);
 
     // shift catchup url
-    m_currentChannel.GenerateShiftCatchupSource(orgUrl);
-    const std::string catchupShiftUrl = m_catchupController.GetCatchupUrl(m_currentChannel);
-      
-    StreamUtils::SetAllStreamProperties(properties, m_currentChannel, catchupShiftUrl, false, catchupProperties);
+    const std::string catchupShiftUrl = catchupSession.GetCatchupUrl(channel->GetShiftCatchupSourceTemplate());
+
+    StreamUtils::SetAllStreamProperties(properties, *channel, catchupShiftUrl, false, catchupProperties, catchupSession.GetStreamType());
 
     Logger::Log(LEVEL_INFO, "%s - EPG Catchup URL: %s", __FUNCTION__, WebUtils::RedactUrl(catchupShiftUrl).c_str());
     return PVR_ERROR_NO_ERROR;
@@ -274,27 +554,27 @@ PVR_ERROR PVRLinkData::IsEPGTagPlayable(const kodi::addon::PVREPGTag& tag, bool&
     return PVR_ERROR_NOT_IMPLEMENTED;
 
   const time_t now = std::time(nullptr);
-  Channel channel;
 
-  // Get the channel and set the current tag on it if found
-  bIsPlayable = GetChannel(static_cast<int>(tag.GetUniqueChannelId()), channel) &&
-                Settings::GetInstance().IsCatchupEnabled() && channel.IsCatchupSupported();
+  // Kodi asks for every programme the guide renders, so this only uses lookups
+  // prepared when the generation was loaded and borrows the channel from it
+  std::shared_ptr<const DataGeneration> generation = GetGeneration();
+  const int channelUid = static_cast<int>(tag.GetUniqueChannelId());
+  const Channel* channel = generation->GetChannels().FindChannel(channelUid);
+  bIsPlayable = channel && channel->IsCatchupSupported();
+
+  if (!channel)
+    return PVR_ERROR_NO_ERROR;
 
-  if (channel.IgnoreCatchupDays())
+  if (channel->IgnoreCatchupDays())
   {
     // If we ignore catchup days then any tag can be played but only if it has a catchup ID
-    bool hasCatchupId = false;
-    EpgEntry* epgEntry = m_catchupController.GetEPGEntry(channel, tag.GetStartTime());
-    if (epgEntry)
-      hasCatchupId = !epgEntry->GetCatchupId().empty();
-
-    bIsPlayable = bIsPlayable && hasCatchupId;
+    bIsPlayable = bIsPlayable && generation->GetEpg().HasCatchupId(channelUid, tag.GetStartTime());
   }
   else
   {
     bIsPlayable = bIsPlayable &&
                   tag.GetStartTime() < now &&
-                  tag.GetStartTime() >= (now - static_cast<time_t>(channel.GetCatchupDaysInSeconds())) &&
+                  tag.GetStartTime() >= (now - static_cast<time_t>(channel->GetCatchupDaysInSeconds())) &&
                   (!Settings::GetInstance().CatchupOnlyOnFinishedProgrammes() || tag.GetEndTime() < now);
   }
 
@@ -303,20 +583,47 @@ PVR_ERROR PVRLinkData::IsEPGTagPlayable(const kodi::addon::PVREPGTag& tag, bool&
 
 PVR_ERROR PVRLinkData::SetEPGMaxPastDays(int epgMaxPastDays)
 {
-  m_epg.SetEPGMaxPastDays(epgMaxPastDays);
+  // Picked up by the next generation that loads the EPG
+  m_epgMaxPastDays = epgMaxPastDays;
   return PVR_ERROR_NO_ERROR;
 }
 
 PVR_ERROR PVRLinkData::SetEPGMaxFutureDays(int epgMaxFutureDays)
 {
-  m_epg.SetEPGMaxFutureDays(epgMaxFutureDays);
+  m_epgMaxFutureDays = epgMaxFutureDays;
   return PVR_ERROR_NO_ERROR;
 }
 
 PVR_ERROR PVRLinkData::GetSignalStatus(int channelUid, kodi::addon::PVRSignalStatus& signalStatus)
 {
+  const StreamTelemetry::Snapshot snapshot = m_liveStream.GetTelemetry().GetSnapshot();
+
   signalStatus.SetAdapterName("TVLINK Adapter 1");
-  signalStatus.SetAdapterStatus("OK");
+  if (!snapshot.m_active)
+  {
+    signalStatus.SetAdapterStatus("No stream");
+    return PVR_ERROR_NO_ERROR;
+  }
+
+  signalStatus.SetAdapterStatus(snapshot.m_firstByteMillis < 0 ? "Connecting" : "OK");
+
+  // There is no tuner, so the player's codec info fields carry the stream numbers instead
+  signalStatus.SetServiceName(std::to_string(snapshot.m_throughputKbps) + " kbit/s (est. " + std::to_string(snapshot.m_bitrateKbps) + "), reads " +
+                              std::to_string(snapshot.m_readSizeKB) + " KB, coalesce " + std::to_string(snapshot.m_coalesceSizeKB) + " KB");
+  signalStatus.SetProviderName("connect " + std::to_string(snapshot.m_connectMillis) + " ms, first byte " +
+                               std::to_string(snapshot.m_firstByteMillis) + " ms");
+  signalStatus.SetMuxName(std::to_string(snapshot.m_stalls) + " stalls (" + std::to_string(snapshot.m_stallMillis) + " ms), " +
+                          std::to_string(snapshot.m_reconnects) + " reconnects (last gap " + std::to_string(snapshot.m_lastGapMillis) + " ms), " +
+                          std::to_string(snapshot.m_zeroByteReads) + " empty reads");
+
+  // Signal is how full the read-ahead buffer is, SNR how much of the session played without waiting for data
+  const int bufferLevelPercent = m_liveStream.GetBufferLevelPercent();
+  if (bufferLevelPercent >= 0)
+    signalStatus.SetSignal(bufferLevelPercent * 0xFFFF / 100);
+  signalStatus.SetSNR(snapshot.GetBufferHealthPercent() * 0xFFFF / 100);
+
+  // Lost syncs and continuity errors are the closest thing to uncorrected blocks
+  signalStatus.SetUNC(snapshot.m_tsSyncErrors + snapshot.m_tsContinuityErrors);
 
   return PVR_ERROR_NO_ERROR;
 }
@@ -325,10 +632,9 @@ ADDON_STATUS PVRLinkData::SetSetting(const std::string& settingName, const kodi:
 {
   std::lock_guard<std::mutex> lock(m_mutex);
 
-  // When a number of settings change set this on the first one so it can be picked up
-  // in the process call for a reload of channels, groups and EPG.
-  if (!m_reloadChannelsGroupsAndEPG)
-    m_reloadChannelsGroupsAndEPG = true;
+  // When a number of settings change the reload is scheduled on the first one, the
+  // short delay lets the rest of the changes arrive before channels, groups and EPG reload.
+  m_scheduler.Schedule(RefreshTask::PLAYLIST, std::chrono::seconds(SETTINGS_CHANGE_DELAY_SECS));
 
   return Settings::GetInstance().SetValue(settingName, settingValue);
 }
@@ -337,43 +643,235 @@ ADDON_STATUS PVRLinkData::SetSetting(const std::string& settingName, const kodi:
 
 bool PVRLinkData::OpenLiveStream(const kodi::addon::PVRChannel& channel)
 {
-  if (GetChannel(channel, m_currentChannel))
+  std::shared_ptr<const DataGeneration> generation = GetGeneration();
+  std::shared_ptr<const Channel> currentChannel = generation->GetChannels().GetChannel(channel);
+  if (currentChannel)
   {
-    ch_url = m_currentChannel.GetStreamURL();
-    ch_name = m_currentChannel.GetChannelName();
+    ch_url = currentChannel->GetStreamURL();
+    ch_name = currentChannel->GetChannelName();
     Logger::Log(LogLevel::LEVEL_INFO, "%s - [%s] %s Live URL: %s", __FUNCTION__, ch_name.c_str(), strCurl_buff.c_str(), WebUtils::RedactUrl(ch_url).c_str());
 
-    m_streamHandle.CURLCreate(ch_url.c_str());
-    m_streamHandle.CURLAddOption(ADDON_CURL_OPTION_PROTOCOL, "connection-timeout", std::to_string(iConnect_timeout).c_str());
-    m_streamHandle.CURLAddOption(ADDON_CURL_OPTION_PROTOCOL, "data-timeout", "0");
-    m_streamHandle.CURLAddOption(ADDON_CURL_OPTION_PROTOCOL, "lowspeed-time", "0");
-    m_streamHandle.CURLAddOption(ADDON_CURL_OPTION_PROTOCOL, "speed-limit", "0");
+    const bool readAhead = Settings::GetInstance().UseReadAhead();
+    const size_t readAheadBytes = readAhead ? Settings::GetInstance().GetReadAheadBytes() : 0;
+    const size_t prefillBytes = readAhead ? Settings::GetInstance().GetReadAheadPrefillBytes() : 0;
+
+    m_liveStream.SetBitrateHint(m_catchupController.GetStreamBitrate(*currentChannel));
+    if (Settings::GetInstance().UseTimeshift())
+      m_liveStream.SetTimeshift(FileUtils::PathCombine(Settings::GetInstance().GetTimeshiftPath(), TIMESHIFT_FILENAME), Settings::GetInstance().GetTimeshiftBytes());
+    else
+      m_liveStream.SetTimeshift("", 0);
+
+    const std::vector<std::string> streamUrls = m_streamSources.RankStreamURLs(*currentChannel);
+
+    const auto started = std::chrono::steady_clock::now();
+
+    // Only the best ranked source is pre-warmed
+    std::unique_ptr<kodi::vfs::CFile> warmFile;
+    if (Settings::GetInstance().GetPrewarmStreams() > 0)
+      warmFile = m_streamPrewarmer.Adopt(currentChannel->GetUniqueId(), streamUrls.front(), std::chrono::seconds(Settings::GetInstance().GetPrewarmIdleTimeoutSecs()));
+
+    const bool warm = warmFile != nullptr;
+    if (warm)
+    {
+      ch_url = streamUrls.front();
+      m_liveStream.Open(std::move(warmFile), ch_url, iCurl_flags, iConnect_timeout, readAheadBytes, prefillBytes);
+    }
+    else
+    {
+      // Sources are tried one after the other, best first, until one opens
+      for (const auto& streamUrl : streamUrls)
+      {
+        const auto sourceStarted = std::chrono::steady_clock::now();
+        ch_url = streamUrl;
+        if (OpenStreamSource(ch_url, readAheadBytes, prefillBytes))
+        {
+          m_streamSources.RecordOpened(ch_url, static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - sourceStarted).count()));
+          break;
+        }
+
+        m_streamSources.RecordFailed(ch_url);
+        if (streamUrls.size() > 1)
+          Logger::Log(LEVEL_ERROR, "%s - [%s] Could not open stream source: %s", __FUNCTION__, ch_name.c_str(), WebUtils::RedactUrl(ch_url).c_str());
+      }
+    }
+
+    const int milliseconds = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count());
+    Logger::Log(LEVEL_INFO, "%s - [%s] Stream opened in %d (ms) from a %s connection to source %d of %d, pre-warm hits: %u, misses: %u, redirect cache hits: %u, misses: %u",
+                __FUNCTION__, ch_name.c_str(), milliseconds, warm ? "warm" : "cold", static_cast<int>(std::find(streamUrls.begin(), streamUrls.end(), ch_url) - streamUrls.begin()) + 1,
+                static_cast<int>(streamUrls.size()), m_streamPrewarmer.GetHits(), m_streamPrewarmer.GetMisses(),
+                m_streamSources.GetRedirectHits(), m_streamSources.GetRedirectMisses());
 
-    m_streamHandle.CURLOpen(iCurl_flags);
+    PrewarmZapCandidates(*generation, *currentChannel);
 
-    return m_streamHandle.IsOpen();
+    if (!m_liveStream.IsOpen())
+      return false;
+
+    m_scheduler.Schedule(RefreshTask::STREAM_STATS, std::chrono::seconds(STREAM_STATS_INTERVAL_SECS));
+    return true;
   }
   return false;
 }
 
+bool PVRLinkData::OpenStreamSource(const std::string& streamUrl, size_t readAheadBytes, size_t prefillBytes)
+{
+  return m_streamSources.OpenSource(streamUrl, [&](const std::string& connectUrl, std::string& effectiveUrl) {
+    // Reconnects use the stream URL and follow the redirects again, by then a redirected URL may have expired
+    if (!m_liveStream.Open(connectUrl, streamUrl, iCurl_flags, iConnect_timeout, readAheadBytes, prefillBytes))
+      return false;
+
+    effectiveUrl = m_liveStream.GetEffectiveURL();
+    return true;
+  });
+}
+
+void PVRLinkData::PrewarmZapCandidates(const DataGeneration& generation, const Channel& channel)
+{
+  if (channel.GetUniqueId() != m_currentChannelUid)
+  {
+    m_recentChannelUid = m_currentChannelUid;
+    m_currentChannelUid = channel.GetUniqueId();
+  }
+
+  const int budget = Settings::GetInstance().GetPrewarmStreams();
+  if (budget <= 0)
+  {
+    m_streamPrewarmer.Clear();
+    return;
+  }
+
+  std::vector<std::shared_ptr<const Channel>> candidates = GetZapCandidates(generation, channel);
+  if (candidates.size() > static_cast<size_t>(budget))
+    candidates.resize(budget);
+
+  std::vector<int> candidateUids;
+  for (const auto& candidate : candidates)
+    candidateUids.emplace_back(candidate->GetUniqueId());
+  m_streamPrewarmer.Retain(candidateUids);
+
+  for (const auto& candidate : candidates)
+  {
+    m_taskPool.Submit(TaskCategory::PREWARM, m_cancellation, [this, candidate, budget]
+    {
+      m_streamPrewarmer.Warm(candidate->GetUniqueId(), m_streamSources.RankStreamURLs(*candidate).front(), iCurl_flags, iConnect_timeout, budget,
+                             m_cancellation);
+    });
+  }
+
+  m_scheduler.Schedule(RefreshTask::PREWARM_EXPIRY, std::chrono::seconds(Settings::GetInstance().GetPrewarmIdleTimeoutSecs()));
+}
+
+std::vector<std::shared_ptr<const Channel>> PVRLinkData::GetZapCandidates(const DataGeneration& generation, const Channel& channel) const
+{
+  const Channels& channels = generation.GetChannels();
+  const auto& channelsList = channels.GetChannelsList();
+  const int channelIndex = channels.GetChannelIndex(channel.GetUniqueId());
+
+  // Channel up/down moves within the group being watched, without one it moves
+  // through all channels of the same kind
+  std::vector<int> memberIndexes;
+  for (const auto& channelGroup : generation.GetChannelGroups().GetChannelGroupsList())
+  {
+    const std::vector<int>& groupMemberIndexes = channelGroup.GetMemberChannelIndexes();
+    if (channelGroup.IsRadio() == channel.IsRadio() &&
+        std::find(groupMemberIndexes.begin(), groupMemberIndexes.end(), channelIndex) != groupMemberIndexes.end())
+    {
+      memberIndexes = groupMemberIndexes;
+      break;
+    }
+  }
+
+  if (memberIndexes.empty())
+  {
+    for (size_t i = 0; i < channelsList.size(); i++)
+    {
+      if (channelsList[i]->IsRadio() == channel.IsRadio())
+        memberIndexes.emplace_back(static_cast<int>(i));
+    }
+  }
+
+  std::vector<std::shared_ptr<const Channel>> candidates;
+  auto addCandidate = [&](int index)
+  {
+    if (index < 0 || index >= static_cast<int>(channelsList.size()) || index == channelIndex)
+      return;
+    if (std::find(candidates.begin(), candidates.end(), channelsList[index]) == candidates.end())
+      candidates.emplace_back(channelsList[index]);
+  };
+
+  // In order of likelihood, the budget keeps the first ones
+  const auto position = std::find(memberIndexes.begin(), memberIndexes.end(), channelIndex);
+  const int memberCount = static_cast<int>(memberIndexes.size());
+  const int memberPosition = static_cast<int>(position - memberIndexes.begin());
+  if (position != memberIndexes.end())
+    addCandidate(memberIndexes[(memberPosition + 1) % memberCount]);
+  if (m_recentChannelUid != 0)
+    addCandidate(channels.GetChannelIndex(m_recentChannelUid));
+  if (position != memberIndexes.end())
+    addCandidate(memberIndexes[(memberPosition + memberCount - 1) % memberCount]);
+
+  return candidates;
+}
+
 void PVRLinkData::CloseLiveStream(void)
 {
-  if (m_streamHandle.IsOpen())
+  if (m_liveStream.IsOpen())
   {
-    m_streamHandle.Close();
+    m_liveStream.Close();
+    m_scheduler.Cancel(RefreshTask::STREAM_STATS);
     Logger::Log(LogLevel::LEVEL_INFO, "%s - [%s] Live URL: %s", __FUNCTION__, ch_name.c_str(), WebUtils::RedactUrl(ch_url).c_str());
+
+    const StreamTelemetry::Snapshot snapshot = m_liveStream.GetTelemetry().GetSnapshot();
+    LogStreamTelemetry(__FUNCTION__, "closed", snapshot);
+
+    // The next time the channel plays its reads are sized from the start
+    std::shared_ptr<const Channel> channel = GetChannel(static_cast<unsigned int>(m_currentChannelUid));
+    if (channel && snapshot.m_bitrateKbps > 0)
+      m_catchupController.SetStreamBitrate(*channel, snapshot.m_bitrateKbps);
   }
 
 }
 
 int PVRLinkData::ReadLiveStream(unsigned char *pBuffer, unsigned int iBufferSize)
 {
-  return m_streamHandle.Read(pBuffer, iBufferSize);
+  return m_liveStream.Read(pBuffer, iBufferSize);
 }
 
 bool PVRLinkData::CanPauseStream()
 {
-  return m_streamHandle.IsOpen();
+  // Without timeshift a pause only stops the reads, the server soon stops sending and may drop the connection
+  return m_liveStream.IsTimeshifting();
+}
+
+bool PVRLinkData::CanSeekStream()
+{
+  return m_liveStream.IsTimeshifting();
+}
+
+int64_t PVRLinkData::SeekLiveStream(int64_t position, int whence)
+{
+  return m_liveStream.Seek(position, whence);
+}
+
+int64_t PVRLinkData::LengthLiveStream()
+{
+  return m_liveStream.GetLength();
+}
+
+PVR_ERROR PVRLinkData::GetStreamTimes(kodi::addon::PVRStreamTimes& times)
+{
+  time_t openTime;
+  std::chrono::milliseconds startMillis;
+  std::chrono::milliseconds endMillis;
+  if (!m_liveStream.GetTimeshiftTimes(openTime, startMillis, endMillis))
+    return PVR_ERROR_NOT_IMPLEMENTED;
+
+  // Times are in microseconds from when the stream was opened
+  times.SetStartTime(openTime);
+  times.SetPTSStart(0);
+  times.SetPTSBegin(std::chrono::duration_cast<std::chrono::microseconds>(startMillis).count());
+  times.SetPTSEnd(std::chrono::duration_cast<std::chrono::microseconds>(endMillis).count());
+
+  return PVR_ERROR_NO_ERROR;
 }
 
 ADDONCREATOR(PVRLinkData)
@@ -9,15 +9,19 @@
 #pragma once
 
 #include "tvlink/CatchupController.h"
-#include "tvlink/Channels.h"
-#include "tvlink/ChannelGroups.h"
-#include "tvlink/Epg.h"
-#include "tvlink/PlaylistLoader.h"
+#include "tvlink/DataGeneration.h"
+#include "tvlink/LiveStream.h"
+#include "tvlink/RefreshScheduler.h"
+#include "tvlink/StreamPrewarmer.h"
+#include "tvlink/StreamSources.h"
 #include "tvlink/data/Channel.h"
+#include "tvlink/utilities/TaskPool.h"
 
 #include <atomic>
+#include <ctime>
+#include <memory>
 #include <mutex>
-#include <thread>
+#include <vector>
 
 #include <kodi/addon-instance/PVR.h>
 #include <kodi/Filesystem.h>
@@ -66,10 +70,10 @@ public:
 
   // Internal functions
   //@{
-  bool GetChannel(const kodi::addon::PVRChannel& channel, tvlink::data::Channel& myChannel);
+  std::shared_ptr<const tvlink::data::Channel> GetChannel(const kodi::addon::PVRChannel& channel);
 
   // For catchup
-  bool GetChannel(unsigned int uniqueChannelId, tvlink::data::Channel& myChannel);
+  std::shared_ptr<const tvlink::data::Channel> GetChannel(unsigned int uniqueChannelId);
   tvlink::CatchupController& GetCatchupController() { return m_catchupController; }
   //@}
 
@@ -78,28 +82,67 @@ public:
   void CloseLiveStream() override;
   int ReadLiveStream(unsigned char *pBuffer, unsigned int iBufferSize) override;
   bool CanPauseStream() override;
+  bool CanSeekStream() override;
+  int64_t SeekLiveStream(int64_t position, int whence) override;
+  int64_t LengthLiveStream() override;
+  PVR_ERROR GetStreamTimes(kodi::addon::PVRStreamTimes& times) override;
 
 protected:
-  void Process();
+  void Process(bool initialLoad);
 
 private:
-  static const int PROCESS_LOOP_WAIT_SECS = 2;
+  std::shared_ptr<const tvlink::DataGeneration> GetGeneration() const;
+  void PublishGeneration(const std::shared_ptr<const tvlink::DataGeneration>& generation);
+  void LoadChannelsGroupsAndEPG(bool triggerUpdates, const tvlink::utilities::CancellationToken& token);
+  void LoadLastKnownChannels();
+  void LoadEPG(const tvlink::utilities::CancellationToken& token);
+  tvlink::utilities::CancellationToken GetLoadCancellation();
+  tvlink::utilities::CancellationToken RenewLoadCancellation();
+  void TriggerEpgUpdates(const tvlink::DataGeneration& generation);
+  void ScheduleRefreshes();
+  void ScheduleEpgRefresh();
+  void ScheduleCacheRevalidation();
+  void RevalidateCaches();
+  bool OpenStreamSource(const std::string& streamUrl, size_t readAheadBytes, size_t prefillBytes);
+  void PrewarmZapCandidates(const tvlink::DataGeneration& generation, const tvlink::data::Channel& channel);
+  std::vector<std::shared_ptr<const tvlink::data::Channel>> GetZapCandidates(const tvlink::DataGeneration& generation, const tvlink::data::Channel& channel) const;
+
+  static constexpr int SETTINGS_CHANGE_DELAY_SECS = 1;
+  static constexpr int EPG_REFRESH_INTERVAL_SECS = 12 * 60 * 60;
+  static constexpr int EPG_WINDOW_MARGIN_SECS = 24 * 60 * 60;
+  static constexpr int CACHE_REVALIDATION_INTERVAL_SECS = 30 * 60;
+  static constexpr int CACHE_EVICTION_INTERVAL_SECS = 60 * 60;
+  static constexpr int STREAM_ENTRY_MAX_IDLE_SECS = 24 * 60 * 60;
+  static constexpr int MAX_REFRESH_JITTER_SECS = 5 * 60;
+  static constexpr int TASK_POOL_THREADS = 4;
+  static constexpr int STREAM_PROBE_CONCURRENCY = 2;
+  static constexpr int STREAM_PREWARM_CONCURRENCY = 1;
+  static constexpr int STREAM_STATS_INTERVAL_SECS = 60;
   unsigned int iCurl_flags;
   int iConnect_timeout;
 
-  tvlink::data::Channel m_currentChannel;
-  tvlink::Channels m_channels;
-  tvlink::ChannelGroups m_channelGroups{m_channels};
-  tvlink::PlaylistLoader m_playlistLoader{this, m_channels, m_channelGroups};
-  tvlink::Epg m_epg{this, m_channels};
-  tvlink::CatchupController m_catchupController{m_epg, &m_mutex};
+  tvlink::CatchupController m_catchupController;
+
+  // Only ever accessed through GetGeneration() and PublishGeneration()
+  std::shared_ptr<const tvlink::DataGeneration> m_generation;
+  unsigned int m_generationVersion = 0;
+  std::atomic<int> m_epgMaxPastDays{0};
+  std::atomic<int> m_epgMaxFutureDays{0};
+  std::atomic<time_t> m_epgWindowStart{0};
+  std::atomic<time_t> m_epgWindowEnd{0};
 
   std::string strCurl_buff;
-  std::atomic<bool> m_running{false};
-  std::thread m_thread;
+  tvlink::RefreshScheduler m_scheduler;
+  tvlink::utilities::TaskPool m_taskPool{TASK_POOL_THREADS};
+  tvlink::utilities::CancellationToken m_cancellation;
+  tvlink::utilities::CancellationToken m_loadCancellation;
+  std::mutex m_loadCancellationMutex;
   std::mutex m_mutex;
-  std::atomic_bool m_reloadChannelsGroupsAndEPG{false};
-  kodi::vfs::CFile m_streamHandle;
+  tvlink::LiveStream m_liveStream;
+  tvlink::StreamPrewarmer m_streamPrewarmer;
+  tvlink::StreamSources m_streamSources;
+  int m_currentChannelUid = 0; // only touched by the live stream calls, which Kodi makes one at a time
+  int m_recentChannelUid = 0;
   std::string ch_url;
   std::string ch_name;
 };
@@ -10,69 +10,38 @@
 
 #include <string>
 
+#include "CatchupSession.h"
 #include "data/Channel.h"
 #include "data/EpgEntry.h"
-#include "utilities/StreamUtils.h"
 #include "StreamManager.h"
-
-#include <mutex>
-
-#include <kodi/addon-instance/pvr/EPG.h>
+#include "StreamProber.h"
 
 namespace tvlink
 {
   class Epg;
 
+  // Services shared by all playback requests. Holds no per playback state, which
+  // lives in the CatchupSession each request creates, so it is safe to use from
+  // concurrent calls; the stream type cache does its own locking.
   class CatchupController
   {
   public:
-    CatchupController(tvlink::Epg& epg, std::mutex* mutex);
+    CatchupSession CreateSession(const tvlink::Epg& epg, const data::Channel& channel);
 
-    void ProcessChannelForPlayback(const data::Channel& channel, std::map<std::string, std::string>& catchupProperties);
-    void ProcessEPGTagForTimeshiftedPlayback(const kodi::addon::PVREPGTag& epgTag, const data::Channel& channel, std::map<std::string, std::string>& catchupProperties);
-    void ProcessEPGTagForVideoPlayback(const kodi::addon::PVREPGTag& epgTag, const data::Channel& channel, std::map<std::string, std::string>& catchupProperties);
+    static std::string ProcessStreamUrl(const data::Channel& channel);
 
-    std::string GetCatchupUrlFormatString(const data::Channel& channel) const;
-    std::string GetCatchupUrl(const data::Channel& channel) const;
-    std::string ProcessStreamUrl(const std::string& streamUrl) const;
-
-    bool ControlsLiveStream() const { return m_controlsLiveStream; }
-    void ResetCatchupState() { m_resetCatchupState = true; }
-    data::EpgEntry* GetEPGEntry(const tvlink::data::Channel& myChannel, time_t lookupTime);
+    int EvictStreamEntries(time_t maxIdleSecs) { return m_streamManager.EvictStaleEntries(maxIdleSecs); }
+    bool LoadStreamEntries() { return m_streamManager.LoadEntries(); }
+    bool SaveStreamEntries() { return m_streamManager.SaveEntries(); }
+    int GetStreamBitrate(const data::Channel& channel) { return m_streamManager.GetStreamBitrate(StreamManager::GetStreamKey(channel)); }
+    void SetStreamBitrate(const data::Channel& channel, int bitrateKbps) { m_streamManager.SetStreamBitrate(StreamManager::GetStreamKey(channel), bitrateKbps); }
+    int ProbeStreams(const tvlink::Channels& channels, utilities::TaskPool& taskPool, const utilities::CancellationToken& token)
+    {
+      return m_streamProber.ProbeChannels(channels, taskPool, token);
+    }
 
   private:
-    data::EpgEntry* GetLiveEPGEntry(const tvlink::data::Channel& myChannel);
-    void SetCatchupInputStreamProperties(bool playbackAsLive, const tvlink::data::Channel& channel, std::map<std::string, std::string>& catchupProperties, const StreamType& streamType);
-    StreamType StreamTypeLookup(const data::Channel& channel, bool fromEpg = false);
-    std::string GetStreamTestUrl(const data::Channel& channel, bool fromEpg) const;
-    std::string GetStreamKey(const data::Channel& channel, bool fromEpg) const;
-
-    // Programme helpers
-    void UpdateProgrammeFrom(const kodi::addon::PVREPGTag& epgTag, int tvgShift);
-    void UpdateProgrammeFrom(const data::EpgEntry& epgEntry, int tvgShift);
-    void ClearProgramme();
-
-    // State of current stream
-    time_t m_catchupStartTime = 0;
-    time_t m_catchupEndTime = 0;
-    time_t m_timeshiftBufferStartTime = 0;
-    long long m_timeshiftBufferOffset = 0;
-    bool m_resetCatchupState = false;
-    bool m_playbackIsVideo = false;
-    bool m_fromEpgTag = false;
-
-    // Current programme details
-    time_t m_programmeStartTime = 0;
-    time_t m_programmeEndTime = 0;
-    std::string m_programmeTitle;
-    unsigned int m_programmeUniqueChannelId = 0;
-    int m_programmeChannelTvgShift = 0;
-    std::string m_programmeCatchupId;
-
-    bool m_controlsLiveStream = false;
-    tvlink::Epg& m_epg;
-    std::mutex* m_mutex = nullptr;
-
     StreamManager m_streamManager;
+    StreamProber m_streamProber{m_streamManager};
   };
 } //namespace tvlink
@@ -0,0 +1,357 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "CatchupSession.h"
+
+#include "CatchupController.h"
+#include "Epg.h"
+#include "Settings.h"
+#include "StreamManager.h"
+#include "utilities/Logger.h"
+#include "utilities/WebUtils.h"
+
+#include <kodi/tools/StringUtils.h>
+
+using namespace kodi::tools;
+using namespace tvlink;
+using namespace tvlink::data;
+using namespace tvlink::utilities;
+
+CatchupSession::CatchupSession(const Epg& epg, const Channel& channel, StreamManager& streamManager)
+  : m_epg(epg), m_channel(channel), m_streamManager(streamManager)
+{
+}
+
+void CatchupSession::ProcessChannelForPlayback(std::map<std::string, std::string>& catchupProperties)
+{
+  m_timezoneShiftSecs = m_epg.GetEPGTimezoneShiftSecs(m_channel);
+  StreamType streamType = StreamTypeLookup();
+
+  // Anything from here is live!
+  m_playbackIsVideo = false; // TODO: possible time jitter on UI as this will effect get stream times
+
+  if (!m_fromEpgTag || m_controlsLiveStream)
+  {
+    const EpgEntry* liveEpgEntry = m_epg.GetLiveEPGEntry(m_channel);
+    if (m_controlsLiveStream && liveEpgEntry && !Settings::GetInstance().CatchupOnlyOnFinishedProgrammes())
+    {
+      // Live timeshifting support with EPG entry
+      UpdateProgrammeFrom(*liveEpgEntry, m_channel.GetTvgShift());
+      m_catchupStartTime = liveEpgEntry->GetStartTime();
+      m_catchupEndTime = liveEpgEntry->GetEndTime();
+    }
+    else if (m_controlsLiveStream || !m_channel.IsCatchupSupported() ||
+             (!m_controlsLiveStream && m_channel.IsCatchupSupported()))
+    {
+      ClearProgramme();
+      m_programmeCatchupId.clear();
+      m_catchupStartTime = 0;
+      m_catchupEndTime = 0;
+    }
+    m_fromEpgTag = false;
+  }
+
+  if (m_controlsLiveStream)
+  {
+    if (m_resetCatchupState)
+    {
+      m_resetCatchupState = false;
+      m_programmeCatchupId.clear();
+      if (m_channel.IsCatchupSupported())
+      {
+        m_timeshiftBufferOffset = Settings::GetInstance().GetCatchupDaysInSeconds(); //offset from now to start of catchup window
+        m_timeshiftBufferStartTime = std::time(nullptr) - Settings::GetInstance().GetCatchupDaysInSeconds(); // now - the window size
+      }
+      else
+      {
+        m_timeshiftBufferOffset = 0;
+        m_timeshiftBufferStartTime = 0;
+      }
+    }
+    else
+    {
+      const EpgEntry* currentEpgEntry = m_epg.GetEPGEntry(m_channel, m_timeshiftBufferStartTime + m_timeshiftBufferOffset);
+      if (currentEpgEntry)
+        UpdateProgrammeFrom(*currentEpgEntry, m_channel.GetTvgShift());
+    }
+
+    m_catchupStartTime = m_timeshiftBufferStartTime;
+
+    // TODO: Need a method of updating an inputstream if already running such as web call to stream etc.
+    // this will avoid inputstream restarts which are expensive, may be better placed in client.cpp
+    // this also mean knowing when a stream has stopped
+    SetCatchupInputStreamProperties(true, catchupProperties, streamType);
+  }
+}
+
+void CatchupSession::ProcessEPGTagForTimeshiftedPlayback(const kodi::addon::PVREPGTag& epgTag, std::map<std::string, std::string>& catchupProperties)
+{
+  m_timezoneShiftSecs = m_epg.GetEPGTimezoneShiftSecs(m_channel);
+  m_programmeCatchupId.clear();
+  const EpgEntry* epgEntry = m_epg.GetEPGEntry(m_channel, epgTag.GetStartTime());
+  if (epgEntry)
+    m_programmeCatchupId = epgEntry->GetCatchupId();
+
+  StreamType streamType = StreamTypeLookup(true);
+
+  if (m_controlsLiveStream)
+  {
+    UpdateProgrammeFrom(epgTag, m_channel.GetTvgShift());
+    m_catchupStartTime = epgTag.GetStartTime();
+    m_catchupEndTime = epgTag.GetEndTime();
+
+    time_t timeNow = time(0);
+    time_t programmeOffset = timeNow - m_catchupStartTime;
+    time_t timeshiftBufferDuration = std::max(programmeOffset, Settings::GetInstance().GetCatchupDaysInSeconds());
+    m_timeshiftBufferStartTime = timeNow - timeshiftBufferDuration;
+    m_catchupStartTime = m_timeshiftBufferStartTime;
+    m_catchupEndTime = timeNow;
+    m_timeshiftBufferOffset = timeshiftBufferDuration - programmeOffset;
+
+    m_resetCatchupState = false;
+
+    // TODO: Need a method of updating an inputstream if already running such as web call to stream etc.
+    // this will avoid inputstream restarts which are expensive, may be better placed in client.cpp
+    // this also mean knowing when a stream has stopped
+    SetCatchupInputStreamProperties(true, catchupProperties, streamType);
+  }
+  else
+  {
+    UpdateProgrammeFrom(epgTag, m_channel.GetTvgShift());
+    m_catchupStartTime = epgTag.GetStartTime();
+    m_catchupEndTime = epgTag.GetEndTime();
+
+    m_timeshiftBufferStartTime = 0;
+    m_timeshiftBufferOffset = 0;
+
+    m_fromEpgTag = true;
+  }
+}
+
+void CatchupSession::ProcessEPGTagForVideoPlayback(const kodi::addon::PVREPGTag& epgTag, std::map<std::string, std::string>& catchupProperties)
+{
+  m_timezoneShiftSecs = m_epg.GetEPGTimezoneShiftSecs(m_channel);
+  m_programmeCatchupId.clear();
+  const EpgEntry* epgEntry = m_epg.GetEPGEntry(m_channel, epgTag.GetStartTime());
+  if (epgEntry)
+    m_programmeCatchupId = epgEntry->GetCatchupId();
+
+  StreamType streamType = StreamTypeLookup(true);
+
+  if (m_controlsLiveStream)
+  {
+    if (m_resetCatchupState)
+    {
+      UpdateProgrammeFrom(epgTag, m_channel.GetTvgShift());
+      m_catchupStartTime = epgTag.GetStartTime();
+      m_catchupEndTime = epgTag.GetEndTime();
+
+      const time_t beginBuffer = Settings::GetInstance().GetCatchupWatchEpgBeginBufferSecs();
+      const time_t endBuffer = Settings::GetInstance().GetCatchupWatchEpgEndBufferSecs();
+      m_timeshiftBufferStartTime = m_catchupStartTime - beginBuffer;
+      m_catchupStartTime = m_timeshiftBufferStartTime;
+      m_catchupEndTime += endBuffer;
+      m_timeshiftBufferOffset = beginBuffer;
+
+      m_resetCatchupState = false;
+    }
+
+    // TODO: Need a method of updating an inputstream if already running such as web call to stream etc.
+    // this will avoid inputstream restarts which are expensive, may be better placed in client.cpp
+    // this also mean knowing when a stream has stopped
+    SetCatchupInputStreamProperties(false, catchupProperties, streamType);
+  }
+  else
+  {
+    UpdateProgrammeFrom(epgTag, m_channel.GetTvgShift());
+    m_catchupStartTime = epgTag.GetStartTime();
+    m_catchupEndTime = epgTag.GetEndTime();
+
+    m_timeshiftBufferStartTime = 0;
+    m_timeshiftBufferOffset = 0;
+    m_catchupStartTime = m_catchupStartTime - Settings::GetInstance().GetCatchupWatchEpgBeginBufferSecs();
+    m_catchupEndTime += Settings::GetInstance().GetCatchupWatchEpgEndBufferSecs();
+  }
+
+  if (m_catchupStartTime > 0)
+    m_playbackIsVideo = true;
+}
+
+void CatchupSession::SetCatchupInputStreamProperties(bool playbackAsLive, std::map<std::string, std::string>& catchupProperties, const StreamType& streamType)
+{
+  catchupProperties.insert({PVR_STREAM_PROPERTY_EPGPLAYBACKASLIVE, playbackAsLive ? "true" : "false"});
+
+  catchupProperties.insert({"inputstream.ffmpegdirect.is_realtime_stream",
+  	StringUtils::EqualsNoCase(m_channel.GetProperty(PVR_STREAM_PROPERTY_ISREALTIMESTREAM), "true") ? "true" : "false"});
+  catchupProperties.insert({"inputstream.ffmpegdirect.stream_mode", "catchup"});
+
+  std::string orgUrl = m_channel.GetStreamURL();
+  std::string catchupUrl = orgUrl + "?utc={utc}&lutc={lutc}";
+  catchupProperties.insert({"inputstream.ffmpegdirect.default_url", orgUrl});
+  catchupProperties.insert({"inputstream.ffmpegdirect.playback_as_live", playbackAsLive ? "true" : "false"});
+  catchupProperties.insert({"inputstream.ffmpegdirect.catchup_url_format_string", catchupUrl});
+  catchupProperties.insert({"inputstream.ffmpegdirect.catchup_buffer_start_time", std::to_string(m_catchupStartTime)});
+  catchupProperties.insert({"inputstream.ffmpegdirect.catchup_buffer_end_time", std::to_string(m_catchupEndTime)});
+  catchupProperties.insert({"inputstream.ffmpegdirect.catchup_buffer_offset", std::to_string(m_timeshiftBufferOffset)});
+  catchupProperties.insert({"inputstream.ffmpegdirect.timezone_shift", std::to_string(m_timezoneShiftSecs + m_channel.GetCatchupCorrectionSecs())});
+  if (!m_programmeCatchupId.empty())
+    catchupProperties.insert({"inputstream.ffmpegdirect.programme_catchup_id", m_programmeCatchupId});
+  catchupProperties.insert({"inputstream.ffmpegdirect.catchup_terminates", m_channel.CatchupSourceTerminates() ? "true" : "false"});
+  catchupProperties.insert({"inputstream.ffmpegdirect.catchup_granularity", std::to_string(m_channel.GetCatchupGranularitySeconds())});
+
+  // TODO: Should also send programme start and duration potentially
+  // When doing this don't forget to add Settings::GetInstance().GetCatchupWatchEpgBeginBufferSecs() + Settings::GetInstance().GetCatchupWatchEpgEndBufferSecs();
+  // if in video playback mode from epg, i.e. if (!Settings::GetInstance().CatchupPlayEpgAsLive() && m_playbackIsVideo)s
+
+  Logger::Log(LEVEL_DEBUG, "default_url - %s", WebUtils::RedactUrl(m_channel.GetStreamURL()).c_str());
+  Logger::Log(LEVEL_DEBUG, "playback_as_live - %s", playbackAsLive ? "true" : "false");
+  Logger::Log(LEVEL_DEBUG, "catchup_url_format_string - %s", WebUtils::RedactUrl(GetCatchupUrlFormatString()).c_str());
+  Logger::Log(LEVEL_DEBUG, "catchup_buffer_start_time - %s", std::to_string(m_catchupStartTime).c_str());
+  Logger::Log(LEVEL_DEBUG, "catchup_buffer_end_time - %s", std::to_string(m_catchupEndTime).c_str());
+  Logger::Log(LEVEL_DEBUG, "catchup_buffer_offset - %s", std::to_string(m_timeshiftBufferOffset).c_str());
+  Logger::Log(LEVEL_DEBUG, "timezone_shift - %s", std::to_string(m_timezoneShiftSecs + m_channel.GetCatchupCorrectionSecs()).c_str());
+  Logger::Log(LEVEL_DEBUG, "programme_catchup_id - '%s'", m_programmeCatchupId.c_str());
+  Logger::Log(LEVEL_DEBUG, "catchup_terminates - %s", m_channel.CatchupSourceTerminates() ? "true" : "false");
+  Logger::Log(LEVEL_DEBUG, "catchup_granularity - %s", std::to_string(m_channel.GetCatchupGranularitySeconds()).c_str());
+  Logger::Log(LEVEL_DEBUG, "mimetype - '%s'", m_channel.HasMimeType() ? m_channel.GetProperty("mimetype").c_str() : StreamUtils::GetMimeType(streamType).c_str());
+}
+
+StreamType CatchupSession::StreamTypeLookup(bool fromEpg /* false */)
+{
+  m_streamType = m_streamManager.StreamTypeLookup(m_channel, GetStreamTestUrl(fromEpg), GetStreamKey(fromEpg));
+
+  m_controlsLiveStream = StreamUtils::GetEffectiveInputStreamName(m_streamType, m_channel) == "inputstream.ffmpegdirect" && m_channel.CatchupSupportsTimeshifting();
+
+  return m_streamType;
+}
+
+void CatchupSession::UpdateProgrammeFrom(const kodi::addon::PVREPGTag& epgTag, int tvgShift)
+{
+  m_programmeStartTime = epgTag.GetStartTime();
+  m_programmeEndTime = epgTag.GetEndTime();
+  m_programmeTitle = epgTag.GetTitle();
+  m_programmeUniqueChannelId = epgTag.GetUniqueChannelId();
+  m_programmeChannelTvgShift = tvgShift;
+}
+
+void CatchupSession::UpdateProgrammeFrom(const data::EpgEntry& epgEntry, int tvgShift)
+{
+  m_programmeStartTime = epgEntry.GetStartTime();
+  m_programmeEndTime = epgEntry.GetEndTime();
+  m_programmeTitle = epgEntry.GetTitle();
+  m_programmeUniqueChannelId = epgEntry.GetChannelId();
+  m_programmeChannelTvgShift = tvgShift;
+}
+
+void CatchupSession::ClearProgramme()
+{
+  m_programmeStartTime = 0;
+  m_programmeEndTime = 0;
+  m_programmeTitle.clear();
+  m_programmeUniqueChannelId = 0;
+  m_programmeChannelTvgShift = 0;
+}
+
+namespace
+{
+
+std::string AppendQueryStringAndPreserveOptions(const std::string &url, const std::string &postfixQueryString)
+{
+  std::string urlFormatString;
+  if (!postfixQueryString.empty())
+  {
+    // preserve any kodi protocol options after "|"
+    size_t found = url.find_first_of('|');
+    if (found != std::string::npos)
+      urlFormatString = url.substr(0, found) + postfixQueryString + url.substr(found, url.length());
+    else
+      urlFormatString = url + postfixQueryString;
+  }
+  else
+  {
+    urlFormatString = url;
+  }
+
+  return urlFormatString;
+}
+
+std::string BuildEpgTagUrl(time_t startTime, time_t duration, const Channel& channel, const UrlTemplate& catchupSource, long long timeOffset, const std::string& programmeCatchupId, int timezoneShiftSecs)
+{
+  std::string startTimeUrl;
+  time_t timeNow = std::time(nullptr);
+  time_t offset = startTime + timeOffset;
+
+  if ((startTime > 0 && offset < (timeNow - 5)) || (channel.IgnoreCatchupDays() && !programmeCatchupId.empty()))
+    startTimeUrl = catchupSource.Render(offset - timezoneShiftSecs, duration, timeNow, programmeCatchupId);
+  else
+    startTimeUrl = channel.GetStreamURLTemplate().Render(0, 0, timeNow, programmeCatchupId);
+
+  Logger::Log(LEVEL_DEBUG, "%s - %s", __FUNCTION__, WebUtils::RedactUrl(startTimeUrl).c_str());
+
+  return startTimeUrl;
+}
+
+} // unnamed namespace
+
+std::string CatchupSession::GetCatchupUrlFormatString() const
+{
+  if (m_catchupStartTime > 0)
+    return m_channel.GetCatchupSource();
+
+  return "";
+}
+
+std::string CatchupSession::GetCatchupUrl() const
+{
+  return GetCatchupUrl(m_channel.GetCatchupSourceTemplate());
+}
+
+std::string CatchupSession::GetCatchupUrl(const UrlTemplate& catchupSource) const
+{
+  if (m_catchupStartTime > 0)
+  {
+    time_t duration = 60 * 60; // default one hour
+
+    // use the programme duration if it's valid
+    if (m_programmeStartTime > 0 && m_programmeStartTime < m_programmeEndTime)
+    {
+      duration = static_cast<time_t>(m_programmeEndTime - m_programmeStartTime);
+
+      if (!Settings::GetInstance().CatchupPlayEpgAsLive() && m_playbackIsVideo)
+        duration += Settings::GetInstance().GetCatchupWatchEpgBeginBufferSecs() + Settings::GetInstance().GetCatchupWatchEpgEndBufferSecs();
+
+      time_t timeNow = time(0);
+      // cap duration to timeNow
+      if (m_programmeStartTime + duration > timeNow)
+        duration = timeNow - m_programmeStartTime;
+    }
+
+    return BuildEpgTagUrl(m_catchupStartTime, duration, m_channel, catchupSource, m_timeshiftBufferOffset, m_programmeCatchupId, m_timezoneShiftSecs + m_channel.GetCatchupCorrectionSecs());
+  }
+
+  return "";
+}
+
+std::string CatchupSession::GetStreamTestUrl(bool fromEpg) const
+{
+ if (m_catchupStartTime > 0 || fromEpg)
+    // Test URL from 2 hours ago for 1 hour duration.
+    return BuildEpgTagUrl(std::time(nullptr) - (2 * 60 * 60), 60 * 60, m_channel, m_channel.GetCatchupSourceTemplate(), 0, m_programmeCatchupId, m_timezoneShiftSecs + m_channel.GetCatchupCorrectionSecs());
+  else
+    return CatchupController::ProcessStreamUrl(m_channel);
+}
+
+std::string CatchupSession::GetStreamKey(bool fromEpg) const
+{
+  // The streamKey is simply the channelId + StreamUrl or the catchup source
+  // Either can be used to uniquely identify the StreamType/MimeType pairing
+  if ((m_catchupStartTime > 0 || fromEpg) && m_timeshiftBufferOffset < (std::time(nullptr) - 5))
+    std::to_string(m_channel.GetUniqueId()) + "-" + m_channel.GetCatchupSource();
+
+  return StreamManager::GetStreamKey(m_channel);
+}
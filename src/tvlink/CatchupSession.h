@@ -0,0 +1,83 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "data/Channel.h"
+#include "data/EpgEntry.h"
+#include "utilities/StreamUtils.h"
+#include "utilities/UrlTemplate.h"
+
+#include <ctime>
+#include <map>
+#include <string>
+
+#include <kodi/addon-instance/pvr/EPG.h>
+
+namespace tvlink
+{
+  class Epg;
+  class StreamManager;
+
+  // Catchup state for a single playback request. A session is created per call
+  // from the channel and EPG of the generation the caller holds, so concurrent
+  // requests never share state and need no locking. The generation must outlive
+  // the session.
+  class CatchupSession
+  {
+  public:
+    CatchupSession(const tvlink::Epg& epg, const data::Channel& channel, StreamManager& streamManager);
+
+    void ProcessChannelForPlayback(std::map<std::string, std::string>& catchupProperties);
+    void ProcessEPGTagForTimeshiftedPlayback(const kodi::addon::PVREPGTag& epgTag, std::map<std::string, std::string>& catchupProperties);
+    void ProcessEPGTagForVideoPlayback(const kodi::addon::PVREPGTag& epgTag, std::map<std::string, std::string>& catchupProperties);
+
+    std::string GetCatchupUrlFormatString() const;
+    std::string GetCatchupUrl() const;
+    std::string GetCatchupUrl(const utilities::UrlTemplate& catchupSource) const;
+
+    bool ControlsLiveStream() const { return m_controlsLiveStream; }
+    const StreamType& GetStreamType() const { return m_streamType; }
+
+  private:
+    void SetCatchupInputStreamProperties(bool playbackAsLive, std::map<std::string, std::string>& catchupProperties, const StreamType& streamType);
+    StreamType StreamTypeLookup(bool fromEpg = false);
+    std::string GetStreamTestUrl(bool fromEpg) const;
+    std::string GetStreamKey(bool fromEpg) const;
+
+    // Programme helpers
+    void UpdateProgrammeFrom(const kodi::addon::PVREPGTag& epgTag, int tvgShift);
+    void UpdateProgrammeFrom(const data::EpgEntry& epgEntry, int tvgShift);
+    void ClearProgramme();
+
+    const tvlink::Epg& m_epg;
+    const data::Channel& m_channel;
+    StreamManager& m_streamManager;
+
+    // State of current stream, a new session always starts from a reset state
+    time_t m_catchupStartTime = 0;
+    time_t m_catchupEndTime = 0;
+    time_t m_timeshiftBufferStartTime = 0;
+    long long m_timeshiftBufferOffset = 0;
+    bool m_resetCatchupState = true;
+    bool m_playbackIsVideo = false;
+    bool m_fromEpgTag = false;
+    int m_timezoneShiftSecs = 0;
+
+    // Current programme details
+    time_t m_programmeStartTime = 0;
+    time_t m_programmeEndTime = 0;
+    std::string m_programmeTitle;
+    unsigned int m_programmeUniqueChannelId = 0;
+    int m_programmeChannelTvgShift = 0;
+    std::string m_programmeCatchupId;
+
+    bool m_controlsLiveStream = false;
+    StreamType m_streamType = StreamType::OTHER_TYPE;
+  };
+} //namespace tvlink
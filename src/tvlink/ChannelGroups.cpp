@@ -18,6 +18,11 @@ using namespace tvlink::utilities;
 
 ChannelGroups::ChannelGroups(const Channels& channels) : m_channels(channels) {}
 
+ChannelGroups::ChannelGroups(const Channels& channels, const ChannelGroups& channelGroups)
+  : m_channels(channels),
+    m_channelGroups(channelGroups.m_channelGroups),
+    m_channelGroupsLoadFailed(channelGroups.m_channelGroupsLoadFailed) {}
+
 bool ChannelGroups::Init()
 {
   Clear();
@@ -61,7 +66,7 @@ PVR_ERROR ChannelGroups::GetChannelGroups(kodi::addon::PVRChannelGroupsResultSet
   return PVR_ERROR_NO_ERROR;
 }
 
-PVR_ERROR ChannelGroups::GetChannelGroupMembers(const kodi::addon::PVRChannelGroup& group, kodi::addon::PVRChannelGroupMembersResultSet& results)
+PVR_ERROR ChannelGroups::GetChannelGroupMembers(const kodi::addon::PVRChannelGroup& group, kodi::addon::PVRChannelGroupMembersResultSet& results) const
 {
   const ChannelGroup* myGroup = FindChannelGroup(group.GetGroupName());
   if (myGroup)
@@ -79,7 +84,7 @@ PVR_ERROR ChannelGroups::GetChannelGroupMembers(const kodi::addon::PVRChannelGro
       if (memberId < 0 || memberId >= static_cast<int>(m_channels.GetChannelsAmount()))
         continue;
 
-      const Channel& channel = m_channels.GetChannelsList().at(memberId);
+      const Channel& channel = *m_channels.GetChannelsList().at(memberId);
       kodi::addon::PVRChannelGroupMember kodiGroupMember;
 
       kodiGroupMember.SetGroupName(group.GetGroupName());
@@ -129,6 +134,19 @@ int ChannelGroups::AddChannelGroup(tvlink::data::ChannelGroup& channelGroup)
   return existingChannelGroup->GetUniqueId();
 }
 
+bool ChannelGroups::AddSnapshotChannelGroup(const ChannelGroup& channelGroup)
+{
+  for (int channelIndex : channelGroup.GetMemberChannelIndexes())
+  {
+    if (channelIndex < 0 || channelIndex >= static_cast<int>(m_channels.GetChannelsList().size()))
+      return false;
+  }
+
+  m_channelGroups.emplace_back(channelGroup);
+
+  return true;
+}
+
 ChannelGroup* ChannelGroups::GetChannelGroup(int uniqueId)
 {
   for (auto& myChannelGroup : m_channelGroups)
@@ -150,3 +168,14 @@ ChannelGroup* ChannelGroups::FindChannelGroup(const std::string& name)
 
   return nullptr;
 }
+
+const ChannelGroup* ChannelGroups::FindChannelGroup(const std::string& name) const
+{
+  for (const auto& myGroup : m_channelGroups)
+  {
+    if (myGroup.GetGroupName() == name)
+      return &myGroup;
+  }
+
+  return nullptr;
+}
@@ -22,14 +22,17 @@ namespace tvlink
   {
   public:
     ChannelGroups(const tvlink::Channels& channels);
+    ChannelGroups(const tvlink::Channels& channels, const ChannelGroups& channelGroups);
 
     int GetChannelGroupsAmount() const;
     PVR_ERROR GetChannelGroups(kodi::addon::PVRChannelGroupsResultSet& results, bool radio) const;
-    PVR_ERROR GetChannelGroupMembers(const kodi::addon::PVRChannelGroup& group, kodi::addon::PVRChannelGroupMembersResultSet& results);
+    PVR_ERROR GetChannelGroupMembers(const kodi::addon::PVRChannelGroup& group, kodi::addon::PVRChannelGroupMembersResultSet& results) const;
 
     int AddChannelGroup(tvlink::data::ChannelGroup& channelGroup);
+    bool AddSnapshotChannelGroup(const tvlink::data::ChannelGroup& channelGroup);
     tvlink::data::ChannelGroup* GetChannelGroup(int uniqueId);
     tvlink::data::ChannelGroup* FindChannelGroup(const std::string& name);
+    const tvlink::data::ChannelGroup* FindChannelGroup(const std::string& name) const;
     const std::vector<data::ChannelGroup>& GetChannelGroupsList() const { return m_channelGroups; }
     bool Init();
     void Clear();
@@ -11,9 +11,10 @@
 #include "ChannelGroups.h"
 #include "Settings.h"
 #include "utilities/FileUtils.h"
+#include "utilities/HashUtils.h"
 #include "utilities/Logger.h"
 
-#include <regex>
+#include <algorithm>
 
 #include <kodi/tools/StringUtils.h>
 
@@ -31,6 +32,9 @@ bool Channels::Init()
 void Channels::Clear()
 {
   m_channels.clear();
+  m_channelIndexesByUniqueId.clear();
+  m_tvChannelIndexes.clear();
+  m_radioChannelIndexes.clear();
   m_channelsLoadFailed = false;
   m_currentChannelNumber = Settings::GetInstance().GetStartChannelNumber();
 }
@@ -49,19 +53,18 @@ PVR_ERROR Channels::GetChannels(kodi::addon::PVRChannelsResultSet& results, bool
   // This allows the users to use the 'Backend Order' sort option in the left to
   // have the same order as the backend (regardles of the channel numbering used)
   int channelOrder = 1;
-  for (const auto& channel : m_channels)
+  for (size_t channelIndex : radio ? m_radioChannelIndexes : m_tvChannelIndexes)
   {
-    if (channel.IsRadio() == radio)
-    {
-      Logger::Log(LEVEL_DEBUG, "%s - Transfer channel '%s', ChannelId '%d', ChannelNumber: '%d'", __FUNCTION__, channel.GetChannelName().c_str(),
-                  channel.GetUniqueId(), channel.GetChannelNumber());
-      kodi::addon::PVRChannel kodiChannel;
+    const Channel& channel = *m_channels[channelIndex];
 
-      channel.UpdateTo(kodiChannel);
-      kodiChannel.SetOrder(channelOrder++); // Keep the channels in list order as per the M3U
+    Logger::Log(LEVEL_DEBUG, "%s - Transfer channel '%s', ChannelId '%d', ChannelNumber: '%d'", __FUNCTION__, channel.GetChannelName().c_str(),
+                channel.GetUniqueId(), channel.GetChannelNumber());
+    kodi::addon::PVRChannel kodiChannel;
 
-      results.Add(kodiChannel);
-    }
+    channel.UpdateTo(kodiChannel);
+    kodiChannel.SetOrder(channelOrder++); // Keep the channels in list order as per the M3U
+
+    results.Add(kodiChannel);
   }
 
   Logger::Log(LEVEL_DEBUG, "%s - channels available '%d', radio = %d", __FUNCTION__, m_channels.size(), radio);
@@ -69,30 +72,43 @@ PVR_ERROR Channels::GetChannels(kodi::addon::PVRChannelsResultSet& results, bool
   return PVR_ERROR_NO_ERROR;
 }
 
-bool Channels::GetChannel(const kodi::addon::PVRChannel& channel, Channel& myChannel) const
+std::shared_ptr<const Channel> Channels::GetChannel(const kodi::addon::PVRChannel& channel) const
 {
-  return GetChannel(static_cast<int>(channel.GetUniqueId()), myChannel);
+  return GetChannel(static_cast<int>(channel.GetUniqueId()));
 }
 
-bool Channels::GetChannel(int uniqueId, Channel& myChannel) const
+std::shared_ptr<const Channel> Channels::GetChannel(int uniqueId) const
 {
-  for (const auto& thisChannel : m_channels)
-  {
-    if (thisChannel.GetUniqueId() == uniqueId)
-    {
-      thisChannel.UpdateTo(myChannel);
+  auto channelIndexPair = m_channelIndexesByUniqueId.find(uniqueId);
+  if (channelIndexPair != m_channelIndexesByUniqueId.end())
+    return m_channels[channelIndexPair->second];
 
-      return true;
-    }
-  }
+  return {};
+}
+
+const Channel* Channels::FindChannel(int uniqueId) const
+{
+  // Borrowed pointer for hot paths, only valid while this generation is held
+  auto channelIndexPair = m_channelIndexesByUniqueId.find(uniqueId);
+  if (channelIndexPair != m_channelIndexesByUniqueId.end())
+    return m_channels[channelIndexPair->second].get();
+
+  return nullptr;
+}
 
-  return false;
+int Channels::GetChannelIndex(int uniqueId) const
+{
+  auto channelIndexPair = m_channelIndexesByUniqueId.find(uniqueId);
+  if (channelIndexPair != m_channelIndexesByUniqueId.end())
+    return static_cast<int>(channelIndexPair->second);
+
+  return -1;
 }
 
 void Channels::AddChannel(Channel& channel, std::vector<int>& groupIdList, ChannelGroups& channelGroups)
 {
   m_currentChannelNumber = channel.GetChannelNumber();
-  channel.SetUniqueId(GenerateChannelId(channel.GetChannelName().c_str(), channel.GetStreamURL().c_str()));
+  channel.SetUniqueId(AllocateChannelId(GenerateChannelIdHash(channel.GetChannelName(), channel.GetStreamURL()), channel.GetChannelName()));
 
   for (int myGroupId : groupIdList)
   {
@@ -100,60 +116,133 @@ void Channels::AddChannel(Channel& channel, std::vector<int>& groupIdList, Chann
     channelGroups.GetChannelGroup(myGroupId)->AddMemberChannelIndex(m_channels.size());
   }
 
-  m_channels.emplace_back(channel);
+  const size_t channelIndex = m_channels.size();
+  m_channels.emplace_back(std::make_shared<const Channel>(channel));
+
+  m_channelIndexesByUniqueId.insert({channel.GetUniqueId(), channelIndex});
+  if (channel.IsRadio())
+    m_radioChannelIndexes.emplace_back(channelIndex);
+  else
+    m_tvChannelIndexes.emplace_back(channelIndex);
 
   m_currentChannelNumber++;
 }
 
-Channel* Channels::GetChannel(int uniqueId)
+bool Channels::AddSnapshotChannel(const Channel& channel)
 {
-  for (auto& myChannel : m_channels)
+  // Snapshot channels already have their unique id, group membership is restored with the groups
+  const size_t channelIndex = m_channels.size();
+  if (channel.GetUniqueId() == 0 || !m_channelIndexesByUniqueId.insert({channel.GetUniqueId(), channelIndex}).second)
+    return false;
+
+  m_channels.emplace_back(std::make_shared<const Channel>(channel));
+  if (channel.IsRadio())
+    m_radioChannelIndexes.emplace_back(channelIndex);
+  else
+    m_tvChannelIndexes.emplace_back(channelIndex);
+
+  m_currentChannelNumber = channel.GetChannelNumber() + 1;
+
+  return true;
+}
+
+bool Channels::SetChannelIconPath(int uniqueId, const std::string& iconPath)
+{
+  auto channelIndexPair = m_channelIndexesByUniqueId.find(uniqueId);
+  if (channelIndexPair == m_channelIndexesByUniqueId.end())
+    return false;
+
+  // Copy on write, anyone still holding the old channel keeps an unchanged object
+  std::shared_ptr<const Channel>& channel = m_channels[channelIndexPair->second];
+  std::shared_ptr<Channel> updatedChannel = std::make_shared<Channel>(*channel);
+  updatedChannel->SetIconPath(iconPath);
+  channel = updatedChannel;
+
+  return true;
+}
+
+bool Channels::AddAlternativeStreamURLs(int uniqueId, const Channel& duplicateChannel, const std::vector<int>& groupIdList,
+                                        ChannelGroups& channelGroups)
+{
+  auto channelIndexPair = m_channelIndexesByUniqueId.find(uniqueId);
+  if (channelIndexPair == m_channelIndexesByUniqueId.end())
+    return false;
+
+  // A channel listed again under another group-title is a member of that group too
+  const int channelIndex = static_cast<int>(channelIndexPair->second);
+  for (int myGroupId : groupIdList)
   {
-    if (myChannel.GetUniqueId() == uniqueId)
-      return &myChannel;
+    ChannelGroup* channelGroup = channelGroups.GetChannelGroup(myGroupId);
+    const std::vector<int>& memberChannelIndexes = channelGroup->GetMemberChannelIndexes();
+    if (std::find(memberChannelIndexes.begin(), memberChannelIndexes.end(), channelIndex) == memberChannelIndexes.end())
+      channelGroup->AddMemberChannelIndex(channelIndex);
   }
 
-  return nullptr;
+  // Copy on write, the same as for icon paths
+  std::shared_ptr<const Channel>& channel = m_channels[channelIndexPair->second];
+  std::shared_ptr<Channel> updatedChannel = std::make_shared<Channel>(*channel);
+  updatedChannel->AddAlternativeStreamURL(duplicateChannel.GetStreamURL());
+  for (const auto& alternativeStreamURL : duplicateChannel.GetAlternativeStreamURLs())
+    updatedChannel->AddAlternativeStreamURL(alternativeStreamURL);
+  channel = updatedChannel;
+
+  return true;
 }
 
 const Channel* Channels::FindChannel(const std::string& id, const std::string& displayName) const
 {
   for (const auto& myChannel : m_channels)
   {
-    if (StringUtils::EqualsNoCase(myChannel.GetTvgId(), id))
-      return &myChannel;
+    if (StringUtils::EqualsNoCase(myChannel->GetTvgId(), id))
+      return myChannel.get();
   }
 
   if (displayName.empty())
     return nullptr;
 
-  const std::string convertedDisplayName = std::regex_replace(displayName, std::regex(" "), "_");
+  std::string convertedDisplayName = displayName;
+  std::replace(convertedDisplayName.begin(), convertedDisplayName.end(), ' ', '_');
   for (const auto& myChannel : m_channels)
   {
-    if (StringUtils::EqualsNoCase(myChannel.GetTvgName(), convertedDisplayName) ||
-        StringUtils::EqualsNoCase(myChannel.GetTvgName(), displayName))
-      return &myChannel;
+    if (StringUtils::EqualsNoCase(myChannel->GetTvgName(), convertedDisplayName) ||
+        StringUtils::EqualsNoCase(myChannel->GetTvgName(), displayName))
+      return myChannel.get();
   }
 
   for (const auto& myChannel : m_channels)
   {
-    if (StringUtils::EqualsNoCase(myChannel.GetChannelName(), displayName))
-      return &myChannel;
+    if (StringUtils::EqualsNoCase(myChannel->GetChannelName(), displayName))
+      return myChannel.get();
   }
 
   return nullptr;
 }
 
-int Channels::GenerateChannelId(const char* channelName, const char* streamUrl)
+uint64_t Channels::GenerateChannelIdHash(const std::string& channelName, const std::string& streamUrl)
+{
+  // 64-bit FNV-1a over the channel name followed by the stream URL
+  return Fnv1a64(streamUrl, Fnv1a64(channelName));
+}
+
+int Channels::AllocateChannelId(uint64_t channelIdHash, const std::string& channelName) const
 {
-  std::string concat(channelName);
-  concat.append(streamUrl);
+  // Kodi unique ids are positive ints, so fold both halves of the hash into 31 bits
+  constexpr uint32_t CHANNEL_ID_MASK = 0x7FFFFFFF;
+  uint32_t channelId = static_cast<uint32_t>(channelIdHash ^ (channelIdHash >> 32)) & CHANNEL_ID_MASK;
+
+  // On a collision probe with an odd step taken from the upper bits of the hash. As channels
+  // are added in playlist order the ids stay stable from one load to the next.
+  const uint32_t probeStep = static_cast<uint32_t>(channelIdHash >> 33) | 1;
+  int probes = 0;
+  while (channelId == 0 || m_channelIndexesByUniqueId.find(static_cast<int>(channelId)) != m_channelIndexesByUniqueId.end())
+  {
+    channelId = (channelId + probeStep) & CHANNEL_ID_MASK;
+    probes++;
+  }
 
-  const char* calcString = concat.c_str();
-  int iId = 0;
-  int c;
-  while ((c = *calcString++))
-    iId = ((iId << 5) + iId) + c; /* iId * 33 + c */
+  if (probes > 0)
+    Logger::Log(LEVEL_WARNING, "%s - Channel id collision for channel '%s', resolved to ChannelId '%d' after %d probe(s)",
+                __FUNCTION__, channelName.c_str(), channelId, probes);
 
-  return abs(iId);
+  return static_cast<int>(channelId);
 }
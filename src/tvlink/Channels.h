@@ -10,7 +10,10 @@
 
 #include "data/Channel.h"
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <kodi/addon-instance/pvr/Channels.h>
@@ -33,24 +36,37 @@ namespace tvlink
 
     int GetChannelsAmount() const;
     PVR_ERROR GetChannels(kodi::addon::PVRChannelsResultSet& results, bool radio) const;
-    bool GetChannel(const kodi::addon::PVRChannel& channel, tvlink::data::Channel& myChannel) const;
-    bool GetChannel(int uniqueId, tvlink::data::Channel& myChannel) const;
+    std::shared_ptr<const tvlink::data::Channel> GetChannel(const kodi::addon::PVRChannel& channel) const;
+    std::shared_ptr<const tvlink::data::Channel> GetChannel(int uniqueId) const;
 
     void AddChannel(tvlink::data::Channel& channel, std::vector<int>& groupIdList, tvlink::ChannelGroups& channelGroups);
-    tvlink::data::Channel* GetChannel(int uniqueId);
+    bool AddSnapshotChannel(const tvlink::data::Channel& channel);
+    bool SetChannelIconPath(int uniqueId, const std::string& iconPath);
+    // The duplicate's URLs become alternatives of the channel, which also joins the duplicate's groups
+    bool AddAlternativeStreamURLs(int uniqueId, const tvlink::data::Channel& duplicateChannel, const std::vector<int>& groupIdList,
+                                  tvlink::ChannelGroups& channelGroups);
     const tvlink::data::Channel* FindChannel(const std::string& id, const std::string& displayName) const;
-    const std::vector<data::Channel>& GetChannelsList() const { return m_channels; }
+    const tvlink::data::Channel* FindChannel(int uniqueId) const;
+    int GetChannelIndex(int uniqueId) const;
+    const std::vector<std::shared_ptr<const data::Channel>>& GetChannelsList() const { return m_channels; }
     void Clear();
 
     int GetCurrentChannelNumber() const { return m_currentChannelNumber; }
     void ChannelsLoadFailed() { m_channelsLoadFailed = true; };
 
   private:
-    int GenerateChannelId(const char* channelName, const char* streamUrl);
+    static uint64_t GenerateChannelIdHash(const std::string& channelName, const std::string& streamUrl);
+    int AllocateChannelId(uint64_t channelIdHash, const std::string& channelName) const;
 
     int m_currentChannelNumber;
     bool m_channelsLoadFailed = false;
 
-    std::vector<tvlink::data::Channel> m_channels;
+    // Channels are immutable once added, lookups hand out shared handles instead of copies
+    std::vector<std::shared_ptr<const tvlink::data::Channel>> m_channels;
+
+    // Rebuilt on load so that per channel lookups do not depend on the playlist size
+    std::unordered_map<int, size_t> m_channelIndexesByUniqueId;
+    std::vector<size_t> m_tvChannelIndexes;
+    std::vector<size_t> m_radioChannelIndexes;
   };
 } //namespace tvlink
@@ -0,0 +1,173 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "ChannelsSnapshot.h"
+
+#include "Settings.h"
+#include "utilities/BinaryUtils.h"
+#include "utilities/FileUtils.h"
+#include "utilities/HashUtils.h"
+#include "utilities/Logger.h"
+
+#include <chrono>
+
+#include <kodi/Filesystem.h>
+
+using namespace tvlink;
+using namespace tvlink::data;
+using namespace tvlink::utilities;
+
+namespace
+{
+
+const uint32_t SNAPSHOT_MAGIC = 0x534C5654; // "TVLS"
+const uint32_t SNAPSHOT_FORMAT_VERSION = 2;
+
+struct SnapshotHeader
+{
+  uint32_t magic;
+  uint32_t formatVersion;
+  uint64_t settingsFingerprint;
+  uint64_t sourceHash;
+  uint64_t payloadHash;
+};
+
+} // unnamed namespace
+
+bool ChannelsSnapshot::Save(uint64_t sourceHash, const Channels& channels, const ChannelGroups& channelGroups)
+{
+  auto started = std::chrono::high_resolution_clock::now();
+
+  std::string payload;
+  BinaryWriter writer(payload);
+
+  writer.Write(Settings::GetInstance().GetTvgUrl());
+  writer.Write(static_cast<uint32_t>(channels.GetChannelsList().size()));
+  for (const auto& channel : channels.GetChannelsList())
+    channel->WriteSnapshot(writer);
+  writer.Write(static_cast<uint32_t>(channelGroups.GetChannelGroupsList().size()));
+  for (const auto& channelGroup : channelGroups.GetChannelGroupsList())
+    channelGroup.WriteSnapshot(writer);
+
+  SnapshotHeader header = {SNAPSHOT_MAGIC, SNAPSHOT_FORMAT_VERSION, GetSettingsFingerprint(), sourceHash, Fnv1a64(payload)};
+
+  // Write to a temporary file first so a reader never sees a partial snapshot
+  const std::string snapshotPath = FileUtils::GetUserDataAddonFilePath(CHANNELS_SNAPSHOT_FILENAME);
+  const std::string tempPath = snapshotPath + ".tmp";
+
+  kodi::vfs::CFile file;
+  if (!file.OpenFileForWrite(tempPath, true))
+  {
+    Logger::Log(LEVEL_ERROR, "%s - Could not open channels snapshot for writing: %s", __FUNCTION__, tempPath.c_str());
+    return false;
+  }
+
+  bool written = file.Write(&header, sizeof(header)) == static_cast<ssize_t>(sizeof(header)) &&
+                 file.Write(payload.data(), payload.size()) == static_cast<ssize_t>(payload.size());
+  file.Close();
+
+  if (!written || !kodi::vfs::RenameFile(tempPath, snapshotPath))
+  {
+    Logger::Log(LEVEL_ERROR, "%s - Could not write channels snapshot: %s", __FUNCTION__, snapshotPath.c_str());
+    kodi::vfs::DeleteFile(tempPath);
+    return false;
+  }
+
+  int milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::high_resolution_clock::now() - started).count();
+
+  Logger::Log(LEVEL_INFO, "%s - Channels snapshot saved, %d bytes - %d (ms)", __FUNCTION__, static_cast<int>(sizeof(header) + payload.size()), milliseconds);
+
+  return true;
+}
+
+bool ChannelsSnapshot::Load(uint64_t sourceHash, Channels& channels, ChannelGroups& channelGroups)
+{
+  auto started = std::chrono::high_resolution_clock::now();
+
+  const std::string snapshotPath = FileUtils::GetUserDataAddonFilePath(CHANNELS_SNAPSHOT_FILENAME);
+  if (!FileUtils::FileExists(snapshotPath))
+    return false;
+
+  // The VFS has no memory mapping, so the whole file is read with a single call instead
+  kodi::vfs::CFile file;
+  if (!file.OpenFile(snapshotPath, ADDON_READ_NO_CACHE))
+    return false;
+
+  SnapshotHeader header;
+  const int64_t length = file.GetLength();
+  if (length < static_cast<int64_t>(sizeof(header)) ||
+      file.Read(&header, sizeof(header)) != static_cast<ssize_t>(sizeof(header)))
+    return false;
+
+  if (header.magic != SNAPSHOT_MAGIC || header.formatVersion != SNAPSHOT_FORMAT_VERSION)
+  {
+    Logger::Log(LEVEL_DEBUG, "%s - Ignoring channels snapshot with unknown format", __FUNCTION__);
+    return false;
+  }
+
+  if (header.settingsFingerprint != GetSettingsFingerprint() || (sourceHash != 0 && header.sourceHash != sourceHash))
+  {
+    Logger::Log(LEVEL_DEBUG, "%s - Channels snapshot is out of date", __FUNCTION__);
+    return false;
+  }
+
+  std::string payload(static_cast<size_t>(length) - sizeof(header), '\0');
+  if (file.Read(&payload[0], payload.size()) != static_cast<ssize_t>(payload.size()) || Fnv1a64(payload) != header.payloadHash)
+  {
+    Logger::Log(LEVEL_ERROR, "%s - Channels snapshot is corrupt: %s", __FUNCTION__, snapshotPath.c_str());
+    return false;
+  }
+  file.Close();
+
+  BinaryReader reader(payload);
+
+  std::string tvgUrl;
+  uint32_t channelCount = 0;
+  reader.Read(tvgUrl);
+  reader.Read(channelCount);
+
+  for (uint32_t i = 0; i < channelCount && reader.IsOk(); i++)
+  {
+    Channel channel;
+    if (!channel.ReadSnapshot(reader) || !channels.AddSnapshotChannel(channel))
+      return false;
+  }
+
+  uint32_t channelGroupCount = 0;
+  reader.Read(channelGroupCount);
+
+  for (uint32_t i = 0; i < channelGroupCount && reader.IsOk(); i++)
+  {
+    ChannelGroup channelGroup;
+    if (!channelGroup.ReadSnapshot(reader) || !channelGroups.AddSnapshotChannelGroup(channelGroup))
+      return false;
+  }
+
+  if (!reader.IsOk() || !reader.AtEnd())
+    return false;
+
+  Settings::GetInstance().SetTvgUrl(tvgUrl);
+
+  int milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::high_resolution_clock::now() - started).count();
+
+  Logger::Log(LEVEL_INFO, "%s - Loaded %d channels and %d groups from snapshot - %d (ms)", __FUNCTION__, channelCount, channelGroupCount, milliseconds);
+
+  return true;
+}
+
+uint64_t ChannelsSnapshot::GetSettingsFingerprint()
+{
+  // Any setting can change how the playlist is processed, so the snapshot is
+  // tied to the stored add-on settings and the add-on version as a whole
+  std::string settingsContents;
+  FileUtils::GetFileContents(FileUtils::GetUserDataAddonFilePath("settings.xml"), settingsContents);
+
+  return Fnv1a64(STR(IPTV_VERSION), Fnv1a64(settingsContents));
+}
@@ -0,0 +1,38 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "ChannelGroups.h"
+#include "Channels.h"
+
+#include <cstdint>
+#include <string>
+
+namespace tvlink
+{
+  /**
+   * A binary copy of the fully processed channels and channel groups. It is
+   * tied to the hash of the playlist it was built from and to a fingerprint of
+   * the add-on settings, so it can stand in for parsing the same playlist again.
+   */
+  class ChannelsSnapshot
+  {
+  public:
+    static bool Save(uint64_t sourceHash, const tvlink::Channels& channels, const tvlink::ChannelGroups& channelGroups);
+
+    /**
+     * Restore into empty channels and groups. A sourceHash of zero accepts a
+     * snapshot of any playlist, i.e. the last known channels.
+     */
+    static bool Load(uint64_t sourceHash, tvlink::Channels& channels, tvlink::ChannelGroups& channelGroups);
+
+  private:
+    static uint64_t GetSettingsFingerprint();
+  };
+} //namespace tvlink
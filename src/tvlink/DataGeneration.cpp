@@ -0,0 +1,144 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "DataGeneration.h"
+
+#include "ChannelsSnapshot.h"
+#include "PlaylistLoader.h"
+#include "utilities/HashUtils.h"
+#include "utilities/Logger.h"
+
+#include <chrono>
+#include <future>
+
+#include <pugixml.hpp>
+
+using namespace tvlink;
+using namespace tvlink::utilities;
+
+DataGeneration::DataGeneration(unsigned int version)
+  : m_version(version), m_channelGroups(m_channels)
+{
+  m_channels.Clear();
+  m_channelGroups.Clear();
+  m_epg.Clear();
+}
+
+DataGeneration::DataGeneration(unsigned int version, const DataGeneration& previous)
+  : DataGeneration(version, previous.m_channels, previous.m_channelGroups)
+{
+  // Only the channels and groups are carried over, the EPG is always loaded fresh
+}
+
+DataGeneration::DataGeneration(unsigned int version, const Channels& channels, const ChannelGroups& channelGroups)
+  : m_version(version), m_channels(channels), m_channelGroups(m_channels, channelGroups)
+{
+  m_epg.Clear();
+}
+
+bool DataGeneration::LoadChannels(const CancellationToken& token)
+{
+  m_channels.Init();
+  m_channelGroups.Init();
+
+  PlaylistLoader playlistLoader(m_channels, m_channelGroups, token);
+  playlistLoader.Init();
+
+  std::string playlistContent;
+  if (!playlistLoader.FetchPlayList(playlistContent))
+  {
+    m_channels.ChannelsLoadFailed();
+    m_channelGroups.ChannelGroupsLoadFailed();
+    return false;
+  }
+
+  // An unchanged playlist is restored from the snapshot instead of being parsed again
+  const uint64_t sourceHash = Fnv1a64(playlistContent);
+  if (ChannelsSnapshot::Load(sourceHash, m_channels, m_channelGroups))
+    return true;
+
+  m_channels.Init();
+  m_channelGroups.Init();
+  if (!playlistLoader.ParsePlayList(playlistContent))
+  {
+    m_channels.ChannelsLoadFailed();
+    m_channelGroups.ChannelGroupsLoadFailed();
+    return false;
+  }
+
+  ChannelsSnapshot::Save(sourceHash, m_channels, m_channelGroups);
+
+  return true;
+}
+
+bool DataGeneration::LoadChannelsFromSnapshot()
+{
+  m_channels.Init();
+  m_channelGroups.Init();
+
+  if (ChannelsSnapshot::Load(0, m_channels, m_channelGroups))
+    return true;
+
+  m_channels.Init();
+  m_channelGroups.Init();
+  return false;
+}
+
+bool DataGeneration::LoadEpg(int epgMaxPastDays, int epgMaxFutureDays, time_t start, time_t end,
+                             const CancellationToken& token)
+{
+  const bool loaded = m_epg.Init(epgMaxPastDays, epgMaxFutureDays, start, end, token);
+
+  Logger::Log(LEVEL_DEBUG, "%s - Generation %u EPG %s", __FUNCTION__, m_version, loaded ? "loaded" : "not loaded");
+
+  return loaded;
+}
+
+bool DataGeneration::LoadChannelsAndEpg(int epgMaxPastDays, int epgMaxFutureDays, time_t start, time_t end, bool& epgLoaded,
+                                        TaskPool& taskPool, const CancellationToken& token)
+{
+  auto started = std::chrono::high_resolution_clock::now();
+
+  m_epg.Configure(epgMaxPastDays, epgMaxFutureDays, token);
+  const bool loadEpg = m_epg.GetLoadInterval(start, end);
+
+  // The playlist and the XMLTV are independent until the channels are bound to
+  // the EPG, so the guide is downloaded and parsed while the playlist loads
+  std::future<std::unique_ptr<pugi::xml_document>> xmltvFetch;
+  if (loadEpg)
+    xmltvFetch = taskPool.Submit(TaskCategory::FETCH, token, [this]() { return m_epg.FetchXMLTV(); });
+
+  const bool channelsLoaded = LoadChannels(token);
+
+  int channelsMilliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+                              std::chrono::high_resolution_clock::now() - started).count();
+
+  epgLoaded = true;
+  if (loadEpg)
+  {
+    std::unique_ptr<pugi::xml_document> xmlDoc;
+    try
+    {
+      xmlDoc = xmltvFetch.get();
+    }
+    catch (const std::future_error&)
+    {
+      // The fetch was cancelled or the pool is shutting down
+      Logger::Log(LEVEL_DEBUG, "%s - XMLTV fetch for generation %u was cancelled", __FUNCTION__, m_version);
+    }
+    epgLoaded = xmlDoc && m_epg.LoadEPG(*xmlDoc, start, end);
+  }
+
+  int milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::high_resolution_clock::now() - started).count();
+
+  Logger::Log(LEVEL_INFO, "%s - Generation %u loaded - %d (ms), channels ready after %d (ms), EPG %s", __FUNCTION__,
+              m_version, milliseconds, channelsMilliseconds, loadEpg ? (epgLoaded ? "loaded" : "not loaded") : "not requested");
+
+  return channelsLoaded;
+}
@@ -0,0 +1,62 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "ChannelGroups.h"
+#include "Channels.h"
+#include "Epg.h"
+#include "utilities/TaskPool.h"
+
+#include <ctime>
+
+namespace tvlink
+{
+  /**
+   * A single version of the channels, channel groups and EPG. A generation is
+   * built by the update thread and is never modified once it has been published,
+   * so the PVR API calls can read from it without taking a lock.
+   */
+  class DataGeneration
+  {
+  public:
+    static const unsigned int PLACEHOLDER_VERSION = 0;
+
+    explicit DataGeneration(unsigned int version);
+    DataGeneration(unsigned int version, const DataGeneration& previous);
+    // Around channels and groups that were loaded elsewhere, with an empty EPG
+    DataGeneration(unsigned int version, const tvlink::Channels& channels, const tvlink::ChannelGroups& channelGroups);
+
+    DataGeneration(const DataGeneration&) = delete;
+    DataGeneration& operator=(const DataGeneration&) = delete;
+
+    bool LoadChannels(const utilities::CancellationToken& token);
+    bool LoadChannelsFromSnapshot();
+    bool LoadEpg(int epgMaxPastDays, int epgMaxFutureDays, time_t start, time_t end,
+                 const utilities::CancellationToken& token);
+    bool LoadChannelsAndEpg(int epgMaxPastDays, int epgMaxFutureDays, time_t start, time_t end, bool& epgLoaded,
+                            utilities::TaskPool& taskPool, const utilities::CancellationToken& token);
+
+    unsigned int GetVersion() const { return m_version; }
+
+    /**
+     * The empty generation published before the first load has completed.
+     */
+    bool IsPlaceholder() const { return m_version == PLACEHOLDER_VERSION; }
+    const tvlink::Channels& GetChannels() const { return m_channels; }
+    const tvlink::ChannelGroups& GetChannelGroups() const { return m_channelGroups; }
+    const tvlink::Epg& GetEpg() const { return m_epg; }
+
+  private:
+    unsigned int m_version;
+
+    tvlink::Channels m_channels;
+    tvlink::ChannelGroups m_channelGroups;
+    tvlink::Epg m_epg{m_channels};
+  };
+} //namespace tvlink
@@ -13,9 +13,9 @@
 #include "utilities/Logger.h"
 #include "utilities/XMLUtils.h"
 
+#include <algorithm>
 #include <chrono>
 #include <regex>
-#include <thread>
 
 #include <kodi/tools/StringUtils.h>
 #include <pugixml.hpp>
@@ -26,19 +26,38 @@ using namespace tvlink::data;
 using namespace tvlink::utilities;
 using namespace pugi;
 
-Epg::Epg(kodi::addon::CInstancePVRClient* client, Channels& channels)
-  : m_lastStart(0), m_lastEnd(0), m_channels(channels), m_client(client)
+Epg::Epg(Channels& channels)
+  : m_channels(channels)
 {
 }
 
-bool Epg::Init(int epgMaxPastDays, int epgMaxFutureDays)
+bool Epg::Init(int epgMaxPastDays, int epgMaxFutureDays, time_t start, time_t end,
+               const CancellationToken& token)
 {
+  Configure(epgMaxPastDays, epgMaxFutureDays, token);
+
+  if (!GetLoadInterval(start, end))
+    return true;
+
+  return LoadEPG(start, end);
+}
+
+void Epg::Configure(int epgMaxPastDays, int epgMaxFutureDays, const CancellationToken& token)
+{
+  m_cancellationToken = token;
   m_xmltvLocation = Settings::GetInstance().GetEpgLocation();
   m_epgTimeShift = Settings::GetInstance().GetEpgTimeshiftSecs();
   m_tsOverride = Settings::GetInstance().GetTsOverride();
 
   SetEPGMaxPastDays(epgMaxPastDays);
   SetEPGMaxFutureDays(epgMaxFutureDays);
+}
+
+bool Epg::GetLoadInterval(time_t& start, time_t& end) const
+{
+  // Kodi has already asked for an interval so load that one
+  if (start > 0 || end > 0)
+    return true;
 
   if (Settings::GetInstance().IsCatchupEnabled())
   {
@@ -46,16 +65,20 @@ bool Epg::Init(int epgMaxPastDays, int epgMaxFutureDays)
     // data on each startup so we need to make sure it's loaded whether or not
     // kodi considers it necessary.
     time_t now = std::time(nullptr);
-    LoadEPG(now - m_epgMaxPastDaysSeconds, now + m_epgMaxFutureDaysSeconds);
+    start = now - m_epgMaxPastDaysSeconds;
+    end = now + m_epgMaxFutureDaysSeconds;
+    return true;
   }
 
-  return true;
+  return false;
 }
 
 void Epg::Clear()
 {
   m_channelEpgs.clear();
   m_genreMappings.clear();
+  m_catchupIdRanges.clear();
+  m_channelLogosUpdated = false;
 }
 
 void Epg::SetEPGMaxPastDays(int epgMaxPastDays)
@@ -79,53 +102,76 @@ void Epg::SetEPGMaxFutureDays(int epgMaxFutureDays)
 }
 
 bool Epg::LoadEPG(time_t start, time_t end)
+{
+  std::unique_ptr<xml_document> xmlDoc = FetchXMLTV();
+  if (!xmlDoc)
+    return false;
+
+  return LoadEPG(*xmlDoc, start, end);
+}
+
+std::unique_ptr<xml_document> Epg::FetchXMLTV() const
 {
   auto started = std::chrono::high_resolution_clock::now();
-  Logger::Log(LEVEL_DEBUG, "%s - EPG Load Start", __FUNCTION__);
+  Logger::Log(LEVEL_DEBUG, "%s - XMLTV Fetch Start", __FUNCTION__);
 
   if (m_xmltvLocation.empty())
   {
     Logger::Log(LEVEL_INFO, "%s - EPG file path is not configured. EPG not loaded.", __FUNCTION__);
-    return false;
+    return {};
   }
 
   std::string data;
+  if (!GetXMLTVFileWithRetries(data))
+    return {};
 
-  if (GetXMLTVFileWithRetries(data))
-  {
-    std::string decompressedData;
-    char* buffer = FillBufferFromXMLTVData(data, decompressedData);
+  int fetchMilliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::high_resolution_clock::now() - started).count();
 
-    if (!buffer)
-      return false;
+  std::string decompressedData;
+  char* buffer = FillBufferFromXMLTVData(data, decompressedData);
 
-    xml_document xmlDoc;
-    xml_parse_result result = xmlDoc.load_string(buffer);
+  if (!buffer || m_cancellationToken.IsCancelled())
+    return {};
 
-    if (!result)
-    {
-      std::string errorString;
-      int offset = GetParseErrorString(buffer, result.offset, errorString);
-      Logger::Log(LEVEL_ERROR, "%s - Unable parse EPG XML: %s, offset: %d: \n[ %s \n]", __FUNCTION__, result.description(), offset, errorString.c_str());
-      return false;
-    }
+  std::unique_ptr<xml_document> xmlDoc(new xml_document());
+  xml_parse_result result = xmlDoc->load_string(buffer);
 
-    const auto& rootElement = xmlDoc.child("tv");
-    if (!rootElement)
-    {
-      Logger::Log(LEVEL_ERROR, "%s - Invalid EPG XML: no <tv> tag found", __FUNCTION__);
-      return false;
-    }
+  if (!result)
+  {
+    std::string errorString;
+    int offset = GetParseErrorString(buffer, result.offset, errorString);
+    Logger::Log(LEVEL_ERROR, "%s - Unable parse EPG XML: %s, offset: %d: \n[ %s \n]", __FUNCTION__, result.description(), offset, errorString.c_str());
+    return {};
+  }
 
-    if (!LoadChannelEpgs(rootElement))
-      return false;
+  int milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::high_resolution_clock::now() - started).count();
 
-    LoadEpgEntries(rootElement, start, end);
+  Logger::Log(LEVEL_INFO, "%s - XMLTV Fetched - %d (ms), Parsed - %d (ms)", __FUNCTION__, fetchMilliseconds, milliseconds - fetchMilliseconds);
 
-    xmlDoc.reset();
+  return xmlDoc;
+}
+
+bool Epg::LoadEPG(const xml_document& xmlDoc, time_t start, time_t end)
+{
+  auto started = std::chrono::high_resolution_clock::now();
+
+  const auto& rootElement = xmlDoc.child("tv");
+  if (!rootElement)
+  {
+    Logger::Log(LEVEL_ERROR, "%s - Invalid EPG XML: no <tv> tag found", __FUNCTION__);
+    return false;
   }
-  else
+
+  if (!LoadChannelEpgs(rootElement))
+    return false;
+
+  LoadEpgEntries(rootElement, start, end);
+
+  if (m_cancellationToken.IsCancelled())
   {
+    Logger::Log(LEVEL_DEBUG, "%s - EPG load cancelled", __FUNCTION__);
     return false;
   }
 
@@ -134,6 +180,8 @@ bool Epg::LoadEPG(time_t start, time_t end)
   if (Settings::GetInstance().GetEpgLogosMode() != EpgLogosMode::IGNORE_XMLTV)
     ApplyChannelsLogosFromEPG();
 
+  IndexCatchupIds();
+
   int milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
                       std::chrono::high_resolution_clock::now() - started).count();
 
@@ -142,7 +190,7 @@ bool Epg::LoadEPG(time_t start, time_t end)
   return true;
 }
 
-bool Epg::GetXMLTVFileWithRetries(std::string& data)
+bool Epg::GetXMLTVFileWithRetries(std::string& data) const
 {
   int bytesRead = 0;
   int count = 0;
@@ -152,13 +200,20 @@ bool Epg::GetXMLTVFileWithRetries(std::string& data)
 
   while (count < 3) // max 3 tries
   {
-    if ((bytesRead = FileUtils::GetCachedFileContents(XMLTV_CACHE_FILENAME, m_xmltvLocation, data, useEPGCache)) != 0)
+    if ((bytesRead = FileUtils::GetCachedFileContents(XMLTV_CACHE_FILENAME, m_xmltvLocation, data, useEPGCache, m_cancellationToken)) != 0)
       break;
 
+    if (m_cancellationToken.IsCancelled())
+    {
+      Logger::Log(LEVEL_DEBUG, "%s - EPG file load cancelled", __FUNCTION__);
+      return false;
+    }
+
     Logger::Log(LEVEL_ERROR, "%s - Unable to load EPG file '%s':  file is missing or empty. :%dth try.", __FUNCTION__, m_xmltvLocation.c_str(), ++count);
 
-    if (count < 3)
-      std::this_thread::sleep_for(std::chrono::microseconds(2 * 1000 * 1000)); // sleep 2 sec before next try.
+    // sleep 2 sec before next try, unless cancelled in the meantime
+    if (count < 3 && !m_cancellationToken.WaitFor(std::chrono::seconds(2)))
+      return false;
   }
 
   if (bytesRead == 0)
@@ -170,16 +225,17 @@ bool Epg::GetXMLTVFileWithRetries(std::string& data)
   return true;
 }
 
-char* Epg::FillBufferFromXMLTVData(std::string& data, std::string& decompressedData)
+char* Epg::FillBufferFromXMLTVData(std::string& data, std::string& decompressedData) const
 {
   char* buffer = nullptr;
 
   // gzip packed
   if (data[0] == '\x1F' && data[1] == '\x8B' && data[2] == '\x08')
   {
-    if (!FileUtils::GzipInflate(data, decompressedData))
+    if (!FileUtils::GzipInflate(data, decompressedData, m_cancellationToken))
     {
-      Logger::Log(LEVEL_ERROR, "%s - Invalid EPG file '%s': unable to decompress file.", __FUNCTION__, m_xmltvLocation.c_str());
+      if (!m_cancellationToken.IsCancelled())
+        Logger::Log(LEVEL_ERROR, "%s - Invalid EPG file '%s': unable to decompress file.", __FUNCTION__, m_xmltvLocation.c_str());
       return nullptr;
     }
     buffer = &(decompressedData[0]);
@@ -235,6 +291,9 @@ bool Epg::LoadChannelEpgs(const xml_node& rootElement)
 
   for (const auto& channelNode : rootElement.children("channel"))
   {
+    if (m_cancellationToken.IsCancelled())
+      return false;
+
     ChannelEpg channelEpg;
 
     if (channelEpg.UpdateFrom(channelNode, m_channels))
@@ -278,10 +337,10 @@ void Epg::LoadEpgEntries(const xml_node& rootElement, int start, int end)
 
     for (const auto& channel : m_channels.GetChannelsList())
     {
-      if (channel.GetTvgShift() + m_epgTimeShift < minShiftTime)
-        minShiftTime = channel.GetTvgShift() + m_epgTimeShift;
-      if (channel.GetTvgShift() + m_epgTimeShift > maxShiftTime)
-        maxShiftTime = channel.GetTvgShift() + m_epgTimeShift;
+      if (channel->GetTvgShift() + m_epgTimeShift < minShiftTime)
+        minShiftTime = channel->GetTvgShift() + m_epgTimeShift;
+      if (channel->GetTvgShift() + m_epgTimeShift > maxShiftTime)
+        maxShiftTime = channel->GetTvgShift() + m_epgTimeShift;
     }
   }
 
@@ -290,6 +349,9 @@ void Epg::LoadEpgEntries(const xml_node& rootElement, int start, int end)
 
   for (const auto& channelNode : rootElement.children("programme"))
   {
+    if (m_cancellationToken.IsCancelled())
+      break;
+
     std::string id;
     if (!GetAttributeValue(channelNode, "channel", id))
       continue;
@@ -313,64 +375,32 @@ void Epg::LoadEpgEntries(const xml_node& rootElement, int start, int end)
 }
 
 
-void Epg::ReloadEPG()
+PVR_ERROR Epg::GetEPGForChannel(int channelUid, time_t start, time_t end, kodi::addon::PVREPGTagsResultSet& results) const
 {
-  m_xmltvLocation = Settings::GetInstance().GetEpgLocation();
-  m_epgTimeShift = Settings::GetInstance().GetEpgTimeshiftSecs();
-  m_tsOverride = Settings::GetInstance().GetTsOverride();
-  m_lastStart = 0;
-  m_lastEnd = 0;
+  std::shared_ptr<const Channel> myChannel = m_channels.GetChannel(channelUid);
+  if (!myChannel)
+    return PVR_ERROR_NO_ERROR;
 
-  Clear();
+  const ChannelEpg* channelEpg = FindEpgForChannel(*myChannel);
+  if (!channelEpg || channelEpg->GetEpgEntries().size() == 0)
+    return PVR_ERROR_NO_ERROR;
 
-  if (LoadEPG(m_lastStart, m_lastEnd))
-  {
-    for (const auto& myChannel : m_channels.GetChannelsList())
-      m_client->TriggerEpgUpdate(myChannel.GetUniqueId());
-  }
-}
+  int shift = GetEPGTimezoneShiftSecs(*myChannel);
 
-PVR_ERROR Epg::GetEPGForChannel(int channelUid, time_t start, time_t end, kodi::addon::PVREPGTagsResultSet& results)
-{
-  for (const auto& myChannel : m_channels.GetChannelsList())
+  for (const auto& epgEntryPair : channelEpg->GetEpgEntries())
   {
-    if (myChannel.GetUniqueId() != channelUid)
+    const auto& epgEntry = epgEntryPair.second;
+    if ((epgEntry.GetEndTime() + shift) < start)
       continue;
 
-    if (start > m_lastStart || end > m_lastEnd)
-    {
-      // reload EPG for new time interval only
-      LoadEPG(start, end);
-      {
-        // doesn't matter is epg loaded or not we shouldn't try to load it for same interval
-        m_lastStart = static_cast<int>(start);
-        m_lastEnd = static_cast<int>(end);
-      }
-    }
-
-    ChannelEpg* channelEpg = FindEpgForChannel(myChannel);
-    if (!channelEpg || channelEpg->GetEpgEntries().size() == 0)
-      return PVR_ERROR_NO_ERROR;
-
-    int shift = GetEPGTimezoneShiftSecs(myChannel);
-
-    for (auto& epgEntryPair : channelEpg->GetEpgEntries())
-    {
-      auto& epgEntry = epgEntryPair.second;
-      if ((epgEntry.GetEndTime() + shift) < start)
-        continue;
-
-      kodi::addon::PVREPGTag tag;
+    kodi::addon::PVREPGTag tag;
 
-      epgEntry.UpdateTo(tag, channelUid, shift, m_genreMappings);
+    epgEntry.UpdateTo(tag, channelUid, shift, m_genreMappings);
 
-      results.Add(tag);
+    results.Add(tag);
 
-      if ((epgEntry.GetStartTime() + shift) > end)
-        break;
-    }
-
-    return PVR_ERROR_NO_ERROR;
+    if ((epgEntry.GetStartTime() + shift) > end)
+      break;
   }
 
   return PVR_ERROR_NO_ERROR;
@@ -419,28 +449,24 @@ ChannelEpg* Epg::FindEpgForChannel(const Channel& channel) const
 
 void Epg::ApplyChannelsLogosFromEPG()
 {
-  bool updated = false;
-
   for (const auto& channel : m_channels.GetChannelsList())
   {
-    const ChannelEpg* channelEpg = FindEpgForChannel(channel);
+    const ChannelEpg* channelEpg = FindEpgForChannel(*channel);
     if (!channelEpg || channelEpg->GetIconPath().empty())
       continue;
 
     // 1 - prefer icon from playlist
-    if (!channel.GetIconPath().empty() && Settings::GetInstance().GetEpgLogosMode() == EpgLogosMode::PREFER_M3U)
+    if (!channel->GetIconPath().empty() && Settings::GetInstance().GetEpgLogosMode() == EpgLogosMode::PREFER_M3U)
       continue;
 
     // 2 - prefer icon from epg
     if (!channelEpg->GetIconPath().empty() && Settings::GetInstance().GetEpgLogosMode() == EpgLogosMode::PREFER_XMLTV)
     {
-      m_channels.GetChannel(channel.GetUniqueId())->SetIconPath(channelEpg->GetIconPath());
-      updated = true;
+      const int uniqueId = channel->GetUniqueId();
+      m_channels.SetChannelIconPath(uniqueId, channelEpg->GetIconPath());
+      m_channelLogosUpdated = true;
     }
   }
-
-  if (updated)
-    m_client->TriggerChannelUpdate();
 }
 
 bool Epg::LoadGenres()
@@ -463,22 +489,22 @@ void Epg::MoveOldGenresXMLFileToNewLocation()
   FileUtils::DeleteFile(FileUtils::GetSystemAddonPath() + "/" + GENRES_MAP_FILENAME.c_str());
 }
 
-EpgEntry* Epg::GetLiveEPGEntry(const Channel& myChannel) const
+const EpgEntry* Epg::GetLiveEPGEntry(const Channel& myChannel) const
 {
   return GetEPGEntry(myChannel, time(nullptr));
 }
 
-EpgEntry* Epg::GetEPGEntry(const Channel& myChannel, time_t lookupTime) const
+const EpgEntry* Epg::GetEPGEntry(const Channel& myChannel, time_t lookupTime) const
 {
-  ChannelEpg* channelEpg = FindEpgForChannel(myChannel);
+  const ChannelEpg* channelEpg = FindEpgForChannel(myChannel);
   if (!channelEpg || channelEpg->GetEpgEntries().size() == 0)
     return nullptr;
 
   int shift = GetEPGTimezoneShiftSecs(myChannel);
 
-  for (auto& epgEntryPair : channelEpg->GetEpgEntries())
+  for (const auto& epgEntryPair : channelEpg->GetEpgEntries())
   {
-    auto& epgEntry = epgEntryPair.second;
+    const auto& epgEntry = epgEntryPair.second;
     time_t startTime = epgEntry.GetStartTime() + shift;
     time_t endTime = epgEntry.GetEndTime() + shift;
     if (startTime <= lookupTime && endTime > lookupTime)
@@ -494,3 +520,46 @@ int Epg::GetEPGTimezoneShiftSecs(const Channel& myChannel) const
 {
   return m_tsOverride ? m_epgTimeShift : myChannel.GetTvgShift() + m_epgTimeShift;
 }
+
+void Epg::IndexCatchupIds()
+{
+  m_catchupIdRanges.clear();
+
+  for (const auto& channel : m_channels.GetChannelsList())
+  {
+    // Other channels are playable based on their catchup window alone
+    if (!channel->IgnoreCatchupDays())
+      continue;
+
+    const ChannelEpg* channelEpg = FindEpgForChannel(*channel);
+    if (!channelEpg || channelEpg->GetEpgEntries().empty())
+      continue;
+
+    const int shift = GetEPGTimezoneShiftSecs(*channel);
+    std::vector<CatchupIdRange>& ranges = m_catchupIdRanges[channel->GetUniqueId()];
+    ranges.reserve(channelEpg->GetEpgEntries().size());
+
+    // Entries are keyed by start time and the shift is per channel, so the ranges stay sorted
+    for (const auto& epgEntryPair : channelEpg->GetEpgEntries())
+    {
+      const EpgEntry& epgEntry = epgEntryPair.second;
+      ranges.push_back({epgEntry.GetStartTime() + shift, epgEntry.GetEndTime() + shift, !epgEntry.GetCatchupId().empty()});
+    }
+  }
+}
+
+bool Epg::HasCatchupId(int channelUid, time_t lookupTime) const
+{
+  auto rangesPair = m_catchupIdRanges.find(channelUid);
+  if (rangesPair == m_catchupIdRanges.end())
+    return false;
+
+  const std::vector<CatchupIdRange>& ranges = rangesPair->second;
+  auto range = std::upper_bound(ranges.begin(), ranges.end(), lookupTime,
+                                [](time_t time, const CatchupIdRange& range) { return time < range.m_startTime; });
+  if (range == ranges.begin())
+    return false;
+
+  --range;
+  return range->m_endTime > lookupTime && range->m_hasCatchupId;
+}
@@ -12,8 +12,11 @@
 #include "Settings.h"
 #include "data/ChannelEpg.h"
 #include "data/EpgGenre.h"
+#include "utilities/CancellationToken.h"
 
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <kodi/addon-instance/PVR.h>
@@ -36,27 +39,40 @@ namespace tvlink
   class Epg
   {
   public:
-    Epg(kodi::addon::CInstancePVRClient* client, tvlink::Channels& channels);
+    Epg(tvlink::Channels& channels);
 
-    bool Init(int epgMaxPastDays, int epgMaxFutureDays);
+    bool Init(int epgMaxPastDays, int epgMaxFutureDays, time_t start, time_t end,
+              const utilities::CancellationToken& token);
 
-    PVR_ERROR GetEPGForChannel(int channelUid, time_t start, time_t end, kodi::addon::PVREPGTagsResultSet& results);
+    // The XMLTV fetch and parse only depends on the settings, so a caller can run
+    // it alongside the playlist load and bind the result to the channels afterwards.
+    // Fetching and loading give up early once the token is cancelled.
+    void Configure(int epgMaxPastDays, int epgMaxFutureDays, const utilities::CancellationToken& token);
+    bool GetLoadInterval(time_t& start, time_t& end) const;
+    std::unique_ptr<pugi::xml_document> FetchXMLTV() const;
+    bool LoadEPG(const pugi::xml_document& xmlDoc, time_t start, time_t end);
+
+    PVR_ERROR GetEPGForChannel(int channelUid, time_t start, time_t end, kodi::addon::PVREPGTagsResultSet& results) const;
     void SetEPGMaxPastDays(int epgMaxPastDays);
     void SetEPGMaxFutureDays(int epgMaxFutureDays);
     void Clear();
-    void ReloadEPG();
+    bool ChannelLogosUpdated() const { return m_channelLogosUpdated; }
 
-    data::EpgEntry* GetLiveEPGEntry(const data::Channel& myChannel) const;
-    data::EpgEntry* GetEPGEntry(const data::Channel& myChannel, time_t lookupTime) const;
+    const data::EpgEntry* GetLiveEPGEntry(const data::Channel& myChannel) const;
+    const data::EpgEntry* GetEPGEntry(const data::Channel& myChannel, time_t lookupTime) const;
     int GetEPGTimezoneShiftSecs(const data::Channel& myChannel) const;
 
+    // Answers from the index built at load time, so it is cheap enough for the
+    // per programme playability checks Kodi makes while rendering the guide
+    bool HasCatchupId(int channelUid, time_t lookupTime) const;
+
   private:
     static const XmltvFileFormat GetXMLTVFileFormat(const char* buffer);
     static void MoveOldGenresXMLFileToNewLocation();
 
     bool LoadEPG(time_t iStart, time_t iEnd);
-    bool GetXMLTVFileWithRetries(std::string& data);
-    char* FillBufferFromXMLTVData(std::string& data, std::string& decompressedData);
+    bool GetXMLTVFileWithRetries(std::string& data) const;
+    char* FillBufferFromXMLTVData(std::string& data, std::string& decompressedData) const;
     bool LoadChannelEpgs(const pugi::xml_node& rootElement);
     void LoadEpgEntries(const pugi::xml_node& rootElement, int start, int end);
     bool LoadGenres();
@@ -64,21 +80,30 @@ namespace tvlink
     data::ChannelEpg* FindEpgForChannel(const std::string& id) const;
     data::ChannelEpg* FindEpgForChannel(const data::Channel& channel) const;
     void ApplyChannelsLogosFromEPG();
+    void IndexCatchupIds();
+
+    struct CatchupIdRange
+    {
+      time_t m_startTime; // shifted
+      time_t m_endTime; // shifted
+      bool m_hasCatchupId;
+    };
 
     std::string m_xmltvLocation;
-    int m_epgTimeShift;
-    bool m_tsOverride;
-    int m_lastStart;
-    int m_lastEnd;
+    int m_epgTimeShift = 0;
+    bool m_tsOverride = false;
+    bool m_channelLogosUpdated = false;
     int m_epgMaxPastDays;
     int m_epgMaxFutureDays;
     long m_epgMaxPastDaysSeconds;
     long m_epgMaxFutureDaysSeconds;
+    utilities::CancellationToken m_cancellationToken;
 
     tvlink::Channels& m_channels;
     std::vector<data::ChannelEpg> m_channelEpgs;
     std::vector<tvlink::data::EpgGenre> m_genreMappings;
 
-    kodi::addon::CInstancePVRClient* m_client;
+    // Sorted by start time, only kept for channels that ignore catchup days
+    std::unordered_map<int, std::vector<CatchupIdRange>> m_catchupIdRanges;
   };
 } //namespace tvlink
@@ -0,0 +1,473 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "LiveStream.h"
+
+#include "utilities/Logger.h"
+#include "utilities/RingBuffer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+using namespace tvlink;
+using namespace tvlink::utilities;
+
+LiveStream::~LiveStream()
+{
+  Close();
+}
+
+std::unique_ptr<kodi::vfs::CFile> LiveStream::OpenHandle(const std::string& url, unsigned int flags, int connectTimeoutSecs)
+{
+  std::unique_ptr<kodi::vfs::CFile> file(new kodi::vfs::CFile());
+
+  file->CURLCreate(url);
+  file->CURLAddOption(ADDON_CURL_OPTION_PROTOCOL, "connection-timeout", std::to_string(connectTimeoutSecs));
+  file->CURLAddOption(ADDON_CURL_OPTION_PROTOCOL, "data-timeout", "0");
+  file->CURLAddOption(ADDON_CURL_OPTION_PROTOCOL, "lowspeed-time", "0");
+  file->CURLAddOption(ADDON_CURL_OPTION_PROTOCOL, "speed-limit", "0");
+
+  if (!file->CURLOpen(flags))
+    return {};
+
+  return file;
+}
+
+void LiveStream::SetTimeshift(const std::string& filePath, size_t bytes)
+{
+  m_timeshiftFilePath = filePath;
+
+  // Whole packets fill the file exactly, so the oldest position still there stays on a packet start
+  m_timeshiftBytes = bytes > 0 ? std::max(bytes - bytes % TsFramer::PACKET_SIZE, 2 * MAX_READ_SIZE) : 0;
+}
+
+bool LiveStream::Open(const std::string& url, unsigned int flags, int connectTimeoutSecs, size_t readAheadBytes, size_t prefillBytes)
+{
+  return Open(url, url, flags, connectTimeoutSecs, readAheadBytes, prefillBytes);
+}
+
+bool LiveStream::Open(const std::string& connectUrl, const std::string& url, unsigned int flags, int connectTimeoutSecs,
+                      size_t readAheadBytes, size_t prefillBytes)
+{
+  Close();
+
+  const StreamTelemetry::Clock::time_point openStarted = StreamTelemetry::Clock::now();
+  std::unique_ptr<kodi::vfs::CFile> file = OpenHandle(connectUrl, flags, connectTimeoutSecs);
+  const int connectMillis = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(StreamTelemetry::Clock::now() - openStarted).count());
+
+  return Start(std::move(file), url, flags, connectTimeoutSecs, openStarted, connectMillis, readAheadBytes, prefillBytes);
+}
+
+bool LiveStream::Open(std::unique_ptr<kodi::vfs::CFile> file, const std::string& url, unsigned int flags, int connectTimeoutSecs,
+                      size_t readAheadBytes, size_t prefillBytes)
+{
+  Close();
+
+  // An adopted handle is already connected
+  return Start(std::move(file), url, flags, connectTimeoutSecs, StreamTelemetry::Clock::now(), 0, readAheadBytes, prefillBytes);
+}
+
+bool LiveStream::Start(std::unique_ptr<kodi::vfs::CFile> file, const std::string& url, unsigned int flags, int connectTimeoutSecs,
+                       StreamTelemetry::Clock::time_point openStarted, int connectMillis, size_t readAheadBytes, size_t prefillBytes)
+{
+  if (!file)
+    return false;
+
+  m_file = std::move(file);
+  m_open = true;
+  m_url = url;
+  m_effectiveUrl = m_file->GetPropertyValue(ADDON_FILE_PROPERTY_EFFECTIVE_URL, "");
+  m_flags = flags;
+  m_connectTimeoutSecs = connectTimeoutSecs;
+  m_connectedTime = StreamTelemetry::Clock::now();
+  m_quickReconnects = 0;
+  m_formatKnown = false;
+  m_transportStream = false;
+  m_tsFramer.Clear();
+  m_bitrateKbps = m_bitrateHintKbps;
+  m_bitrateSampleStarted = StreamTelemetry::Clock::now();
+  m_bitrateSampleBytes = 0;
+  m_delivered = false;
+  m_stopping = false;
+  m_endOfStream = false;
+  m_telemetry.Start(openStarted, connectMillis);
+  UpdateReadSizing();
+
+  if (m_timeshiftBytes > 0)
+  {
+    std::unique_ptr<TimeshiftBuffer> timeshiftBuffer(new TimeshiftBuffer());
+    if (timeshiftBuffer->Open(m_timeshiftFilePath, m_timeshiftBytes))
+    {
+      m_timeshiftBuffer = timeshiftBuffer.get();
+      m_buffer = std::move(timeshiftBuffer);
+    }
+    else
+    {
+      Logger::Log(LEVEL_ERROR, "%s - Timeshift is not available, playing without it", __FUNCTION__);
+    }
+  }
+
+  if (!m_buffer && readAheadBytes > 0)
+    m_buffer.reset(new RingBuffer(std::max(readAheadBytes, 2 * MAX_READ_SIZE)));
+
+  if (m_buffer)
+  {
+    // The producer only reads when a whole chunk fits, so the buffer never gets
+    // fuller than its capacity less one chunk and the prefill has to stay below that
+    m_prefillBytes = std::min(prefillBytes, m_buffer->GetCapacity() - MAX_READ_SIZE);
+
+    // At a low bitrate a big prefill would hold playback back for minutes
+    if (m_bitrateKbps > 0)
+      m_prefillBytes = std::min(m_prefillBytes, static_cast<size_t>(m_bitrateKbps) * 1000 / 8 * MAX_PREFILL_SECS);
+
+    m_prefilling = m_prefillBytes > 0;
+    m_bufferLevelPercent = 0;
+    m_producer = std::thread([this] { Produce(); });
+
+    Logger::Log(LEVEL_DEBUG, "%s - %s buffer of %d KB, prefill %d KB", __FUNCTION__, m_timeshiftBuffer ? "Timeshift" : "Read-ahead",
+                static_cast<int>(m_buffer->GetCapacity() / 1024), static_cast<int>(m_prefillBytes / 1024));
+  }
+
+  return true;
+}
+
+void LiveStream::Close()
+{
+  // Wakes the producer, and a read that is waiting for data or to reconnect
+  m_stopping = true;
+  NotifySpaceAvailable();
+  NotifyDataAvailable();
+
+  // The reading side may be inside a read from the handle, a live stream keeps
+  // sending data so that read returns shortly and the reader sees the flag
+  if (m_producer.joinable())
+    m_producer.join();
+
+  // A read still in progress has to leave the handle and the buffer before they go
+  std::lock_guard<std::mutex> lock(m_readMutex);
+
+  if (m_file)
+    m_file->Close();
+  m_file.reset();
+  m_open = false;
+
+  m_timeshiftBuffer = nullptr;
+  m_buffer.reset();
+  m_prefilling = false;
+  m_bufferLevelPercent = -1;
+  m_telemetry.Stop();
+}
+
+int LiveStream::Read(unsigned char* buffer, unsigned int bufferSize)
+{
+  const StreamTelemetry::Clock::time_point readStarted = StreamTelemetry::Clock::now();
+
+  std::lock_guard<std::mutex> readLock(m_readMutex);
+  if (!m_file || m_stopping)
+    return -1;
+
+  if (!m_buffer)
+  {
+    const ssize_t bytesRead = ReadCoalesced(buffer, bufferSize, std::min<size_t>(bufferSize, m_coalesceSize));
+    RecordDelivery(readStarted, bytesRead > 0);
+    return static_cast<int>(bytesRead);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(m_waitMutex);
+    const size_t wanted = m_prefilling ? m_prefillBytes : 1;
+    m_dataAvailable.wait(lock, [this, wanted] { return m_buffer->GetUsed() >= wanted || m_endOfStream || m_stopping; });
+  }
+
+  // Close is waiting for this read to return before it frees the buffer
+  if (m_stopping)
+    return -1;
+
+  const size_t bytesRead = m_buffer->Read(buffer, bufferSize);
+  RecordDelivery(readStarted, bytesRead > 0);
+  UpdateBufferLevel();
+  NotifySpaceAvailable();
+
+  // Running dry means the network could not keep up, fill up again before the
+  // next read instead of handing the demuxer one small read after another
+  m_prefilling = m_prefillBytes > 0 && m_buffer->GetUsed() == 0 && !m_endOfStream && !m_stopping;
+  if (m_prefilling)
+    Logger::Log(LEVEL_DEBUG, "%s - Read-ahead buffer ran dry, refilling", __FUNCTION__);
+
+  return static_cast<int>(bytesRead);
+}
+
+int64_t LiveStream::Seek(int64_t position, int whence)
+{
+  std::lock_guard<std::mutex> readLock(m_readMutex);
+  if (!m_timeshiftBuffer)
+    return -1;
+
+  switch (whence)
+  {
+    case SEEK_SET:
+      break;
+    case SEEK_CUR:
+      position += m_timeshiftBuffer->GetReadPosition();
+      break;
+    case SEEK_END:
+      position += m_timeshiftBuffer->GetWritePosition();
+      break;
+    default:
+      return -1;
+  }
+
+  // Keep handing on whole packets, the demuxer asks for arbitrary byte positions
+  if (m_transportStream)
+    position -= position % static_cast<int64_t>(TsFramer::PACKET_SIZE);
+
+  position = m_timeshiftBuffer->Seek(position);
+  UpdateBufferLevel();
+  NotifySpaceAvailable();
+
+  // A seek is a jump rather than the network falling behind, don't wait for a prefill
+  m_prefilling = false;
+
+  return position;
+}
+
+int64_t LiveStream::GetLength() const
+{
+  return m_timeshiftBuffer ? m_timeshiftBuffer->GetWritePosition() : -1;
+}
+
+bool LiveStream::GetTimeshiftTimes(time_t& openTime, std::chrono::milliseconds& startMillis, std::chrono::milliseconds& endMillis) const
+{
+  if (!m_timeshiftBuffer)
+    return false;
+
+  openTime = m_timeshiftBuffer->GetOpenTime();
+  m_timeshiftBuffer->GetTimes(startMillis, endMillis);
+  return true;
+}
+
+void LiveStream::Produce()
+{
+  std::unique_ptr<uint8_t[]> chunk(new uint8_t[MAX_READ_SIZE]);
+
+  while (!m_stopping)
+  {
+    {
+      std::unique_lock<std::mutex> lock(m_waitMutex);
+      m_spaceAvailable.wait(lock, [this] { return m_buffer->GetFree() >= m_readSize || m_stopping; });
+    }
+
+    if (m_stopping)
+      break;
+
+    const ssize_t bytesRead = ReadCoalesced(chunk.get(), m_readSize, m_coalesceSize);
+    if (bytesRead <= 0)
+    {
+      Logger::Log(LEVEL_DEBUG, "%s - End of live stream", __FUNCTION__);
+      m_endOfStream = true;
+      NotifyDataAvailable();
+      break;
+    }
+
+    // Only this thread writes and the space was checked above, so it always fits
+    m_buffer->Write(chunk.get(), static_cast<size_t>(bytesRead));
+    UpdateBufferLevel();
+    NotifyDataAvailable();
+  }
+}
+
+ssize_t LiveStream::ReadCoalesced(uint8_t* buffer, size_t size, size_t coalesceSize)
+{
+  // Reads return whatever has arrived, keep reading until there is enough to be worth a wakeup
+  size_t totalRead = 0;
+  do
+  {
+    const ssize_t bytesRead = ReadFromNetwork(buffer + totalRead, size - totalRead);
+    if (bytesRead <= 0)
+      return totalRead > 0 ? static_cast<ssize_t>(totalRead) : bytesRead;
+
+    totalRead += static_cast<size_t>(bytesRead);
+    UpdateBitrateEstimate(static_cast<size_t>(bytesRead));
+  } while (totalRead < coalesceSize && size - totalRead >= MIN_READ_SIZE && !m_stopping);
+
+  return static_cast<ssize_t>(totalRead);
+}
+
+void LiveStream::UpdateBitrateEstimate(size_t bytesRead)
+{
+  m_bitrateSampleBytes += bytesRead;
+
+  const StreamTelemetry::Clock::time_point now = StreamTelemetry::Clock::now();
+  const int64_t sampleMillis = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_bitrateSampleStarted).count();
+  if (sampleMillis < BITRATE_SAMPLE_SECS * 1000)
+    return;
+
+  // Smoothed, so the burst while a buffer fills up doesn't swing the sizes around
+  const int sampleKbps = static_cast<int>(static_cast<int64_t>(m_bitrateSampleBytes) * 8 / sampleMillis);
+  m_bitrateKbps = m_bitrateKbps > 0 ? (3 * m_bitrateKbps + sampleKbps) / 4 : sampleKbps;
+  m_bitrateSampleStarted = now;
+  m_bitrateSampleBytes = 0;
+
+  UpdateReadSizing();
+}
+
+void LiveStream::UpdateReadSizing()
+{
+  if (m_bitrateKbps > 0)
+  {
+    const size_t bytesPerSec = static_cast<size_t>(m_bitrateKbps) * 1000 / 8;
+    m_readSize = std::min(std::max(bytesPerSec * READ_INTERVAL_MS / 1000, MIN_READ_SIZE), MAX_READ_SIZE);
+
+    // Below the smallest read size there is nothing to gain from waiting
+    const size_t coalesceSize = bytesPerSec * COALESCE_INTERVAL_MS / 1000;
+    m_coalesceSize = coalesceSize >= MIN_READ_SIZE ? std::min(coalesceSize, m_readSize) : 0;
+  }
+  else
+  {
+    m_readSize = DEFAULT_READ_SIZE;
+    m_coalesceSize = 0;
+  }
+
+  m_telemetry.RecordReadSizing(m_bitrateKbps, m_readSize, m_coalesceSize);
+}
+
+ssize_t LiveStream::ReadFromNetwork(uint8_t* buffer, size_t size)
+{
+  // Framing needs room for the carried over part of a packet and at least one whole packet
+  if (m_transportStream && size < 2 * TsFramer::PACKET_SIZE)
+  {
+    Logger::Log(LEVEL_DEBUG, "%s - Reads of %d bytes are too small to frame MPEG-TS packets", __FUNCTION__, static_cast<int>(size));
+    m_transportStream = false;
+  }
+
+  while (true)
+  {
+    const size_t carrySize = m_transportStream ? m_tsFramer.TakeCarry(buffer) : 0;
+
+    const ssize_t bytesRead = m_file->Read(buffer + carrySize, size - carrySize);
+    m_telemetry.RecordNetworkRead(bytesRead);
+
+    // A live stream has no end, so any end of data means the server or the network dropped us
+    if (bytesRead <= 0)
+    {
+      if (m_stopping || !Reconnect())
+        return bytesRead;
+      continue;
+    }
+
+    size_t dataSize = carrySize + static_cast<size_t>(bytesRead);
+    if (!m_formatKnown)
+    {
+      m_formatKnown = true;
+      m_transportStream = TsFramer::IsTransportStream(buffer, dataSize);
+      if (m_transportStream)
+        Logger::Log(LEVEL_DEBUG, "%s - Live stream is MPEG-TS, handing on whole packets only", __FUNCTION__);
+    }
+
+    if (!m_transportStream)
+      return static_cast<ssize_t>(dataSize);
+
+    // Returning nothing would look like the end of the stream, so read until a whole packet is there
+    dataSize = m_tsFramer.Frame(buffer, dataSize);
+    m_telemetry.RecordTsFraming(m_tsFramer.GetPackets(), m_tsFramer.GetSyncErrors(), m_tsFramer.GetContinuityErrors());
+    if (dataSize > 0)
+      return static_cast<ssize_t>(dataSize);
+  }
+}
+
+bool LiveStream::Reconnect()
+{
+  // Connections that keep dropping straight after connecting are not worth chasing forever
+  const StreamTelemetry::Clock::time_point gapStarted = StreamTelemetry::Clock::now();
+  if (gapStarted - m_connectedTime < std::chrono::seconds(RECONNECT_MIN_UPTIME_SECS))
+    m_quickReconnects++;
+  else
+    m_quickReconnects = 0;
+
+  if (m_quickReconnects > MAX_RECONNECT_ATTEMPTS)
+  {
+    Logger::Log(LEVEL_ERROR, "%s - Live stream keeps dropping, giving up after %d reconnects", __FUNCTION__, MAX_RECONNECT_ATTEMPTS);
+    return false;
+  }
+
+  std::chrono::milliseconds backoff(RECONNECT_INITIAL_BACKOFF_MS);
+  for (int attempt = 1; attempt <= MAX_RECONNECT_ATTEMPTS; attempt++)
+  {
+    {
+      // Close wakes this wait through m_spaceAvailable
+      std::unique_lock<std::mutex> lock(m_waitMutex);
+      if (m_spaceAvailable.wait_for(lock, backoff, [this] { return m_stopping.load(); }))
+        return false;
+    }
+    backoff = std::min(backoff * 2, std::chrono::milliseconds(RECONNECT_MAX_BACKOFF_MS));
+
+    std::unique_ptr<kodi::vfs::CFile> file = OpenHandle(m_url, m_flags, m_connectTimeoutSecs);
+
+    // Closed while connecting, Close is waiting for this to return
+    if (m_stopping)
+    {
+      if (file)
+        file->Close();
+      return false;
+    }
+
+    if (!file)
+    {
+      Logger::Log(LEVEL_DEBUG, "%s - Reconnect attempt %d of %d failed", __FUNCTION__, attempt, MAX_RECONNECT_ATTEMPTS);
+      continue;
+    }
+
+    m_file->Close();
+    m_file = std::move(file);
+    m_connectedTime = StreamTelemetry::Clock::now();
+
+    // The packet that was cut off was never handed on, the framer picks up at the
+    // first packet start of the new connection and doesn't compare its continuity
+    // counters with the old one
+    m_tsFramer.Reset();
+
+    const std::chrono::milliseconds gap = std::chrono::duration_cast<std::chrono::milliseconds>(m_connectedTime - gapStarted);
+    m_telemetry.RecordReconnect(gap);
+    Logger::Log(LEVEL_INFO, "%s - Live stream reconnected after a gap of %d (ms), attempt %d", __FUNCTION__, static_cast<int>(gap.count()), attempt);
+
+    return true;
+  }
+
+  Logger::Log(LEVEL_ERROR, "%s - Live stream could not be reconnected after %d attempts", __FUNCTION__, MAX_RECONNECT_ATTEMPTS);
+  return false;
+}
+
+void LiveStream::RecordDelivery(StreamTelemetry::Clock::time_point readStarted, bool delivered)
+{
+  if (m_delivered)
+    m_telemetry.RecordWait(std::chrono::duration_cast<std::chrono::milliseconds>(StreamTelemetry::Clock::now() - readStarted));
+  m_delivered = m_delivered || delivered;
+}
+
+void LiveStream::UpdateBufferLevel()
+{
+  m_bufferLevelPercent = static_cast<int>(m_buffer->GetUsed() * 100 / m_buffer->GetCapacity());
+}
+
+void LiveStream::NotifyDataAvailable()
+{
+  // Taking the lock orders the notification after a waiter checked its condition
+  {
+    std::lock_guard<std::mutex> lock(m_waitMutex);
+  }
+  m_dataAvailable.notify_one();
+}
+
+void LiveStream::NotifySpaceAvailable()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_waitMutex);
+  }
+  m_spaceAvailable.notify_one();
+}
@@ -0,0 +1,165 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "StreamTelemetry.h"
+#include "utilities/StreamBuffer.h"
+#include "utilities/TimeshiftBuffer.h"
+#include "utilities/TsFramer.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <kodi/Filesystem.h>
+
+namespace tvlink
+{
+  /**
+   * The CURL handle of the live stream Kodi is playing. Reads go straight to the
+   * handle unless a read-ahead buffer is configured, then a producer thread keeps
+   * a ring buffer filled from the handle and reads copy out of it, so network
+   * jitter is absorbed by the buffer instead of stalling the demuxer. Reads wait
+   * for the prefill level at the start and again after the buffer ran dry.
+   *
+   * When the connection drops the same URL is reopened with a bounded backoff
+   * and the demuxer carries on with the data of the new connection. MPEG-TS is
+   * handed on in whole packets only, so a seam or a corrupt stretch never leaves
+   * the demuxer to find the packet boundaries again.
+   *
+   * Upstream reads are sized from an estimate of the stream bitrate, seeded with
+   * what the channel averaged last time and kept up to date while playing. A
+   * high bitrate stream is read in large chunks and small reads are coalesced
+   * so there are fewer wakeups, a low bitrate one hands on data as it arrives.
+   *
+   * With timeshift the buffer is a ring in a file instead, big enough to keep
+   * reading while playback is paused and to seek back over what was played.
+   *
+   * Open, Close, Read and Seek are called by Kodi one at a time, except that
+   * Close can come while a read is stuck waiting for data or reconnecting. It
+   * cuts the read short and waits for it to return before freeing anything.
+   * The buffer level can be read from any thread.
+   */
+  class LiveStream
+  {
+  public:
+    LiveStream() = default;
+    ~LiveStream();
+
+    LiveStream(const LiveStream&) = delete;
+    LiveStream& operator=(const LiveStream&) = delete;
+
+    // Opens a handle with the options every live stream uses, nullptr on failure
+    static std::unique_ptr<kodi::vfs::CFile> OpenHandle(const std::string& url, unsigned int flags, int connectTimeoutSecs);
+
+    // Bitrate the channel averaged last time, 0 if unknown, applies to the next Open
+    void SetBitrateHint(int bitrateKbps) { m_bitrateHintKbps = bitrateKbps; }
+    // Timeshift file and its size, a size of zero turns timeshift off, applies to the next Open
+    void SetTimeshift(const std::string& filePath, size_t bytes);
+
+    // A readAheadBytes of zero reads from the handle directly
+    bool Open(const std::string& url, unsigned int flags, int connectTimeoutSecs, size_t readAheadBytes, size_t prefillBytes);
+    // Connects to connectUrl, such as where the URL redirected to before, while reconnects use the URL
+    bool Open(const std::string& connectUrl, const std::string& url, unsigned int flags, int connectTimeoutSecs,
+              size_t readAheadBytes, size_t prefillBytes);
+    // Adopts an open handle, the URL and options are used to reconnect
+    bool Open(std::unique_ptr<kodi::vfs::CFile> file, const std::string& url, unsigned int flags, int connectTimeoutSecs,
+              size_t readAheadBytes, size_t prefillBytes);
+    void Close();
+    bool IsOpen() const { return m_open; }
+    // Where the URL ended up after redirects, empty if the handle doesn't say
+    const std::string& GetEffectiveURL() const { return m_effectiveUrl; }
+    int Read(unsigned char* buffer, unsigned int bufferSize);
+
+    // Seeking only works within the timeshift buffer, positions count the bytes since Open
+    bool IsTimeshifting() const { return m_timeshiftBuffer != nullptr; }
+    int64_t Seek(int64_t position, int whence);
+    int64_t GetLength() const;
+    // When the stream was opened, and how long after that the oldest and the newest buffered data arrived
+    bool GetTimeshiftTimes(time_t& openTime, std::chrono::milliseconds& startMillis, std::chrono::milliseconds& endMillis) const;
+
+    // Fill level of the read-ahead buffer in percent, -1 when there is none
+    int GetBufferLevelPercent() const { return m_bufferLevelPercent; }
+    const StreamTelemetry& GetTelemetry() const { return m_telemetry; }
+
+  private:
+    static constexpr size_t DEFAULT_READ_SIZE = 64 * 1024;
+    static constexpr size_t MIN_READ_SIZE = 4 * 1024;
+    static constexpr size_t MAX_READ_SIZE = 256 * 1024;
+    static constexpr int READ_INTERVAL_MS = 100; // stream time per upstream read
+    static constexpr int COALESCE_INTERVAL_MS = 40; // stream time gathered before handing data on
+    static constexpr int MAX_PREFILL_SECS = 4;
+    static constexpr int BITRATE_SAMPLE_SECS = 2;
+    static constexpr int MAX_RECONNECT_ATTEMPTS = 5;
+    static constexpr int RECONNECT_INITIAL_BACKOFF_MS = 250;
+    static constexpr int RECONNECT_MAX_BACKOFF_MS = 4000;
+    static constexpr int RECONNECT_MIN_UPTIME_SECS = 10;
+
+    bool Start(std::unique_ptr<kodi::vfs::CFile> file, const std::string& url, unsigned int flags, int connectTimeoutSecs,
+               StreamTelemetry::Clock::time_point openStarted, int connectMillis, size_t readAheadBytes, size_t prefillBytes);
+    ssize_t ReadCoalesced(uint8_t* buffer, size_t size, size_t coalesceSize);
+    ssize_t ReadFromNetwork(uint8_t* buffer, size_t size);
+    void UpdateBitrateEstimate(size_t bytesRead);
+    void UpdateReadSizing();
+    bool Reconnect();
+    void Produce();
+    void RecordDelivery(StreamTelemetry::Clock::time_point readStarted, bool delivered);
+    void UpdateBufferLevel();
+    void NotifyDataAvailable();
+    void NotifySpaceAvailable();
+
+    std::unique_ptr<kodi::vfs::CFile> m_file;
+    bool m_open = false;
+    std::string m_url;
+    std::string m_effectiveUrl;
+    unsigned int m_flags = 0;
+    int m_connectTimeoutSecs = 0;
+    int m_bitrateHintKbps = 0;
+    std::string m_timeshiftFilePath;
+    size_t m_timeshiftBytes = 0;
+
+    // Only touched by the side reading from the network, the producer when there is one
+    StreamTelemetry::Clock::time_point m_connectedTime;
+    int m_quickReconnects = 0;
+    bool m_formatKnown = false;
+    std::atomic<bool> m_transportStream{false}; // also read by seeks
+    utilities::TsFramer m_tsFramer;
+    int m_bitrateKbps = 0;
+    size_t m_readSize = DEFAULT_READ_SIZE;
+    size_t m_coalesceSize = 0;
+    StreamTelemetry::Clock::time_point m_bitrateSampleStarted;
+    size_t m_bitrateSampleBytes = 0;
+
+    std::unique_ptr<utilities::StreamBuffer> m_buffer;
+    utilities::TimeshiftBuffer* m_timeshiftBuffer = nullptr; // m_buffer when timeshifting
+    std::thread m_producer;
+    size_t m_prefillBytes = 0;
+    bool m_prefilling = false; // consumer only, and Close under m_readMutex
+    bool m_delivered = false; // consumer only, waits before the first data are startup rather than stalls
+
+    std::atomic<bool> m_stopping{false};
+    std::atomic<bool> m_endOfStream{false};
+    std::atomic<int> m_bufferLevelPercent{-1};
+    StreamTelemetry m_telemetry;
+
+    // Held by Read and Seek for the whole call, Close takes it before it frees the
+    // handle and the buffer so a read it woke up has left them by then
+    std::mutex m_readMutex;
+
+    // Only used to sleep when the buffer is empty or full, the data path is lock free
+    std::mutex m_waitMutex;
+    std::condition_variable m_dataAvailable;
+    std::condition_variable m_spaceAvailable;
+  };
+} //namespace tvlink
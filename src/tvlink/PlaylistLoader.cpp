@@ -18,6 +18,7 @@
 #include <map>
 #include <regex>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 
 #include <kodi/General.h>
@@ -28,8 +29,9 @@ using namespace tvlink;
 using namespace tvlink::data;
 using namespace tvlink::utilities;
 
-PlaylistLoader::PlaylistLoader(kodi::addon::CInstancePVRClient* client, Channels& channels, ChannelGroups& channelGroups)
-  : m_channelGroups(channelGroups), m_channels(channels), m_client(client) { }
+PlaylistLoader::PlaylistLoader(Channels& channels, ChannelGroups& channelGroups,
+                               const CancellationToken& token /* CancellationToken() */)
+  : m_cancellationToken(token), m_channelGroups(channelGroups), m_channels(channels) { }
 
 bool PlaylistLoader::Init()
 {
@@ -40,9 +42,15 @@ bool PlaylistLoader::Init()
 
 bool PlaylistLoader::LoadPlayList()
 {
-  auto started = std::chrono::high_resolution_clock::now();
-  Logger::Log(LEVEL_DEBUG, "%s - Playlist Load Start", __FUNCTION__);
+  std::string playlistContent;
+  if (!FetchPlayList(playlistContent))
+    return false;
 
+  return ParsePlayList(playlistContent);
+}
+
+bool PlaylistLoader::FetchPlayList(std::string& playlistContent)
+{
   if (m_m3uLocation.empty())
   {
     Logger::Log(LEVEL_ERROR, "%s - Playlist file path is not configured. Channels not loaded.", __FUNCTION__);
@@ -52,13 +60,20 @@ bool PlaylistLoader::LoadPlayList()
   // Cache is only allowed if refresh mode is disabled
   bool useM3UCache = Settings::GetInstance().GetM3URefreshMode() != RefreshMode::DISABLED ? false : Settings::GetInstance().UseM3UCache();
 
-  std::string playlistContent;
-  if (!FileUtils::GetCachedFileContents(M3U_CACHE_FILENAME, m_m3uLocation, playlistContent, useM3UCache))
+  if (!FileUtils::GetCachedFileContents(M3U_CACHE_FILENAME, m_m3uLocation, playlistContent, useM3UCache, m_cancellationToken))
   {
     Logger::Log(LEVEL_ERROR, "%s - Unable to load playlist cache file '%s':  file is missing or empty.", __FUNCTION__, m_m3uLocation.c_str());
     return false;
   }
 
+  return true;
+}
+
+bool PlaylistLoader::ParsePlayList(const std::string& playlistContent)
+{
+  auto started = std::chrono::high_resolution_clock::now();
+  Logger::Log(LEVEL_DEBUG, "%s - Playlist Load Start", __FUNCTION__);
+
   std::stringstream stream(playlistContent);
 
   /* load channels */
@@ -68,11 +83,20 @@ bool PlaylistLoader::LoadPlayList()
   int catchupCorrectionSecs = 0;
   std::vector<int> currentChannelGroupIdList;
 
+  // An entry repeating the tvg-id and name of an earlier one is another source for that channel
+  std::unordered_map<std::string, int> channelUidsByTvgIdAndName;
+
   Channel tmpChannel;
 
   std::string line;
   while (std::getline(stream, line))
   {
+    if (m_cancellationToken.IsCancelled())
+    {
+      Logger::Log(LEVEL_DEBUG, "%s - Playlist parse cancelled", __FUNCTION__);
+      return false;
+    }
+
     line = StringUtils::TrimRight(line, " \t\r\n");
     line = StringUtils::TrimLeft(line, " \t");
 
@@ -148,7 +172,27 @@ bool PlaylistLoader::LoadPlayList()
       channel.SetStreamURL(line);
       channel.ConfigureCatchupMode();
 
-      m_channels.AddChannel(channel, currentChannelGroupIdList, m_channelGroups);
+      // A repeat of a channel is only folded into it when all it adds is a URL
+      // and groups, anything else set for the repeat would be lost
+      const std::string tvgIdAndName = channel.GetTvgId() + "\n" + channel.GetChannelName();
+      auto channelUidPair = channelUidsByTvgIdAndName.find(tvgIdAndName);
+      std::shared_ptr<const Channel> repeatedChannel;
+      if (!channel.GetTvgId().empty() && channelUidPair != channelUidsByTvgIdAndName.end())
+        repeatedChannel = m_channels.GetChannel(channelUidPair->second);
+
+      if (repeatedChannel && repeatedChannel->IsRadio() == channel.IsRadio() &&
+          repeatedChannel->GetProperties() == channel.GetProperties() &&
+          repeatedChannel->GetInputStreamName() == channel.GetInputStreamName())
+      {
+        Logger::Log(LEVEL_DEBUG, "%s - Adding URL as an alternative source for channel '%s'", __FUNCTION__, channel.GetChannelName().c_str());
+        m_channels.AddAlternativeStreamURLs(channelUidPair->second, channel, currentChannelGroupIdList, m_channelGroups);
+      }
+      else
+      {
+        m_channels.AddChannel(channel, currentChannelGroupIdList, m_channelGroups);
+        if (!channel.GetTvgId().empty())
+          channelUidsByTvgIdAndName.insert({tvgIdAndName, channel.GetUniqueId()});
+      }
 
       tmpChannel.Reset();
       isRealTime = true;
@@ -330,6 +374,11 @@ void PlaylistLoader::ParseSinglePropertyIntoChannel(const std::string& line, Cha
     {
       prop = PVR_STREAM_PROPERTY_INPUTSTREAM;
     }
+    else if (markerName == KODIPROP_MARKER && prop == ALTERNATIVE_URL_PROPERTY)
+    {
+      channel.AddAlternativeStreamURL(propValue);
+      addProperty = false;
+    }
 
     if (addProperty)
       channel.AddProperty(prop, propValue);
@@ -338,25 +387,6 @@ void PlaylistLoader::ParseSinglePropertyIntoChannel(const std::string& line, Cha
   }
 }
 
-void PlaylistLoader::ReloadPlayList()
-{
-  m_m3uLocation = Settings::GetInstance().GetM3ULocation();
-
-  m_channels.Clear();
-  m_channelGroups.Clear();
-
-  if (LoadPlayList())
-  {
-    m_client->TriggerChannelUpdate();
-    m_client->TriggerChannelGroupsUpdate();
-  }
-  else
-  {
-    m_channels.ChannelsLoadFailed();
-    m_channelGroups.ChannelGroupsLoadFailed();
-  }
-}
-
 std::string PlaylistLoader::ReadMarkerValue(const std::string& line, const std::string& markerName)
 {
   size_t markerStart = line.find(markerName);
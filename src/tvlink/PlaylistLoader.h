@@ -10,6 +10,7 @@
 
 #include "Channels.h"
 #include "ChannelGroups.h"
+#include "utilities/CancellationToken.h"
 
 #include <string>
 
@@ -40,16 +41,19 @@ namespace tvlink
   static const std::string EXTVLCOPT_DASH_MARKER   = "#EXTVLCOPT--";
   static const std::string RADIO_MARKER            = "radio=";
   static const std::string PLAYLIST_TYPE_MARKER    = "#EXT-X-PLAYLIST-TYPE:";
+  static const std::string ALTERNATIVE_URL_PROPERTY = "alternative-url"; // #KODIPROP:alternative-url=, may be repeated
 
   class PlaylistLoader
   {
   public:
-    PlaylistLoader(kodi::addon::CInstancePVRClient* client, tvlink::Channels& channels, tvlink::ChannelGroups& channelGroups);
+    PlaylistLoader(tvlink::Channels& channels, tvlink::ChannelGroups& channelGroups,
+                   const utilities::CancellationToken& token = utilities::CancellationToken());
 
     bool Init();
 
     bool LoadPlayList();
-    void ReloadPlayList();
+    bool FetchPlayList(std::string& playlistContent);
+    bool ParsePlayList(const std::string& playlistContent);
 
   private:
     static std::string ReadMarkerValue(const std::string& line, const std::string& markerName);
@@ -60,9 +64,9 @@ namespace tvlink
 
     std::string m_m3uLocation;
     std::string m_logoLocation;
+    utilities::CancellationToken m_cancellationToken;
 
     tvlink::ChannelGroups& m_channelGroups;
     tvlink::Channels& m_channels;
-    kodi::addon::CInstancePVRClient* m_client;
   };
 } //namespace tvlink
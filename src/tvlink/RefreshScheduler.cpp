@@ -0,0 +1,83 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "RefreshScheduler.h"
+
+using namespace tvlink;
+
+RefreshScheduler::RefreshScheduler()
+  : m_randomGenerator(std::random_device{}())
+{
+  m_scheduled.fill(false);
+}
+
+void RefreshScheduler::Schedule(RefreshTask task, std::chrono::seconds delay, std::chrono::seconds maxJitter)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  // Jitter keeps refreshes from many clients from hitting the server at the same moment
+  std::chrono::seconds jitter(0);
+  if (maxJitter.count() > 0)
+    jitter = std::chrono::seconds(std::uniform_int_distribution<long long>(0, maxJitter.count())(m_randomGenerator));
+
+  const int index = static_cast<int>(task);
+  const Clock::time_point deadline = Clock::now() + delay + jitter;
+  if (m_scheduled[index] && m_deadlines[index] <= deadline)
+    return;
+
+  m_deadlines[index] = deadline;
+  m_scheduled[index] = true;
+  m_condition.notify_all();
+}
+
+void RefreshScheduler::Cancel(RefreshTask task)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_scheduled[static_cast<int>(task)] = false;
+}
+
+bool RefreshScheduler::WaitForNextTask(RefreshTask& task)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  while (!m_stopped)
+  {
+    int next = -1;
+    for (int i = 0; i < TASK_COUNT; i++)
+    {
+      if (m_scheduled[i] && (next < 0 || m_deadlines[i] < m_deadlines[next]))
+        next = i;
+    }
+
+    if (next < 0)
+    {
+      m_condition.wait(lock);
+    }
+    else if (m_deadlines[next] <= Clock::now())
+    {
+      m_scheduled[next] = false;
+      task = static_cast<RefreshTask>(next);
+      return true;
+    }
+    else
+    {
+      m_condition.wait_until(lock, m_deadlines[next]);
+    }
+  }
+
+  return false;
+}
+
+void RefreshScheduler::Stop()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_stopped = true;
+  m_condition.notify_all();
+}
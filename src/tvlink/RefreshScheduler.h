@@ -0,0 +1,66 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+
+namespace tvlink
+{
+  enum class RefreshTask
+    : int
+  {
+    PLAYLIST = 0,
+    EPG,
+    CACHE_REVALIDATION,
+    CACHE_EVICTION,
+    PREWARM_EXPIRY,
+    STREAM_STATS
+  };
+
+  /**
+   * Keeps one deadline per refresh task and wakes the update thread when the
+   * earliest one is due. Scheduling and stopping notify the waiting thread
+   * straight away so there is no polling interval.
+   */
+  class RefreshScheduler
+  {
+  public:
+    RefreshScheduler();
+
+    /**
+     * Schedule a task to run after delay plus a random jitter of up to maxJitter.
+     * If the task already has an earlier deadline that one is kept.
+     */
+    void Schedule(RefreshTask task, std::chrono::seconds delay, std::chrono::seconds maxJitter = std::chrono::seconds(0));
+    void Cancel(RefreshTask task);
+
+    /**
+     * Block until a task is due, returns false once the scheduler has been stopped.
+     */
+    bool WaitForNextTask(RefreshTask& task);
+    void Stop();
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    static const int TASK_COUNT = static_cast<int>(RefreshTask::STREAM_STATS) + 1;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::array<Clock::time_point, TASK_COUNT> m_deadlines;
+    std::array<bool, TASK_COUNT> m_scheduled;
+    bool m_stopped = false;
+
+    std::mt19937 m_randomGenerator;
+  };
+} //namespace tvlink
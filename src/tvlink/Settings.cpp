@@ -28,7 +28,16 @@ void Settings::ReadFromAddon(const std::string& userPath, const std::string& cli
   m_tvlinkToken = kodi::addon::GetSettingString("tvlinkToken");
   m_connectTimeout = kodi::addon::GetSettingInt("connectTimeout", 10);
   m_curlBuff = kodi::addon::GetSettingBoolean("curlBuff", false);
+  m_readAhead = kodi::addon::GetSettingBoolean("readAhead", false);
+  m_readAheadSizeMB = kodi::addon::GetSettingInt("readAheadSizeMB", 8);
+  m_readAheadPrefillPercent = kodi::addon::GetSettingInt("readAheadPrefillPercent", 25);
+  m_prewarmStreams = kodi::addon::GetSettingInt("prewarmStreams", 0);
+  m_prewarmIdleTimeoutSecs = kodi::addon::GetSettingInt("prewarmIdleTimeoutSecs", 15);
+  m_timeshift = kodi::addon::GetSettingBoolean("timeshift", false);
+  m_timeshiftSizeMB = kodi::addon::GetSettingInt("timeshiftSizeMB", 512);
+  m_timeshiftPath = kodi::addon::GetSettingString("timeshiftPath");
   m_useFFmpeg = kodi::addon::GetSettingBoolean("useFFmpeg", false);
+  m_asyncStartup = kodi::addon::GetSettingBoolean("asyncStartup", false);
 
   // M3U
   if (m_useFFmpeg)
@@ -82,6 +91,10 @@ ADDON_STATUS Settings::SetValue(const std::string& settingName, const kodi::addo
   if (FileUtils::FileExists(strFile))
     FileUtils::DeleteFile(strFile);
 
+  strFile = FileUtils::GetUserDataAddonFilePath(CHANNELS_SNAPSHOT_FILENAME);
+  if (FileUtils::FileExists(strFile))
+    FileUtils::DeleteFile(strFile);
+
   // TVLINK
   if (settingName == "tvlinkIP")
     return SetStringSetting<ADDON_STATUS>(settingName, settingValue, m_tvlinkIP, ADDON_STATUS_OK, ADDON_STATUS_OK);
@@ -95,6 +108,25 @@ ADDON_STATUS Settings::SetValue(const std::string& settingName, const kodi::addo
     return SetSetting<int, ADDON_STATUS>(settingName, settingValue, m_startChannelNumber, ADDON_STATUS_OK, ADDON_STATUS_OK);
   else if (settingName == "numberByOrder")
     return SetSetting<bool, ADDON_STATUS>(settingName, settingValue, m_numberChannelsByM3uOrderOnly, ADDON_STATUS_OK, ADDON_STATUS_OK);
+  else if (settingName == "asyncStartup")
+    return SetSetting<bool, ADDON_STATUS>(settingName, settingValue, m_asyncStartup, ADDON_STATUS_OK, ADDON_STATUS_OK);
+  // Stream control
+  else if (settingName == "readAhead")
+    return SetSetting<bool, ADDON_STATUS>(settingName, settingValue, m_readAhead, ADDON_STATUS_OK, ADDON_STATUS_OK);
+  else if (settingName == "readAheadSizeMB")
+    return SetSetting<int, ADDON_STATUS>(settingName, settingValue, m_readAheadSizeMB, ADDON_STATUS_OK, ADDON_STATUS_OK);
+  else if (settingName == "readAheadPrefillPercent")
+    return SetSetting<int, ADDON_STATUS>(settingName, settingValue, m_readAheadPrefillPercent, ADDON_STATUS_OK, ADDON_STATUS_OK);
+  else if (settingName == "prewarmStreams")
+    return SetSetting<int, ADDON_STATUS>(settingName, settingValue, m_prewarmStreams, ADDON_STATUS_OK, ADDON_STATUS_OK);
+  else if (settingName == "prewarmIdleTimeoutSecs")
+    return SetSetting<int, ADDON_STATUS>(settingName, settingValue, m_prewarmIdleTimeoutSecs, ADDON_STATUS_OK, ADDON_STATUS_OK);
+  else if (settingName == "timeshift")
+    return SetSetting<bool, ADDON_STATUS>(settingName, settingValue, m_timeshift, ADDON_STATUS_OK, ADDON_STATUS_OK);
+  else if (settingName == "timeshiftSizeMB")
+    return SetSetting<int, ADDON_STATUS>(settingName, settingValue, m_timeshiftSizeMB, ADDON_STATUS_OK, ADDON_STATUS_OK);
+  else if (settingName == "timeshiftPath")
+    return SetStringSetting<ADDON_STATUS>(settingName, settingValue, m_timeshiftPath, ADDON_STATUS_OK, ADDON_STATUS_OK);
   else if (settingName == "m3uRefreshMode")
     return SetEnumSetting<RefreshMode, ADDON_STATUS>(settingName, settingValue, m_m3uRefreshMode, ADDON_STATUS_OK, ADDON_STATUS_OK);
   else if (settingName == "m3uRefreshIntervalMins")
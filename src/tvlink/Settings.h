@@ -20,6 +20,9 @@ namespace tvlink
 {
   static const std::string M3U_CACHE_FILENAME = "iptv.m3u.cache";
   static const std::string XMLTV_CACHE_FILENAME = "xmltv.xml.cache";
+  static const std::string CHANNELS_SNAPSHOT_FILENAME = "channels.snapshot";
+  static const std::string STREAM_ENTRIES_CACHE_FILENAME = "streamEntries.cache";
+  static const std::string TIMESHIFT_FILENAME = "timeshift.buffer";
   static const std::string ADDON_DATA_BASE_DIR = "special://userdata/addon_data/pvr.tvlink";
   static const std::string DEFAULT_GENRE_TEXT_MAP_FILE = ADDON_DATA_BASE_DIR + "/genres/genreTextMappings/genres.xml";
   static const int DEFAULT_UDPXY_MULTICAST_RELAY_PORT = 4022;
@@ -78,6 +81,15 @@ namespace tvlink
     int GetM3URefreshHour() const { return m_m3uRefreshHour; }
     int GetConnectTimeout() const { return m_connectTimeout; }
     bool GetCurlBuffering() const { return m_curlBuff; }
+    bool UseReadAhead() const { return m_readAhead; }
+    size_t GetReadAheadBytes() const { return static_cast<size_t>(m_readAheadSizeMB) * 1024 * 1024; }
+    size_t GetReadAheadPrefillBytes() const { return GetReadAheadBytes() * m_readAheadPrefillPercent / 100; }
+    int GetPrewarmStreams() const { return m_prewarmStreams; }
+    int GetPrewarmIdleTimeoutSecs() const { return m_prewarmIdleTimeoutSecs; }
+    bool UseTimeshift() const { return m_timeshift; }
+    size_t GetTimeshiftBytes() const { return static_cast<size_t>(m_timeshiftSizeMB) * 1024 * 1024; }
+    const std::string& GetTimeshiftPath() const { return m_timeshiftPath.empty() ? m_userPath : m_timeshiftPath; }
+    bool UseAsyncStartup() const { return m_asyncStartup; }
 
     const std::string& GetEpgLocation() const
     {
@@ -206,7 +218,16 @@ namespace tvlink
     std::string m_tvlinkList;
     int m_connectTimeout = 10;
     bool m_curlBuff = false;
+    bool m_readAhead = false;
+    int m_readAheadSizeMB = 8;
+    int m_readAheadPrefillPercent = 25;
+    int m_prewarmStreams = 0;
+    int m_prewarmIdleTimeoutSecs = 15;
+    bool m_timeshift = false;
+    int m_timeshiftSizeMB = 512;
+    std::string m_timeshiftPath;
     bool m_useFFmpeg = false;
+    bool m_asyncStartup = false;
 
     // M3U
     PathType m_m3uPathType = PathType::REMOTE_PATH;
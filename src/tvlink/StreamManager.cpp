@@ -8,56 +8,260 @@
 
 #include "StreamManager.h"
 
+#include "Settings.h"
+#include "utilities/BinaryUtils.h"
+#include "utilities/FileUtils.h"
+#include "utilities/HashUtils.h"
 #include "utilities/Logger.h"
 #include "utilities/StreamUtils.h"
 
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include <kodi/Filesystem.h>
+
 using namespace tvlink;
 using namespace tvlink::data;
 using namespace tvlink::utilities;
 
+namespace
+{
+
+const uint32_t STREAM_ENTRIES_MAGIC = 0x454C5654; // "TVLE"
+const uint32_t STREAM_ENTRIES_FORMAT_VERSION = 3;
+
+struct StreamEntriesHeader
+{
+  uint32_t magic;
+  uint32_t formatVersion;
+  uint64_t payloadHash;
+};
+
+} // unnamed namespace
+
 StreamManager::StreamManager() {}
 
 void StreamManager::Clear()
 {
-  m_streamEntryCache.clear();
+  for (Shard& shard : m_shards)
+  {
+    std::lock_guard<std::mutex> lock(shard.m_mutex);
+    m_entryCount -= shard.m_entries.size();
+    shard.m_entries.clear();
+    shard.m_entriesByKey.clear();
+  }
+
+  m_entriesChanged = true;
 }
 
-void StreamManager::AddUpdateStreamEntry(const std::string& streamKey, const StreamType& streamType, const std::string& mimeType)
+int StreamManager::EvictStaleEntries(time_t maxIdleSecs)
 {
-  std::shared_ptr<StreamEntry> foundStreamEntry = GetStreamEntry(streamKey);
+  const time_t now = std::time(nullptr);
+  const time_t oldestAccessTime = now - maxIdleSecs;
+  int evicted = 0;
 
-  if (!foundStreamEntry)
+  for (Shard& shard : m_shards)
   {
-    std::shared_ptr<StreamEntry> newStreamEntry = std::make_shared<StreamEntry>();
-    newStreamEntry->SetStreamKey(streamKey);
-    newStreamEntry->SetStreamType(streamType);
-    newStreamEntry->SetMimeType(mimeType);
-    newStreamEntry->SetLastAccessTime(std::time(nullptr));
-
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_streamEntryCache.insert({streamKey, newStreamEntry});
+    std::lock_guard<std::mutex> lock(shard.m_mutex);
+
+    for (auto it = shard.m_entries.begin(); it != shard.m_entries.end();)
+    {
+      if (it->GetLastAccessTime() < oldestAccessTime || IsExpired(*it, now))
+      {
+        shard.m_entriesByKey.erase(it->GetStreamKey());
+        it = shard.m_entries.erase(it);
+        m_entryCount--;
+        evicted++;
+      }
+      else
+      {
+        ++it;
+      }
+    }
   }
-  else
+
+  if (evicted > 0)
+    m_entriesChanged = true;
+
+  return evicted;
+}
+
+bool StreamManager::LoadEntries()
+{
+  const std::string cachePath = FileUtils::GetUserDataAddonFilePath(STREAM_ENTRIES_CACHE_FILENAME);
+  if (!FileUtils::FileExists(cachePath))
+    return false;
+
+  std::lock_guard<std::mutex> persistLock(m_persistMutex);
+
+  kodi::vfs::CFile file;
+  if (!file.OpenFile(cachePath, ADDON_READ_NO_CACHE))
+    return false;
+
+  StreamEntriesHeader header;
+  const int64_t length = file.GetLength();
+  if (length < static_cast<int64_t>(sizeof(header)) ||
+      file.Read(&header, sizeof(header)) != static_cast<ssize_t>(sizeof(header)) ||
+      header.magic != STREAM_ENTRIES_MAGIC || header.formatVersion != STREAM_ENTRIES_FORMAT_VERSION)
+  {
+    Logger::Log(LEVEL_DEBUG, "%s - Ignoring stream entries cache with unknown format", __FUNCTION__);
+    return false;
+  }
+
+  std::string payload(static_cast<size_t>(length) - sizeof(header), '\0');
+  if (file.Read(&payload[0], payload.size()) != static_cast<ssize_t>(payload.size()) || Fnv1a64(payload) != header.payloadHash)
+  {
+    Logger::Log(LEVEL_ERROR, "%s - Stream entries cache is corrupt: %s", __FUNCTION__, cachePath.c_str());
+    return false;
+  }
+  file.Close();
+
+  BinaryReader reader(payload);
+  const time_t now = std::time(nullptr);
+  uint32_t entryCount = 0;
+  int loaded = 0;
+  reader.Read(entryCount);
+
+  // Everything that was saved fits, the cap is sized again when the playlist is probed
+  m_maxEntries = std::max<size_t>(m_maxEntries, entryCount);
+
+  // Entries were written least recently used first, so adding them in order
+  // rebuilds the same recency within each shard
+  for (uint32_t i = 0; i < entryCount && reader.IsOk(); i++)
   {
-    foundStreamEntry->SetStreamType(streamType);
-    foundStreamEntry->SetLastAccessTime(std::time(nullptr));
+    StreamEntry streamEntry;
+    if (!streamEntry.ReadSnapshot(reader))
+      return false;
+
+    if (!IsExpired(streamEntry, now))
+    {
+      AddUpdateStreamEntry(streamEntry);
+      loaded++;
+    }
   }
+
+  m_entriesChanged = loaded != static_cast<int>(entryCount);
+
+  Logger::Log(LEVEL_INFO, "%s - Loaded %d cached stream entries", __FUNCTION__, loaded);
+
+  return reader.IsOk();
 }
 
-bool StreamManager::HasStreamEntry(const std::string& streamKey) const
+bool StreamManager::SaveEntries()
 {
-  return GetStreamEntry(streamKey) != nullptr;
+  std::lock_guard<std::mutex> persistLock(m_persistMutex);
+
+  if (!m_entriesChanged.exchange(false))
+    return true;
+
+  std::vector<StreamEntry> streamEntries;
+  for (Shard& shard : m_shards)
+  {
+    std::lock_guard<std::mutex> lock(shard.m_mutex);
+    streamEntries.insert(streamEntries.end(), shard.m_entries.rbegin(), shard.m_entries.rend());
+  }
+
+  std::string payload;
+  BinaryWriter writer(payload);
+
+  writer.Write(static_cast<uint32_t>(streamEntries.size()));
+  for (const auto& streamEntry : streamEntries)
+    streamEntry.WriteSnapshot(writer);
+
+  StreamEntriesHeader header = {STREAM_ENTRIES_MAGIC, STREAM_ENTRIES_FORMAT_VERSION, Fnv1a64(payload)};
+
+  const std::string cachePath = FileUtils::GetUserDataAddonFilePath(STREAM_ENTRIES_CACHE_FILENAME);
+  const std::string tempPath = cachePath + ".tmp";
+
+  kodi::vfs::CFile file;
+  bool written = file.OpenFileForWrite(tempPath, true) &&
+                 file.Write(&header, sizeof(header)) == static_cast<ssize_t>(sizeof(header)) &&
+                 file.Write(payload.data(), payload.size()) == static_cast<ssize_t>(payload.size());
+  file.Close();
+
+  if (!written || !kodi::vfs::RenameFile(tempPath, cachePath))
+  {
+    Logger::Log(LEVEL_ERROR, "%s - Could not write stream entries cache: %s", __FUNCTION__, cachePath.c_str());
+    kodi::vfs::DeleteFile(tempPath);
+    m_entriesChanged = true;
+    return false;
+  }
+
+  Logger::Log(LEVEL_DEBUG, "%s - Saved %d stream entries", __FUNCTION__, static_cast<int>(streamEntries.size()));
+
+  return true;
 }
 
-std::shared_ptr<StreamEntry> StreamManager::GetStreamEntry(const std::string streamKey) const
+StreamManager::Shard& StreamManager::GetShard(const std::string& streamKey)
 {
-  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_shards[std::hash<std::string>()(streamKey) % SHARD_COUNT];
+}
 
-  auto streamEntryPair = m_streamEntryCache.find(streamKey);
-  if (streamEntryPair != m_streamEntryCache.end())
-    return streamEntryPair->second;
+bool StreamManager::IsExpired(const StreamEntry& streamEntry, time_t now)
+{
+  return streamEntry.GetInspectedTime() < now - STREAM_ENTRY_TTL_SECS;
+}
 
-  return {};
+void StreamManager::AddUpdateStreamEntry(const StreamEntry& streamEntry)
+{
+  Shard& shard = GetShard(streamEntry.GetStreamKey());
+
+  std::lock_guard<std::mutex> lock(shard.m_mutex);
+
+  auto streamEntryPair = shard.m_entriesByKey.find(streamEntry.GetStreamKey());
+  if (streamEntryPair != shard.m_entriesByKey.end())
+  {
+    *streamEntryPair->second = streamEntry;
+    shard.m_entries.splice(shard.m_entries.begin(), shard.m_entries, streamEntryPair->second);
+  }
+  else
+  {
+    shard.m_entries.push_front(streamEntry);
+    shard.m_entriesByKey.insert({streamEntry.GetStreamKey(), shard.m_entries.begin()});
+
+    m_entryCount++;
+
+    // Only a full cache gives up entries, the keys spread evenly over the
+    // shards so the oldest of this one stand in for the oldest overall
+    while (m_entryCount > m_maxEntries && shard.m_entries.size() > 1)
+    {
+      shard.m_entriesByKey.erase(shard.m_entries.back().GetStreamKey());
+      shard.m_entries.pop_back();
+      m_entryCount--;
+    }
+  }
+
+  m_entriesChanged = true;
+}
+
+bool StreamManager::GetStreamEntry(const std::string& streamKey, StreamEntry& streamEntry)
+{
+  Shard& shard = GetShard(streamKey);
+  const time_t now = std::time(nullptr);
+
+  std::lock_guard<std::mutex> lock(shard.m_mutex);
+
+  auto streamEntryPair = shard.m_entriesByKey.find(streamKey);
+  if (streamEntryPair == shard.m_entriesByKey.end())
+    return false;
+
+  auto entry = streamEntryPair->second;
+  if (IsExpired(*entry, now))
+  {
+    shard.m_entries.erase(entry);
+    shard.m_entriesByKey.erase(streamEntryPair);
+    m_entryCount--;
+    m_entriesChanged = true;
+    return false;
+  }
+
+  entry->SetLastAccessTime(now);
+  shard.m_entries.splice(shard.m_entries.begin(), shard.m_entries, entry);
+  m_entriesChanged = true;
+
+  streamEntry = *entry;
+  return true;
 }
 
 StreamType StreamManager::StreamTypeLookup(const Channel& channel, const std::string& streamTestUrl, const std::string& streamKey)
@@ -67,25 +271,89 @@ StreamType StreamManager::StreamTypeLookup(const Channel& channel, const std::st
 
 StreamEntry StreamManager::StreamEntryLookup(const Channel& channel, const std::string& streamTestUrl, const std::string& streamKey)
 {
-  std::shared_ptr<StreamEntry> streamEntry = GetStreamEntry(streamKey);
+  StreamEntry streamEntry;
 
-  if (!streamEntry)
+  // Inspecting a stream over the network is left to the background prober, until
+  // it has an answer the type is taken from the shape of the URL. That guess is
+  // cheap and not cached, so it never stops the prober from filling in the key.
+  if (!GetStreamEntry(streamKey, streamEntry))
   {
-    StreamType streamType = StreamUtils::GetStreamType(streamTestUrl, channel);
-    if (streamType == StreamType::OTHER_TYPE)
-      streamType = StreamUtils::InspectStreamType(streamTestUrl, channel);
-
-    streamEntry = std::make_shared<StreamEntry>();
-    streamEntry->SetStreamKey(streamKey);
-    streamEntry->SetStreamType(streamType);
-    streamEntry->SetMimeType(StreamUtils::GetMimeType(streamType));
+    const StreamType streamType = StreamUtils::GetStreamType(streamTestUrl, channel);
+
+    streamEntry.SetStreamKey(streamKey);
+    streamEntry.SetStreamType(streamType);
+    streamEntry.SetMimeType(StreamUtils::GetMimeType(streamType));
   }
 
   // If a channel has a MIME Type we always override with that
   if (channel.HasMimeType())
-    streamEntry->SetMimeType(channel.GetMimeType());
+    streamEntry.SetMimeType(channel.GetMimeType());
 
-  AddUpdateStreamEntry(streamEntry->GetStreamKey(), streamEntry->GetStreamType(), streamEntry->GetMimeType());
+  return streamEntry;
+}
+
+void StreamManager::AddProbedStreamEntry(const std::string& streamKey, const StreamType& streamType, bool reachable, int firstByteMillis)
+{
+  const time_t now = std::time(nullptr);
 
-  return *streamEntry;
+  StreamEntry streamEntry;
+  streamEntry.SetStreamKey(streamKey);
+  streamEntry.SetStreamType(streamType);
+  streamEntry.SetMimeType(StreamUtils::GetMimeType(streamType));
+  streamEntry.SetLastAccessTime(now);
+  streamEntry.SetInspectedTime(now);
+  streamEntry.SetReachable(reachable);
+  streamEntry.SetFirstByteMillis(firstByteMillis);
+
+  // What was learned from playing the stream outlives a new probe
+  streamEntry.SetBitrateKbps(GetStreamBitrate(streamKey));
+
+  AddUpdateStreamEntry(streamEntry);
+}
+
+bool StreamManager::HasFreshStreamEntry(const std::string& streamKey)
+{
+  Shard& shard = GetShard(streamKey);
+
+  std::lock_guard<std::mutex> lock(shard.m_mutex);
+
+  auto streamEntryPair = shard.m_entriesByKey.find(streamKey);
+  return streamEntryPair != shard.m_entriesByKey.end() && !IsExpired(*streamEntryPair->second, std::time(nullptr));
+}
+
+int StreamManager::GetStreamBitrate(const std::string& streamKey)
+{
+  Shard& shard = GetShard(streamKey);
+
+  std::lock_guard<std::mutex> lock(shard.m_mutex);
+
+  auto streamEntryPair = shard.m_entriesByKey.find(streamKey);
+  return streamEntryPair != shard.m_entriesByKey.end() ? streamEntryPair->second->GetBitrateKbps() : 0;
+}
+
+void StreamManager::SetStreamBitrate(const std::string& streamKey, int bitrateKbps)
+{
+  Shard& shard = GetShard(streamKey);
+
+  std::lock_guard<std::mutex> lock(shard.m_mutex);
+
+  // Only kept with an inspected entry, the prober adds one for every channel
+  auto streamEntryPair = shard.m_entriesByKey.find(streamKey);
+  if (streamEntryPair == shard.m_entriesByKey.end() || streamEntryPair->second->GetBitrateKbps() == bitrateKbps)
+    return;
+
+  streamEntryPair->second->SetBitrateKbps(bitrateKbps);
+  m_entriesChanged = true;
+}
+
+void StreamManager::SetChannelCount(size_t channelCount)
+{
+  // Room for every channel plus the keys of the previous playlist, which
+  // are only evicted once they are the least recently used
+  m_maxEntries = std::max(MIN_MAX_ENTRIES, channelCount * 2);
+}
+
+std::string StreamManager::GetStreamKey(const Channel& channel)
+{
+  return std::to_string(channel.GetUniqueId()) + "-" + channel.GetStreamURL();
 }
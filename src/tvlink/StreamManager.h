@@ -11,28 +11,66 @@
 #include "data/Channel.h"
 #include "data/StreamEntry.h"
 
-#include <map>
+#include <array>
+#include <atomic>
+#include <ctime>
+#include <list>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 
 namespace tvlink
 {
+  /**
+   * Caches the stream type of each stream key. Lookups never go to the network,
+   * the types are inspected by the StreamProber in the background. The cache is a bounded LRU split into
+   * shards by key hash, so concurrent lookups of different streams rarely share
+   * a lock. The bound is for the whole cache and grows with the playlist, so
+   * every channel keeps its entry. Entries expire a fixed time after they were
+   * inspected and the cache is persisted to the user data directory so it
+   * survives restarts.
+   */
   class StreamManager
   {
   public:
     StreamManager();
 
     StreamType StreamTypeLookup(const data::Channel& channel, const std::string& streamTestUrl, const std::string& streamKey);
+    void AddProbedStreamEntry(const std::string& streamKey, const StreamType& streamType, bool reachable, int firstByteMillis);
+    bool HasFreshStreamEntry(const std::string& streamKey); // Does not count as an access
+    int GetStreamBitrate(const std::string& streamKey); // 0 if unknown, does not count as an access
+    void SetStreamBitrate(const std::string& streamKey, int bitrateKbps);
+    static std::string GetStreamKey(const data::Channel& channel);
+    void SetChannelCount(size_t channelCount); // Sizes the cache for a loaded playlist
     void Clear();
+    int EvictStaleEntries(time_t maxIdleSecs);
+
+    bool LoadEntries();
+    bool SaveEntries(); // Only writes when the entries changed since the last load or save
 
   private:
-    void AddUpdateStreamEntry(const std::string& streamKey, const StreamType& streamType, const std::string& mimeType);
-    bool HasStreamEntry(const std::string& streamKey) const;
-    std::shared_ptr<data::StreamEntry> GetStreamEntry(const std::string streamKey) const;
+    static constexpr size_t SHARD_COUNT = 16;
+    static constexpr size_t MIN_MAX_ENTRIES = 4096;
+    static constexpr time_t STREAM_ENTRY_TTL_SECS = 7 * 24 * 60 * 60;
+
+    struct Shard
+    {
+      std::mutex m_mutex;
+      std::list<data::StreamEntry> m_entries; // most recently used first
+      std::unordered_map<std::string, std::list<data::StreamEntry>::iterator> m_entriesByKey;
+    };
+
+    Shard& GetShard(const std::string& streamKey);
+    void AddUpdateStreamEntry(const data::StreamEntry& streamEntry);
+    bool GetStreamEntry(const std::string& streamKey, data::StreamEntry& streamEntry);
     data::StreamEntry StreamEntryLookup(const data::Channel& channel, const std::string& streamTestUrl, const std::string& streamKey);
 
-    mutable std::mutex m_mutex;
+    static bool IsExpired(const data::StreamEntry& streamEntry, time_t now);
 
-    std::map<std::string, std::shared_ptr<data::StreamEntry>> m_streamEntryCache;
+    std::array<Shard, SHARD_COUNT> m_shards;
+    std::atomic<size_t> m_maxEntries{MIN_MAX_ENTRIES};
+    std::atomic<size_t> m_entryCount{0};
+    std::atomic<bool> m_entriesChanged{false};
+    std::mutex m_persistMutex;
   };
 } //namespace tvlink
@@ -0,0 +1,17 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "StreamPrewarmer.h"
+
+#include "LiveStream.h"
+
+using namespace tvlink;
+
+StreamPrewarmer::StreamPrewarmer() : BasicStreamPrewarmer(LiveStream::OpenHandle)
+{
+}
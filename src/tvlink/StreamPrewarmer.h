@@ -0,0 +1,210 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "utilities/CancellationToken.h"
+#include "utilities/Logger.h"
+#include "utilities/WebUtils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <kodi/Filesystem.h>
+
+namespace tvlink
+{
+  /**
+   * Keeps already connected handles for the channels the user is likely to zap
+   * to next, so opening one of them skips the connect, redirects and wait for the
+   * first bytes. Each warm handle holds a stream on the server, so there is a
+   * budget on how many are kept and they are closed after an idle timeout.
+   *
+   * The handle type and how one is connected are template parameters so the
+   * benchmarks can run the same logic against a stand-in server, the add-on
+   * uses StreamPrewarmer below. A handle only needs a Close().
+   */
+  template<typename Handle>
+  class BasicStreamPrewarmer
+  {
+  public:
+    using ConnectFunction = std::function<std::unique_ptr<Handle>(const std::string& url, unsigned int flags, int connectTimeoutSecs)>;
+
+    explicit BasicStreamPrewarmer(ConnectFunction connect) : m_connect(std::move(connect)) {}
+
+    // Keep only the handles of these channels, all others are closed
+    void Retain(const std::vector<int>& channelUids)
+    {
+      std::vector<WarmHandle> closedHandles;
+
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto retained = std::stable_partition(m_handles.begin(), m_handles.end(), [&channelUids](const WarmHandle& handle) {
+          return std::find(channelUids.begin(), channelUids.end(), handle.m_channelUid) != channelUids.end();
+        });
+
+        std::move(retained, m_handles.end(), std::back_inserter(closedHandles));
+        m_handles.erase(retained, m_handles.end());
+      }
+
+      // Closing can block on the network, so it happens outside the lock
+      for (auto& handle : closedHandles)
+      {
+        if (handle.m_file)
+          handle.m_file->Close();
+      }
+    }
+
+    // Opens a handle unless the channel is already warm or the budget is used up,
+    // blocks for the connect so it is meant to run on a pool task. The connect
+    // is cut short at MAX_CONNECT_TIMEOUT_SECS and dropped if the token is
+    // cancelled meanwhile.
+    void Warm(int channelUid, const std::string& url, unsigned int flags, int connectTimeoutSecs, size_t budget,
+              const utilities::CancellationToken& token)
+    {
+      if (token.IsCancelled())
+        return;
+
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_handles.size() >= budget ||
+            std::any_of(m_handles.begin(), m_handles.end(), [channelUid](const WarmHandle& handle) { return handle.m_channelUid == channelUid; }))
+          return;
+
+        // Reserve the slot while connecting so the budget also covers pending opens
+        m_handles.push_back({channelUid, url, nullptr, Clock::now()});
+      }
+
+      auto started = Clock::now();
+      std::unique_ptr<Handle> file = m_connect(url, flags, std::min(connectTimeoutSecs, MAX_CONNECT_TIMEOUT_SECS));
+      const int milliseconds = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - started).count());
+
+      std::unique_lock<std::mutex> lock(m_mutex);
+
+      auto handle = std::find_if(m_handles.begin(), m_handles.end(), [channelUid](const WarmHandle& handle) {
+        return handle.m_channelUid == channelUid && !handle.m_file;
+      });
+
+      // The reservation is gone if the user zapped elsewhere meanwhile
+      if (!file || handle == m_handles.end() || token.IsCancelled())
+      {
+        if (handle != m_handles.end())
+          m_handles.erase(handle);
+        lock.unlock();
+
+        if (file)
+          file->Close();
+        return;
+      }
+
+      handle->m_file = std::move(file);
+      handle->m_openedTime = Clock::now();
+
+      utilities::Logger::Log(utilities::LEVEL_DEBUG, "%s - Pre-warmed channel %d in %d (ms): %s", __FUNCTION__, channelUid, milliseconds,
+                             utilities::WebUtils::RedactUrl(url).c_str());
+    }
+
+    // Hands over the warm handle for the channel if there is a fresh one for this URL
+    std::unique_ptr<Handle> Adopt(int channelUid, const std::string& url, std::chrono::seconds idleTimeout)
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      auto handle = std::find_if(m_handles.begin(), m_handles.end(), [channelUid, &url](const WarmHandle& handle) {
+        return handle.m_channelUid == channelUid && handle.m_url == url && handle.m_file;
+      });
+
+      if (handle == m_handles.end() || Clock::now() - handle->m_openedTime > idleTimeout)
+      {
+        m_misses++;
+        return {};
+      }
+
+      std::unique_ptr<Handle> file = std::move(handle->m_file);
+      m_handles.erase(handle);
+      m_hits++;
+
+      return file;
+    }
+
+    // Returns how many handles are still warm afterwards
+    int ExpireIdle(std::chrono::seconds idleTimeout)
+    {
+      std::vector<WarmHandle> expiredHandles;
+      int remaining = 0;
+
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const Clock::time_point oldestOpenedTime = Clock::now() - idleTimeout;
+        auto expired = std::stable_partition(m_handles.begin(), m_handles.end(), [oldestOpenedTime](const WarmHandle& handle) {
+          return !handle.m_file || handle.m_openedTime >= oldestOpenedTime;
+        });
+
+        std::move(expired, m_handles.end(), std::back_inserter(expiredHandles));
+        m_handles.erase(expired, m_handles.end());
+        remaining = static_cast<int>(m_handles.size());
+      }
+
+      for (auto& handle : expiredHandles)
+        handle.m_file->Close();
+
+      if (!expiredHandles.empty())
+        utilities::Logger::Log(utilities::LEVEL_DEBUG, "%s - Closed %d idle pre-warmed streams", __FUNCTION__,
+                               static_cast<int>(expiredHandles.size()));
+
+      return remaining;
+    }
+
+    void Clear() { Retain({}); }
+
+    unsigned int GetHits() const { return m_hits; }
+    unsigned int GetMisses() const { return m_misses; }
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    // A slow pre-warm only holds up a pool worker and the shutdown, a zap to
+    // that channel would not have been fast anyway
+    static constexpr int MAX_CONNECT_TIMEOUT_SECS = 3;
+
+    struct WarmHandle
+    {
+      int m_channelUid;
+      std::string m_url;
+      std::unique_ptr<Handle> m_file; // null while still connecting
+      Clock::time_point m_openedTime;
+    };
+
+    const ConnectFunction m_connect;
+
+    std::mutex m_mutex;
+    std::vector<WarmHandle> m_handles;
+
+    std::atomic<unsigned int> m_hits{0};
+    std::atomic<unsigned int> m_misses{0};
+  };
+
+  template<typename Handle>
+  constexpr int BasicStreamPrewarmer<Handle>::MAX_CONNECT_TIMEOUT_SECS;
+
+  // Connects through Kodi's file API with LiveStream::OpenHandle()
+  class StreamPrewarmer : public BasicStreamPrewarmer<kodi::vfs::CFile>
+  {
+  public:
+    StreamPrewarmer();
+  };
+} //namespace tvlink
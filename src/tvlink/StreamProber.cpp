@@ -0,0 +1,80 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "StreamProber.h"
+
+#include "utilities/Logger.h"
+#include "utilities/StreamUtils.h"
+#include "utilities/WebUtils.h"
+
+#include <chrono>
+
+using namespace tvlink;
+using namespace tvlink::data;
+using namespace tvlink::utilities;
+
+int StreamProber::ProbeChannels(const Channels& channels, TaskPool& taskPool, const CancellationToken& token)
+{
+  int submitted = 0;
+
+  m_streamManager.SetChannelCount(channels.GetChannelsList().size());
+
+  for (const auto& channel : channels.GetChannelsList())
+  {
+    if (token.IsCancelled())
+      break;
+
+    if (m_streamManager.HasFreshStreamEntry(StreamManager::GetStreamKey(*channel)))
+      continue;
+
+    // The task holds its own handle, the channel outlives a replaced generation
+    std::shared_ptr<const Channel> probedChannel = channel;
+    taskPool.Submit(TaskCategory::PROBE, token, [this, probedChannel, token] { ProbeChannel(*probedChannel, token); });
+    submitted++;
+  }
+
+  Logger::Log(LEVEL_DEBUG, "%s - Probing %d of %d channel streams", __FUNCTION__, submitted, static_cast<int>(channels.GetChannelsList().size()));
+
+  return submitted;
+}
+
+void StreamProber::ProbeChannel(const Channel& channel, const CancellationToken& token)
+{
+  const std::string& streamUrl = channel.GetStreamURL();
+  const std::string streamKey = StreamManager::GetStreamKey(channel);
+
+  StreamType streamType;
+  const bool classifiedByShape = StreamUtils::GetStreamTypeFromUrlShape(streamUrl, channel, streamType);
+
+  // Only http streams can be read cheaply, anything else keeps the URL based answer
+  if (!WebUtils::IsHttpUrl(streamUrl))
+  {
+    m_streamManager.AddProbedStreamEntry(streamKey, StreamUtils::GetStreamType(streamUrl, channel), true, -1);
+    return;
+  }
+
+  int httpCode = 0;
+  auto started = std::chrono::steady_clock::now();
+  const StreamType inspectedStreamType = StreamUtils::InspectStreamType(streamUrl, channel, PROBE_TIMEOUT_SECS, token, &httpCode);
+  const int firstByteMillis = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                std::chrono::steady_clock::now() - started).count());
+
+  // An abandoned read says nothing about the stream, it is probed again next time
+  if (token.IsCancelled())
+    return;
+
+  const bool reachable = httpCode == 200;
+
+  if (!classifiedByShape)
+    streamType = inspectedStreamType != StreamType::OTHER_TYPE ? inspectedStreamType : StreamUtils::GetStreamType(streamUrl, channel);
+
+  if (!reachable)
+    Logger::Log(LEVEL_DEBUG, "%s - Stream of channel '%s' is not reachable: %s", __FUNCTION__, channel.GetChannelName().c_str(), WebUtils::RedactUrl(streamUrl).c_str());
+
+  m_streamManager.AddProbedStreamEntry(streamKey, streamType, reachable, reachable ? firstByteMillis : -1);
+}
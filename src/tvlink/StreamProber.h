@@ -0,0 +1,46 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "Channels.h"
+#include "StreamManager.h"
+#include "data/Channel.h"
+#include "utilities/CancellationToken.h"
+#include "utilities/TaskPool.h"
+
+#include <memory>
+
+namespace tvlink
+{
+  /**
+   * Classifies the stream of every channel in the background so that playback
+   * only ever reads the answer from the StreamManager. The URL shape decides when
+   * it can, otherwise the head of the stream is read, which also records whether
+   * the stream is reachable and how long the first bytes took. Each channel is a
+   * PROBE task, so the pool's category limit bounds the concurrent reads. The
+   * reads use short timeouts and give up once the token is cancelled, so a
+   * shutdown never waits for a slow server.
+   */
+  class StreamProber
+  {
+  public:
+    StreamProber(StreamManager& streamManager) : m_streamManager(streamManager) {}
+
+    // Returns the number of channels submitted, channels with a fresh entry are skipped
+    int ProbeChannels(const tvlink::Channels& channels, utilities::TaskPool& taskPool, const utilities::CancellationToken& token);
+
+  private:
+    // A probe is only a hint, so a slow server is given up on quickly
+    static constexpr int PROBE_TIMEOUT_SECS = 5;
+
+    void ProbeChannel(const data::Channel& channel, const utilities::CancellationToken& token);
+
+    StreamManager& m_streamManager;
+  };
+} //namespace tvlink
@@ -0,0 +1,160 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "StreamSources.h"
+
+#include "utilities/Logger.h"
+#include "utilities/WebUtils.h"
+
+#include <algorithm>
+
+using namespace tvlink;
+using namespace tvlink::data;
+using namespace tvlink::utilities;
+
+std::vector<std::string> StreamSources::RankStreamURLs(const Channel& channel)
+{
+  std::vector<std::string> streamUrls{channel.GetStreamURL()};
+  for (const auto& alternativeStreamUrl : channel.GetAlternativeStreamURLs())
+  {
+    if (std::find(streamUrls.begin(), streamUrls.end(), alternativeStreamUrl) == streamUrls.end())
+      streamUrls.emplace_back(alternativeStreamUrl);
+  }
+
+  if (streamUrls.size() == 1)
+    return streamUrls;
+
+  struct RankedSource
+  {
+    bool m_failing;
+    int m_consecutiveFailures;
+    int m_openMillis;
+  };
+
+  const time_t now = std::time(nullptr);
+  std::unordered_map<std::string, RankedSource> rankedSources;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (const auto& streamUrl : streamUrls)
+    {
+      RankedSource rankedSource = {false, 0, 0};
+
+      auto sourceHistoryPair = m_sourceHistories.find(streamUrl);
+      if (sourceHistoryPair != m_sourceHistories.end())
+      {
+        const SourceHistory& sourceHistory = sourceHistoryPair->second;
+        rankedSource.m_failing = sourceHistory.m_consecutiveFailures > 0 && sourceHistory.m_lastFailureTime > now - FAILURE_PENALTY_SECS;
+        rankedSource.m_consecutiveFailures = sourceHistory.m_consecutiveFailures;
+        rankedSource.m_openMillis = std::max(sourceHistory.m_openMillis, 0);
+      }
+
+      rankedSources.insert({streamUrl, rankedSource});
+    }
+  }
+
+  // Stable, so equally good sources keep the playlist order
+  std::stable_sort(streamUrls.begin(), streamUrls.end(), [&rankedSources](const std::string& left, const std::string& right) {
+    const RankedSource& leftSource = rankedSources.at(left);
+    const RankedSource& rightSource = rankedSources.at(right);
+
+    if (leftSource.m_failing != rightSource.m_failing)
+      return !leftSource.m_failing;
+    if (leftSource.m_failing)
+      return leftSource.m_consecutiveFailures < rightSource.m_consecutiveFailures;
+    return leftSource.m_openMillis < rightSource.m_openMillis;
+  });
+
+  return streamUrls;
+}
+
+void StreamSources::RecordOpened(const std::string& streamUrl, int openMillis)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  SourceHistory& sourceHistory = m_sourceHistories[streamUrl];
+  sourceHistory.m_openMillis = sourceHistory.m_openMillis >= 0 ? (3 * sourceHistory.m_openMillis + openMillis) / 4 : openMillis;
+  sourceHistory.m_consecutiveFailures = 0;
+}
+
+void StreamSources::RecordFailed(const std::string& streamUrl)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  SourceHistory& sourceHistory = m_sourceHistories[streamUrl];
+  sourceHistory.m_consecutiveFailures++;
+  sourceHistory.m_lastFailureTime = std::time(nullptr);
+}
+
+std::string StreamSources::GetRedirectedURL(const std::string& streamUrl)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto sourceHistoryPair = m_sourceHistories.find(streamUrl);
+  if (sourceHistoryPair == m_sourceHistories.end() || sourceHistoryPair->second.m_redirectedUrl.empty())
+  {
+    m_redirectMisses++;
+    return {};
+  }
+
+  // Redirect targets tend to carry short lived tokens, so they are only trusted for a while
+  SourceHistory& sourceHistory = sourceHistoryPair->second;
+  if (sourceHistory.m_redirectTime < std::time(nullptr) - REDIRECT_TTL_SECS)
+  {
+    sourceHistory.m_redirectedUrl.clear();
+    m_redirectMisses++;
+    return {};
+  }
+
+  m_redirectHits++;
+  return sourceHistory.m_redirectedUrl;
+}
+
+void StreamSources::RecordRedirect(const std::string& streamUrl, const std::string& redirectedUrl)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  SourceHistory& sourceHistory = m_sourceHistories[streamUrl];
+  sourceHistory.m_redirectedUrl = redirectedUrl;
+  sourceHistory.m_redirectTime = std::time(nullptr);
+}
+
+void StreamSources::InvalidateRedirect(const std::string& streamUrl)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto sourceHistoryPair = m_sourceHistories.find(streamUrl);
+  if (sourceHistoryPair != m_sourceHistories.end())
+    sourceHistoryPair->second.m_redirectedUrl.clear();
+}
+
+bool StreamSources::OpenSource(const std::string& streamUrl, const OpenFunction& open)
+{
+  std::string effectiveUrl;
+
+  // Going straight to where the source redirected to last time saves the round trips of the redirects
+  const std::string redirectedUrl = GetRedirectedURL(streamUrl);
+  if (!redirectedUrl.empty())
+  {
+    if (open(redirectedUrl, effectiveUrl))
+      return true;
+
+    Logger::Log(LEVEL_DEBUG, "%s - Could not open the redirected URL, following the redirects again: %s", __FUNCTION__,
+                WebUtils::RedactUrl(redirectedUrl).c_str());
+    InvalidateRedirect(streamUrl);
+  }
+
+  if (!open(streamUrl, effectiveUrl))
+    return false;
+
+  if (!effectiveUrl.empty() && effectiveUrl != streamUrl)
+    RecordRedirect(streamUrl, effectiveUrl);
+
+  return true;
+}
@@ -0,0 +1,77 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "data/Channel.h"
+
+#include <atomic>
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tvlink
+{
+  /**
+   * Remembers how opening each source of a live stream went, so a channel with
+   * alternative sources is opened from the one most likely to work and start
+   * fast. Sources that failed recently go to the back, the others are tried in
+   * order of their smoothed open time, a source that was never opened counts as
+   * fast so it gets tried once.
+   *
+   * It also remembers where a source redirected to, so for a while the next
+   * open can go straight to the final URL instead of following the redirects
+   * again.
+   */
+  class StreamSources
+  {
+  public:
+    // Opens the stream from connectUrl and sets where it ended up after redirects, empty if unknown
+    using OpenFunction = std::function<bool(const std::string& connectUrl, std::string& effectiveUrl)>;
+
+    // The stream URL followed by the alternatives, best first
+    std::vector<std::string> RankStreamURLs(const data::Channel& channel);
+
+    void RecordOpened(const std::string& streamUrl, int openMillis);
+    void RecordFailed(const std::string& streamUrl);
+
+    // The URL a source last redirected to, empty if it did not or that was too long ago
+    std::string GetRedirectedURL(const std::string& streamUrl);
+    void RecordRedirect(const std::string& streamUrl, const std::string& redirectedUrl);
+    // For when the redirected URL could not be opened, the next open follows the redirects again
+    void InvalidateRedirect(const std::string& streamUrl);
+    // Opens a source straight from where it redirected to last time, following the
+    // redirects again if that fails, and records where the open ended up
+    bool OpenSource(const std::string& streamUrl, const OpenFunction& open);
+
+    unsigned int GetRedirectHits() const { return m_redirectHits; }
+    unsigned int GetRedirectMisses() const { return m_redirectMisses; }
+
+  private:
+    static const int FAILURE_PENALTY_SECS = 5 * 60;
+    static const int REDIRECT_TTL_SECS = 10 * 60;
+
+    struct SourceHistory
+    {
+      int m_openMillis = -1; // smoothed, -1 if never opened
+      int m_consecutiveFailures = 0;
+      time_t m_lastFailureTime = 0;
+      std::string m_redirectedUrl;
+      time_t m_redirectTime = 0;
+    };
+
+    std::mutex m_mutex;
+    std::unordered_map<std::string, SourceHistory> m_sourceHistories;
+
+    std::atomic<unsigned int> m_redirectHits{0};
+    std::atomic<unsigned int> m_redirectMisses{0};
+  };
+} //namespace tvlink
@@ -0,0 +1,173 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "StreamTelemetry.h"
+
+#include <algorithm>
+
+using namespace tvlink;
+
+namespace
+{
+
+int ElapsedMillis(StreamTelemetry::Clock::time_point since, StreamTelemetry::Clock::time_point now)
+{
+  return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(now - since).count());
+}
+
+int GetReadSizeBucket(size_t bytesRead)
+{
+  int bucket = 0;
+  for (size_t bucketLimit = 1024; bucket < StreamTelemetry::READ_SIZE_BUCKETS - 1 && bytesRead > bucketLimit; bucketLimit *= 4)
+    bucket++;
+
+  return bucket;
+}
+
+} // unnamed namespace
+
+int StreamTelemetry::Snapshot::GetBufferHealthPercent() const
+{
+  if (m_sessionMillis <= 0)
+    return 100;
+
+  return std::max(0, 100 - static_cast<int>(static_cast<int64_t>(m_stallMillis) * 100 / m_sessionMillis));
+}
+
+std::string StreamTelemetry::Snapshot::FormatReadSizeHistogram() const
+{
+  static const char* bucketNames[READ_SIZE_BUCKETS] = {"<=1K", "<=4K", "<=16K", "<=64K", "<=256K", ">256K"};
+
+  std::string histogram;
+  for (int i = 0; i < READ_SIZE_BUCKETS; i++)
+  {
+    if (!histogram.empty())
+      histogram += " ";
+    histogram += std::string(bucketNames[i]) + ":" + std::to_string(m_readSizeHistogram[i]);
+  }
+
+  return histogram;
+}
+
+void StreamTelemetry::Start(Clock::time_point openStarted, int connectMillis)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_snapshot = Snapshot();
+  m_snapshot.m_active = true;
+  m_snapshot.m_connectMillis = connectMillis;
+  m_started = openStarted;
+  m_windowBytes.fill(0);
+  m_windowSeconds.fill(-1);
+}
+
+void StreamTelemetry::Stop()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  // The numbers stay around so the closing summary can still be logged
+  if (m_snapshot.m_active)
+    m_snapshot.m_sessionMillis = ElapsedMillis(m_started, Clock::now());
+  m_snapshot.m_active = false;
+}
+
+void StreamTelemetry::RecordNetworkRead(int64_t bytesRead)
+{
+  const Clock::time_point now = Clock::now();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_snapshot.m_networkReads++;
+  if (bytesRead <= 0)
+  {
+    m_snapshot.m_zeroByteReads++;
+    return;
+  }
+
+  if (m_snapshot.m_firstByteMillis < 0)
+    m_snapshot.m_firstByteMillis = ElapsedMillis(m_started, now);
+
+  m_snapshot.m_totalBytes += bytesRead;
+  m_snapshot.m_readSizeHistogram[GetReadSizeBucket(static_cast<size_t>(bytesRead))]++;
+
+  const int64_t second = std::chrono::duration_cast<std::chrono::seconds>(now - m_started).count();
+  const int slot = static_cast<int>(second % THROUGHPUT_WINDOW_SECS);
+  if (m_windowSeconds[slot] != second)
+  {
+    m_windowSeconds[slot] = second;
+    m_windowBytes[slot] = 0;
+  }
+  m_windowBytes[slot] += bytesRead;
+}
+
+void StreamTelemetry::RecordWait(std::chrono::milliseconds waited)
+{
+  if (waited < STALL_THRESHOLD)
+    return;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_snapshot.m_stalls++;
+  m_snapshot.m_stallMillis += static_cast<int>(waited.count());
+}
+
+void StreamTelemetry::RecordReconnect(std::chrono::milliseconds gap)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_snapshot.m_reconnects++;
+  m_snapshot.m_gapMillis += static_cast<int>(gap.count());
+  m_snapshot.m_lastGapMillis = static_cast<int>(gap.count());
+}
+
+void StreamTelemetry::RecordTsFraming(unsigned int packets, unsigned int syncErrors, unsigned int continuityErrors)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_snapshot.m_tsPackets = packets;
+  m_snapshot.m_tsSyncErrors = syncErrors;
+  m_snapshot.m_tsContinuityErrors = continuityErrors;
+}
+
+void StreamTelemetry::RecordReadSizing(int bitrateKbps, size_t readSize, size_t coalesceSize)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_snapshot.m_bitrateKbps = bitrateKbps;
+  m_snapshot.m_readSizeKB = static_cast<int>(readSize / 1024);
+  m_snapshot.m_coalesceSizeKB = static_cast<int>(coalesceSize / 1024);
+}
+
+StreamTelemetry::Snapshot StreamTelemetry::GetSnapshot() const
+{
+  const Clock::time_point now = Clock::now();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  Snapshot snapshot = m_snapshot;
+  if (!snapshot.m_active)
+    return snapshot;
+
+  snapshot.m_sessionMillis = ElapsedMillis(m_started, now);
+
+  // Only whole seconds count, the current one is still filling up and shares
+  // its slot with the oldest one
+  const int64_t currentSecond = std::chrono::duration_cast<std::chrono::seconds>(now - m_started).count();
+  const int64_t windowSecs = std::min<int64_t>(currentSecond, THROUGHPUT_WINDOW_SECS - 1);
+  uint64_t windowBytes = 0;
+  for (int i = 0; i < THROUGHPUT_WINDOW_SECS; i++)
+  {
+    if (m_windowSeconds[i] >= currentSecond - windowSecs && m_windowSeconds[i] < currentSecond)
+      windowBytes += m_windowBytes[i];
+  }
+
+  if (windowSecs > 0)
+    snapshot.m_throughputKbps = static_cast<int>(windowBytes * 8 / 1000 / windowSecs);
+
+  return snapshot;
+}
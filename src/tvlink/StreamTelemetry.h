@@ -0,0 +1,88 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace tvlink
+{
+  /**
+   * Numbers about the live stream session currently playing: how long the
+   * connect and the first byte took, the network throughput over the last few
+   * seconds, how big the reads from the network were, and how often playback
+   * had to wait for data. Network reads and demuxer reads happen on different
+   * threads and the numbers are read from a third, so everything is behind one
+   * mutex that is only held to update a few counters.
+   */
+  class StreamTelemetry
+  {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    // Read sizes are counted in buckets of up to 1, 4, 16, 64 and 256 KB and above
+    static const int READ_SIZE_BUCKETS = 6;
+
+    struct Snapshot
+    {
+      bool m_active = false;
+      int m_sessionMillis = 0;
+      int m_connectMillis = 0;
+      int m_firstByteMillis = -1;
+      int m_throughputKbps = 0;
+      uint64_t m_totalBytes = 0;
+      unsigned int m_networkReads = 0;
+      unsigned int m_zeroByteReads = 0;
+      unsigned int m_stalls = 0;
+      int m_stallMillis = 0;
+      unsigned int m_reconnects = 0;
+      int m_gapMillis = 0;
+      int m_lastGapMillis = 0;
+      unsigned int m_tsPackets = 0;
+      unsigned int m_tsSyncErrors = 0;
+      unsigned int m_tsContinuityErrors = 0;
+      int m_bitrateKbps = 0; // smoothed estimate the read sizes are chosen from, 0 while unknown
+      int m_readSizeKB = 0;
+      int m_coalesceSizeKB = 0;
+      std::array<unsigned int, READ_SIZE_BUCKETS> m_readSizeHistogram{};
+
+      // Percentage of the session playback was not waiting for data
+      int GetBufferHealthPercent() const;
+      std::string FormatReadSizeHistogram() const;
+    };
+
+    // Starts a new session, openStarted is when the connect began
+    void Start(Clock::time_point openStarted, int connectMillis);
+    void Stop();
+
+    void RecordNetworkRead(int64_t bytesRead);
+    void RecordWait(std::chrono::milliseconds waited);
+    void RecordReconnect(std::chrono::milliseconds gap);
+    // Totals so far, from the MPEG-TS framer
+    void RecordTsFraming(unsigned int packets, unsigned int syncErrors, unsigned int continuityErrors);
+    void RecordReadSizing(int bitrateKbps, size_t readSize, size_t coalesceSize);
+
+    Snapshot GetSnapshot() const;
+
+  private:
+    static const int THROUGHPUT_WINDOW_SECS = 10;
+    static constexpr std::chrono::milliseconds STALL_THRESHOLD{500};
+
+    mutable std::mutex m_mutex;
+    Snapshot m_snapshot;
+    Clock::time_point m_started;
+
+    // One byte count per second of the sliding window, tagged with the second it belongs to
+    std::array<uint64_t, THROUGHPUT_WINDOW_SECS> m_windowBytes{};
+    std::array<int64_t, THROUGHPUT_WINDOW_SECS> m_windowSeconds{};
+  };
+} //namespace tvlink
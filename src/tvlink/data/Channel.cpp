@@ -14,7 +14,8 @@
 #include "../utilities/StreamUtils.h"
 #include "../utilities/WebUtils.h"
 
-#include <regex>
+#include <algorithm>
+#include <vector>
 
 #include <kodi/General.h>
 #include <kodi/tools/StringUtils.h>
@@ -48,6 +49,11 @@ const std::string Channel::GetCatchupModeText(const CatchupMode& catchupMode)
   }
 }
 
+std::string Channel::GetShiftCatchupSource(const std::string& url)
+{
+  return url + "?utc={utc}&lutc={lutc}";
+}
+
 void Channel::UpdateTo(Channel& left) const
 {
   left.m_uniqueId         = m_uniqueId;
@@ -71,6 +77,10 @@ void Channel::UpdateTo(Channel& left) const
   left.m_tvgName          = m_tvgName;
   left.m_properties       = m_properties;
   left.m_inputStreamName = m_inputStreamName;
+  left.m_catchupSourceTemplate = m_catchupSourceTemplate;
+  left.m_shiftCatchupSourceTemplate = m_shiftCatchupSourceTemplate;
+  left.m_streamURLTemplate = m_streamURLTemplate;
+  left.m_alternativeStreamURLs = m_alternativeStreamURLs;
 }
 
 void Channel::UpdateTo(kodi::addon::PVRChannel& left) const
@@ -85,6 +95,94 @@ void Channel::UpdateTo(kodi::addon::PVRChannel& left) const
   left.SetHasArchive(IsCatchupSupported());
 }
 
+void Channel::WriteSnapshot(BinaryWriter& writer) const
+{
+  writer.Write(m_radio);
+  writer.Write(m_uniqueId);
+  writer.Write(m_channelNumber);
+  writer.Write(m_encryptionSystem);
+  writer.Write(m_tvgShift);
+  writer.Write(m_channelName);
+  writer.Write(m_iconPath);
+  writer.Write(m_streamURL);
+  writer.Write(m_hasCatchup);
+  writer.Write(static_cast<int>(m_catchupMode));
+  writer.Write(m_catchupDays);
+  writer.Write(m_catchupSource);
+  writer.Write(m_isCatchupTSStream);
+  writer.Write(m_catchupSupportsTimeshifting);
+  writer.Write(m_catchupSourceTerminates);
+  writer.Write(m_catchupGranularitySeconds);
+  writer.Write(m_catchupCorrectionSecs);
+  writer.Write(m_tvgId);
+  writer.Write(m_tvgName);
+  writer.Write(static_cast<uint32_t>(m_properties.size()));
+  for (const auto& property : m_properties)
+  {
+    writer.Write(property.first);
+    writer.Write(property.second);
+  }
+  writer.Write(m_inputStreamName);
+  writer.Write(static_cast<uint32_t>(m_alternativeStreamURLs.size()));
+  for (const auto& alternativeStreamURL : m_alternativeStreamURLs)
+    writer.Write(alternativeStreamURL);
+}
+
+bool Channel::ReadSnapshot(BinaryReader& reader)
+{
+  // The values were already processed when written so they are restored as
+  // is, the setters would apply the settings based defaults a second time
+  int catchupMode = 0;
+  uint32_t propertyCount = 0;
+
+  reader.Read(m_radio);
+  reader.Read(m_uniqueId);
+  reader.Read(m_channelNumber);
+  reader.Read(m_encryptionSystem);
+  reader.Read(m_tvgShift);
+  reader.Read(m_channelName);
+  reader.Read(m_iconPath);
+  reader.Read(m_streamURL);
+  reader.Read(m_hasCatchup);
+  reader.Read(catchupMode);
+  reader.Read(m_catchupDays);
+  reader.Read(m_catchupSource);
+  reader.Read(m_isCatchupTSStream);
+  reader.Read(m_catchupSupportsTimeshifting);
+  reader.Read(m_catchupSourceTerminates);
+  reader.Read(m_catchupGranularitySeconds);
+  reader.Read(m_catchupCorrectionSecs);
+  reader.Read(m_tvgId);
+  reader.Read(m_tvgName);
+  reader.Read(propertyCount);
+
+  m_catchupMode = static_cast<CatchupMode>(catchupMode);
+  m_properties.clear();
+  for (uint32_t i = 0; i < propertyCount && reader.IsOk(); i++)
+  {
+    std::string prop;
+    std::string value;
+    if (reader.Read(prop) && reader.Read(value))
+      m_properties.insert({prop, value});
+  }
+
+  reader.Read(m_inputStreamName);
+
+  uint32_t alternativeStreamURLCount = 0;
+  reader.Read(alternativeStreamURLCount);
+  m_alternativeStreamURLs.clear();
+  for (uint32_t i = 0; i < alternativeStreamURLCount && reader.IsOk(); i++)
+  {
+    std::string alternativeStreamURL;
+    if (reader.Read(alternativeStreamURL))
+      m_alternativeStreamURLs.emplace_back(alternativeStreamURL);
+  }
+
+  CompileUrlTemplates();
+
+  return reader.IsOk();
+}
+
 void Channel::Reset()
 {
   m_uniqueId = 0;
@@ -108,6 +206,10 @@ void Channel::Reset()
   m_tvgName.clear();
   m_properties.clear();
   m_inputStreamName.clear();
+  m_catchupSourceTemplate = {};
+  m_shiftCatchupSourceTemplate = {};
+  m_streamURLTemplate = {};
+  m_alternativeStreamURLs.clear();
 }
 
 void Channel::SetIconPathFromTvgLogo(const std::string& tvgLogo, std::string& channelName)
@@ -155,14 +257,7 @@ void Channel::SetStreamURL(const std::string& url)
     TryToAddPropertyAsHeader("http-referrer", "referer"); // spelling differences are correct
   }
 
-  if (Settings::GetInstance().TransformMulticastStreamUrls() &&
-      (StringUtils::StartsWith(url, UDP_MULTICAST_PREFIX) || StringUtils::StartsWith(url, RTP_MULTICAST_PREFIX)))
-  {
-    const std::string typePath = StringUtils::StartsWith(url, "rtp") ? "/rtp/" : "/udp/";
-
-    m_streamURL = "http://" + Settings::GetInstance().GetUdpxyHost() + ":" + std::to_string(Settings::GetInstance().GetUdpxyPort()) + typePath + url.substr(UDP_MULTICAST_PREFIX.length());
-    Logger::Log(LEVEL_DEBUG, "%s - Transformed multicast stream URL to local relay url: %s", __FUNCTION__, m_streamURL.c_str());
-  }
+  m_streamURL = TransformMulticastStreamURL(url);
 
   if (!Settings::GetInstance().GetDefaultInputstream().empty() && GetProperty(PVR_STREAM_PROPERTY_INPUTSTREAM).empty())
     AddProperty(PVR_STREAM_PROPERTY_INPUTSTREAM, Settings::GetInstance().GetDefaultInputstream());
@@ -173,6 +268,28 @@ void Channel::SetStreamURL(const std::string& url)
   m_inputStreamName = GetProperty(PVR_STREAM_PROPERTY_INPUTSTREAM);
 }
 
+void Channel::AddAlternativeStreamURL(const std::string& url)
+{
+  const std::string streamURL = TransformMulticastStreamURL(url);
+  if (streamURL != m_streamURL && std::find(m_alternativeStreamURLs.begin(), m_alternativeStreamURLs.end(), streamURL) == m_alternativeStreamURLs.end())
+    m_alternativeStreamURLs.emplace_back(streamURL);
+}
+
+std::string Channel::TransformMulticastStreamURL(const std::string& url)
+{
+  if (Settings::GetInstance().TransformMulticastStreamUrls() &&
+      (StringUtils::StartsWith(url, UDP_MULTICAST_PREFIX) || StringUtils::StartsWith(url, RTP_MULTICAST_PREFIX)))
+  {
+    const std::string typePath = StringUtils::StartsWith(url, "rtp") ? "/rtp/" : "/udp/";
+
+    const std::string relayURL = "http://" + Settings::GetInstance().GetUdpxyHost() + ":" + std::to_string(Settings::GetInstance().GetUdpxyPort()) + typePath + url.substr(UDP_MULTICAST_PREFIX.length());
+    Logger::Log(LEVEL_DEBUG, "%s - Transformed multicast stream URL to local relay url: %s", __FUNCTION__, relayURL.c_str());
+    return relayURL;
+  }
+
+  return url;
+}
+
 std::string Channel::GetProperty(const std::string& propName) const
 {
   auto propPair = m_properties.find(propName);
@@ -223,14 +340,50 @@ bool Channel::SupportsLiveStreamTimeshifting() const
 
 namespace
 {
+const std::string FLUSSONIC_TS_STREAM_TYPE = "mpegts";
+const std::string FLUSSONIC_HLS_STREAM_TYPE = ".m3u8";
+
+int CountSpecifiers(const std::string& formatString)
+{
+  // Anything inside curly braces, the same matches as \{[^{]+\}: from a '{' to
+  // the last '}' before the next '{', with at least one character in between
+  int numSpecifiers = 0;
+  size_t pos = formatString.find('{');
+  while (pos != std::string::npos)
+  {
+    const size_t nextOpen = formatString.find('{', pos + 1);
+    const size_t close = formatString.rfind('}', nextOpen == std::string::npos ? std::string::npos : nextOpen - 1);
+    if (close != std::string::npos && close > pos + 1)
+    {
+      numSpecifiers++;
+      pos = formatString.find('{', close + 1);
+    }
+    else
+    {
+      pos = nextOpen;
+    }
+  }
+
+  return numSpecifiers;
+}
+
+bool IsFlussonicQueryString(const std::string& queryString)
+{
+  // Either nothing, or the same as \?.+=.+
+  if (queryString.empty())
+    return true;
+
+  if (queryString[0] != '?' || queryString.size() < 4)
+    return false;
+
+  const size_t equalsPos = queryString.find('=', 2);
+  return equalsPos != std::string::npos && equalsPos < queryString.size() - 1;
+}
+
 bool IsValidTimeshiftingCatchupSource(const std::string& formatString, const CatchupMode& catchupMode)
 {
   // match any specifier, i.e. anything inside curly braces
-  std::regex const specifierRegex("\\{[^{]+\\}");
-
-  std::ptrdiff_t const numSpecifiers(std::distance(
-    std::sregex_iterator(formatString.begin(), formatString.end(), specifierRegex),
-    std::sregex_iterator()));
+  const int numSpecifiers = CountSpecifiers(formatString);
 
   if (numSpecifiers > 0)
   {
@@ -365,6 +518,15 @@ void Channel::ConfigureCatchupMode()
 
   if (m_catchupMode != CatchupMode::DISABLED)
     Logger::Log(LEVEL_DEBUG, "%s - %s - %s: %s", __FUNCTION__, GetCatchupModeText(m_catchupMode).c_str(), m_channelName.c_str(), WebUtils::RedactUrl(m_catchupSource).c_str());
+
+  CompileUrlTemplates();
+}
+
+void Channel::CompileUrlTemplates()
+{
+  m_catchupSourceTemplate = UrlTemplate(m_catchupSource, UrlTemplateScope::ALL);
+  m_shiftCatchupSourceTemplate = UrlTemplate(GetShiftCatchupSource(m_streamURL), UrlTemplateScope::ALL);
+  m_streamURLTemplate = UrlTemplate(m_streamURL, UrlTemplateScope::NOW_ONLY);
 }
 
 bool Channel::GenerateAppendCatchupSource(const std::string& url)
@@ -375,7 +537,7 @@ bool Channel::GenerateAppendCatchupSource(const std::string& url)
 
 void Channel::GenerateShiftCatchupSource(const std::string& url)
 {
-  m_catchupSource = url + "?utc={utc}&lutc={lutc}";
+  m_catchupSource = GetShiftCatchupSource(url);
 }
 
 bool Channel::GenerateFlussonicCatchupSource(const std::string& url)
@@ -388,20 +550,36 @@ bool Channel::GenerateFlussonicCatchupSource(const std::string& url)
   // stream:  http://list.tv:8888/325/mono.m3u8?token=secret
   // catchup: http://list.tv:8888/325/mono-timeshift_rel-{offset:1}.m3u8?token=secret
 
-  static std::regex fsRegex("^(http[s]?://[^/]+)/([^/]+)/([^/]*)(mpegts|\\.m3u8)(\\?.+=.+)?$");
-  std::smatch matches;
+  // Same forms as ^(http[s]?://[^/]+)/([^/]+)/([^/]*)(mpegts|\.m3u8)(\?.+=.+)?$
+  std::string fsHost;
+  std::string path;
+  if (!WebUtils::SplitHttpUrl(url, fsHost, path))
+    return false;
+
+  const size_t channelIdEnd = path.find('/');
+  if (channelIdEnd == 0 || channelIdEnd == std::string::npos)
+    return false;
+
+  const std::string fsChannelId = path.substr(0, channelIdEnd);
+  const std::string streamPart = path.substr(channelIdEnd + 1);
 
-  if (std::regex_match(url, matches, fsRegex))
+  // The list type can't contain a '/' but the query string can, and the
+  // longest list type wins, as it would with a greedy match
+  size_t streamTypePos = std::min(streamPart.find('/'), streamPart.size());
+  while (true)
   {
-    if (matches.size() == 6)
+    std::string fsStreamType;
+    if (streamPart.compare(streamTypePos, FLUSSONIC_TS_STREAM_TYPE.size(), FLUSSONIC_TS_STREAM_TYPE) == 0)
+      fsStreamType = FLUSSONIC_TS_STREAM_TYPE;
+    else if (streamPart.compare(streamTypePos, FLUSSONIC_HLS_STREAM_TYPE.size(), FLUSSONIC_HLS_STREAM_TYPE) == 0)
+      fsStreamType = FLUSSONIC_HLS_STREAM_TYPE;
+
+    const std::string fsUrlAppend = fsStreamType.empty() ? "" : streamPart.substr(streamTypePos + fsStreamType.size());
+    if (!fsStreamType.empty() && IsFlussonicQueryString(fsUrlAppend))
     {
-      const std::string fsHost = matches[1].str();
-      const std::string fsChannelId = matches[2].str();
-      const std::string fsListType = matches[3].str();
-      const std::string fsStreamType = matches[4].str();
-      const std::string fsUrlAppend = matches[5].str();
+      const std::string fsListType = streamPart.substr(0, streamTypePos);
 
-      m_isCatchupTSStream = fsStreamType == "mpegts";
+      m_isCatchupTSStream = fsStreamType == FLUSSONIC_TS_STREAM_TYPE;
       if (m_isCatchupTSStream)
       {
         m_catchupSource = fsHost + "/" + fsChannelId + "/timeshift_abs-${start}.ts" + fsUrlAppend;
@@ -416,6 +594,10 @@ bool Channel::GenerateFlussonicCatchupSource(const std::string& url)
 
       return true;
     }
+
+    if (streamTypePos == 0)
+      break;
+    streamTypePos--;
   }
 
   return false;
@@ -429,33 +611,38 @@ bool Channel::GenerateXtreamCodesCatchupSource(const std::string& url)
   // stream:  http://list.tv:8080/live/my@account.xc/my_password/1477.m3u8
   // catchup: http://list.tv:8080/timeshift/my@account.xc/my_password/{duration}/{Y}-{m}-{d}:{H}-{M}/1477.m3u8
 
-  static std::regex xcRegex("^(http[s]?://[^/]+)/(?:live/)?([^/]+)/([^/]+)/([^/\\.]+)(\\.m3u[8]?)?$");
-  std::smatch matches;
+  // Same forms as ^(http[s]?://[^/]+)/(?:live/)?([^/]+)/([^/]+)/([^/\.]+)(\.m3u[8]?)?$
+  std::string xcHost;
+  std::string path;
+  if (!WebUtils::SplitHttpUrl(url, xcHost, path))
+    return false;
 
-  if (std::regex_match(url, matches, xcRegex))
-  {
-    if (matches.size() == 6)
-    {
-      const std::string xcHost = matches[1].str();
-      const std::string xcUsername = matches[2].str();
-      const std::string xcPasssword = matches[3].str();
-      const std::string xcChannelId = matches[4].str();
-      std::string xcExtension;
-      if (matches[5].matched)
-        xcExtension = matches[5].str();
-
-      if (xcExtension.empty())
-      {
-        m_isCatchupTSStream = true;
-        xcExtension = ".ts";
-      }
+  std::vector<std::string> segments = WebUtils::SplitPath(path);
+  if (segments.size() == 4 && segments[0] == "live")
+    segments.erase(segments.begin());
 
-      m_catchupSource = xcHost + "/timeshift/" + xcUsername + "/" + xcPasssword +
-                        "/{duration:60}/{Y}-{m}-{d}:{H}-{M}/" + xcChannelId + xcExtension;
+  if (segments.size() != 3 || segments[0].empty() || segments[1].empty())
+    return false;
 
-      return true;
-    }
+  const std::string& xcUsername = segments[0];
+  const std::string& xcPasssword = segments[1];
+
+  // The channel id has no '.', an extension can only be .m3u or .m3u8
+  const std::string& lastSegment = segments[2];
+  const size_t extensionPos = std::min(lastSegment.find('.'), lastSegment.size());
+  const std::string xcChannelId = lastSegment.substr(0, extensionPos);
+  std::string xcExtension = lastSegment.substr(extensionPos);
+  if (xcChannelId.empty() || (!xcExtension.empty() && xcExtension != ".m3u" && xcExtension != ".m3u8"))
+    return false;
+
+  if (xcExtension.empty())
+  {
+    m_isCatchupTSStream = true;
+    xcExtension = ".ts";
   }
 
-  return false;
+  m_catchupSource = xcHost + "/timeshift/" + xcUsername + "/" + xcPasssword +
+                    "/{duration:60}/{Y}-{m}-{d}:{H}-{M}/" + xcChannelId + xcExtension;
+
+  return true;
 }
@@ -8,8 +8,12 @@
 
 #pragma once
 
+#include "../utilities/BinaryUtils.h"
+#include "../utilities/UrlTemplate.h"
+
 #include <map>
 #include <string>
+#include <vector>
 
 #include <kodi/addon-instance/pvr/Channels.h>
 
@@ -38,6 +42,7 @@ namespace tvlink
     {
     public:
       static const std::string GetCatchupModeText(const CatchupMode& catchupMode);
+      static std::string GetShiftCatchupSource(const std::string& url);
 
       Channel() = default;
       Channel(const Channel &c) : m_radio(c.IsRadio()), m_uniqueId(c.GetUniqueId()),
@@ -48,7 +53,9 @@ namespace tvlink
         m_isCatchupTSStream(c.IsCatchupTSStream()), m_catchupSupportsTimeshifting(c.CatchupSupportsTimeshifting()),
         m_catchupSourceTerminates(c.CatchupSourceTerminates()), m_catchupGranularitySeconds(c.GetCatchupGranularitySeconds()),
         m_catchupCorrectionSecs(c.GetCatchupCorrectionSecs()), m_tvgId(c.GetTvgId()), m_tvgName(c.GetTvgName()),
-        m_properties(c.GetProperties()), m_inputStreamName(c.GetInputStreamName()) {};
+        m_properties(c.GetProperties()), m_inputStreamName(c.GetInputStreamName()),
+        m_catchupSourceTemplate(c.GetCatchupSourceTemplate()), m_shiftCatchupSourceTemplate(c.GetShiftCatchupSourceTemplate()),
+        m_streamURLTemplate(c.GetStreamURLTemplate()), m_alternativeStreamURLs(c.GetAlternativeStreamURLs()) {};
       ~Channel() = default;
 
       bool IsRadio() const { return m_radio; }
@@ -75,6 +82,10 @@ namespace tvlink
       const std::string& GetStreamURL() const { return m_streamURL; }
       void SetStreamURL(const std::string& url);
 
+      // Other sources of the same live stream, in playlist order, tried when the stream URL fails
+      const std::vector<std::string>& GetAlternativeStreamURLs() const { return m_alternativeStreamURLs; }
+      void AddAlternativeStreamURL(const std::string& url);
+
       bool IsCatchupSupported() const; // Does the M3U entry or default settings denote catchup support
       bool HasCatchup() const { return m_hasCatchup; } // Does the M3U entry denote catchup support
       void SetHasCatchup(bool value) { m_hasCatchup = value; }
@@ -119,11 +130,18 @@ namespace tvlink
       bool HasMimeType() const { return !GetProperty(PVR_STREAM_PROPERTY_MIMETYPE).empty(); }
       std::string GetMimeType() const { return GetProperty(PVR_STREAM_PROPERTY_MIMETYPE); }
 
+      // Compiled in ConfigureCatchupMode(), used to render catchup and stream URLs
+      const utilities::UrlTemplate& GetCatchupSourceTemplate() const { return m_catchupSourceTemplate; }
+      const utilities::UrlTemplate& GetShiftCatchupSourceTemplate() const { return m_shiftCatchupSourceTemplate; }
+      const utilities::UrlTemplate& GetStreamURLTemplate() const { return m_streamURLTemplate; }
+
       const std::string& GetInputStreamName() const { return m_inputStreamName; };
       void SetInputStreamName(const std::string& value) { m_inputStreamName = value; }
 
       void UpdateTo(Channel& left) const;
       void UpdateTo(kodi::addon::PVRChannel& left) const;
+      void WriteSnapshot(utilities::BinaryWriter& writer) const;
+      bool ReadSnapshot(utilities::BinaryReader& reader);
       void Reset();
       void SetIconPathFromTvgLogo(const std::string& tvgLogo, std::string& channelName);
       void ConfigureCatchupMode();
@@ -135,7 +153,9 @@ namespace tvlink
 
     private:
       void RemoveProperty(const std::string& propName);
+      void CompileUrlTemplates();
       void TryToAddPropertyAsHeader(const std::string& propertyName, const std::string& headerName);
+      static std::string TransformMulticastStreamURL(const std::string& url);
 
       bool m_radio = false;
       int m_uniqueId = 0;
@@ -158,6 +178,10 @@ namespace tvlink
       std::string m_tvgName = "";
       std::map<std::string, std::string> m_properties;
       std::string m_inputStreamName;
+      utilities::UrlTemplate m_catchupSourceTemplate;
+      utilities::UrlTemplate m_shiftCatchupSourceTemplate;
+      utilities::UrlTemplate m_streamURLTemplate;
+      std::vector<std::string> m_alternativeStreamURLs;
     };
   } //namespace data
 } //namespace tvlink
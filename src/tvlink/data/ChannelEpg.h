@@ -40,6 +40,7 @@ namespace tvlink
       void SetIconPath(const std::string& value) { m_iconPath = value; }
 
       std::map<time_t, EpgEntry>& GetEpgEntries() { return m_epgEntries; }
+      const std::map<time_t, EpgEntry>& GetEpgEntries() const { return m_epgEntries; }
       void AddEpgEntry(const EpgEntry& epgEntry) { m_epgEntries[epgEntry.GetStartTime()] = epgEntry; }
 
       bool UpdateFrom(const pugi::xml_node& channelNode, tvlink::Channels& channels);
@@ -10,6 +10,7 @@
 
 using namespace tvlink;
 using namespace tvlink::data;
+using namespace tvlink::utilities;
 
 void ChannelGroup::UpdateTo(kodi::addon::PVRChannelGroup& left) const
 {
@@ -17,3 +18,33 @@ void ChannelGroup::UpdateTo(kodi::addon::PVRChannelGroup& left) const
   left.SetPosition(0); // groups default order, unused
   left.SetGroupName(m_groupName);
 }
+
+void ChannelGroup::WriteSnapshot(BinaryWriter& writer) const
+{
+  writer.Write(m_radio);
+  writer.Write(m_uniqueId);
+  writer.Write(m_groupName);
+  writer.Write(static_cast<uint32_t>(m_memberChannelIndexes.size()));
+  for (int channelIndex : m_memberChannelIndexes)
+    writer.Write(channelIndex);
+}
+
+bool ChannelGroup::ReadSnapshot(BinaryReader& reader)
+{
+  uint32_t memberCount = 0;
+
+  reader.Read(m_radio);
+  reader.Read(m_uniqueId);
+  reader.Read(m_groupName);
+  reader.Read(memberCount);
+
+  m_memberChannelIndexes.clear();
+  for (uint32_t i = 0; i < memberCount && reader.IsOk(); i++)
+  {
+    int channelIndex = 0;
+    if (reader.Read(channelIndex))
+      m_memberChannelIndexes.emplace_back(channelIndex);
+  }
+
+  return reader.IsOk();
+}
@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include "../utilities/BinaryUtils.h"
+
 #include <string>
 #include <vector>
 
@@ -33,6 +35,8 @@ namespace tvlink
       void AddMemberChannelIndex(int channelIndex) { m_memberChannelIndexes.emplace_back(channelIndex); }
 
       void UpdateTo(kodi::addon::PVRChannelGroup& left) const;
+      void WriteSnapshot(utilities::BinaryWriter& writer) const;
+      bool ReadSnapshot(utilities::BinaryReader& reader);
 
     private:
       bool m_radio;
@@ -24,7 +24,7 @@ using namespace tvlink;
 using namespace tvlink::data;
 using namespace pugi;
 
-void EpgEntry::UpdateTo(kodi::addon::PVREPGTag& left, int iChannelUid, int timeShift, const std::vector<EpgGenre>& genreMappings)
+void EpgEntry::UpdateTo(kodi::addon::PVREPGTag& left, int iChannelUid, int timeShift, const std::vector<EpgGenre>& genreMappings) const
 {
   left.SetUniqueBroadcastId(m_broadcastId);
   left.SetTitle(m_title);
@@ -38,9 +38,11 @@ void EpgEntry::UpdateTo(kodi::addon::PVREPGTag& left, int iChannelUid, int timeS
   left.SetWriter(m_writer);
   left.SetYear(m_year);
   left.SetIconPath(m_iconPath);
-  if (SetEpgGenre(genreMappings))
+  int genreType = m_genreType;
+  int genreSubType = m_genreSubType;
+  if (GetEpgGenre(genreMappings, genreType, genreSubType))
   {
-    left.SetGenreType(m_genreType);
+    left.SetGenreType(genreType);
     if (Settings::GetInstance().UseEpgGenreTextWhenMapping())
     {
       //Setting this value in sub type allows custom text to be displayed
@@ -50,7 +52,7 @@ void EpgEntry::UpdateTo(kodi::addon::PVREPGTag& left, int iChannelUid, int timeS
     }
     else
     {
-      left.SetGenreSubType(m_genreSubType);
+      left.SetGenreSubType(genreSubType);
     }
   }
   else
@@ -72,7 +74,7 @@ void EpgEntry::UpdateTo(kodi::addon::PVREPGTag& left, int iChannelUid, int timeS
   left.SetFlags(iFlags);
 }
 
-bool EpgEntry::SetEpgGenre(const std::vector<EpgGenre> genreMappings)
+bool EpgEntry::GetEpgGenre(const std::vector<EpgGenre>& genreMappings, int& genreType, int& genreSubType) const
 {
   if (genreMappings.empty())
     return false;
@@ -86,8 +88,8 @@ bool EpgEntry::SetEpgGenre(const std::vector<EpgGenre> genreMappings)
     {
       if (StringUtils::EqualsNoCase(genreMapping.GetGenreString(), genre))
       {
-        m_genreType = genreMapping.GetGenreType();
-        m_genreSubType = genreMapping.GetGenreSubType();
+        genreType = genreMapping.GetGenreType();
+        genreSubType = genreMapping.GetGenreSubType();
         return true;
       }
     }
@@ -97,12 +97,12 @@ namespace tvlink
       bool IsPremiere() const { return m_premiere; }
       void SetPremiere(int value) { m_premiere = value; }
 
-      void UpdateTo(kodi::addon::PVREPGTag& left, int iChannelUid, int timeShift, const std::vector<EpgGenre>& genres);
+      void UpdateTo(kodi::addon::PVREPGTag& left, int iChannelUid, int timeShift, const std::vector<EpgGenre>& genres) const;
       bool UpdateFrom(const pugi::xml_node& channelNode, const std::string& id,
                       int start, int end, int minShiftTime, int maxShiftTime);
 
     private:
-      bool SetEpgGenre(std::vector<EpgGenre> genreMappings);
+      bool GetEpgGenre(const std::vector<EpgGenre>& genreMappings, int& genreType, int& genreSubType) const;
       bool ParseEpisodeNumberInfo(std::vector<std::pair<std::string, std::string>>& episodeNumbersList);
       bool ParseXmltvNsEpisodeNumberInfo(const std::string& episodeNumberString);
       bool ParseOnScreenEpisodeNumberInfo(const std::string& episodeNumberString);
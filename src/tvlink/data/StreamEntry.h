@@ -8,6 +8,9 @@
 
 #pragma once
 
+#include "../utilities/BinaryUtils.h"
+
+#include <ctime>
 #include <string>
 
 namespace tvlink
@@ -41,11 +44,63 @@ namespace tvlink
       time_t GetLastAccessTime() const { return m_lastAcessTime; }
       void SetLastAccessTime(time_t value) { m_lastAcessTime = value; }
 
+      time_t GetInspectedTime() const { return m_inspectedTime; }
+      void SetInspectedTime(time_t value) { m_inspectedTime = value; }
+
+      bool IsReachable() const { return m_reachable; }
+      void SetReachable(bool value) { m_reachable = value; }
+
+      int GetFirstByteMillis() const { return m_firstByteMillis; }
+      void SetFirstByteMillis(int value) { m_firstByteMillis = value; }
+
+      int GetBitrateKbps() const { return m_bitrateKbps; }
+      void SetBitrateKbps(int value) { m_bitrateKbps = value; }
+
+      void WriteSnapshot(utilities::BinaryWriter& writer) const
+      {
+        writer.Write(m_streamKey);
+        writer.Write(static_cast<int>(m_streamType));
+        writer.Write(m_mimeType);
+        writer.Write(static_cast<int64_t>(m_lastAcessTime));
+        writer.Write(static_cast<int64_t>(m_inspectedTime));
+        writer.Write(m_reachable);
+        writer.Write(m_firstByteMillis);
+        writer.Write(m_bitrateKbps);
+      }
+
+      bool ReadSnapshot(utilities::BinaryReader& reader)
+      {
+        int streamType = 0;
+        int64_t lastAccessTime = 0;
+        int64_t inspectedTime = 0;
+
+        reader.Read(m_streamKey);
+        reader.Read(streamType);
+        reader.Read(m_mimeType);
+        reader.Read(lastAccessTime);
+        reader.Read(inspectedTime);
+        reader.Read(m_reachable);
+        reader.Read(m_firstByteMillis);
+        reader.Read(m_bitrateKbps);
+
+        if (!reader.IsOk() || streamType < static_cast<int>(StreamType::HLS) || streamType > static_cast<int>(StreamType::OTHER_TYPE))
+          return false;
+
+        m_streamType = static_cast<StreamType>(streamType);
+        m_lastAcessTime = static_cast<time_t>(lastAccessTime);
+        m_inspectedTime = static_cast<time_t>(inspectedTime);
+        return true;
+      }
+
     private:
       std::string m_streamKey; // URL or catchup source
-      StreamType m_streamType;
+      StreamType m_streamType = StreamType::OTHER_TYPE;
       std::string m_mimeType;
-      time_t m_lastAcessTime;
+      time_t m_lastAcessTime = 0;
+      time_t m_inspectedTime = 0; // when the stream type was determined, entries expire after a TTL
+      bool m_reachable = true;
+      int m_firstByteMillis = -1; // time for the stream head to arrive when probed, -1 if never probed
+      int m_bitrateKbps = 0; // what the stream averaged when last played, 0 if never played
     };
   } //namespace data
 } //namespace tvlink
@@ -0,0 +1,86 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace tvlink
+{
+  namespace utilities
+  {
+    /**
+     * Appends plain values and length prefixed strings to a buffer in host byte order.
+     */
+    class BinaryWriter
+    {
+    public:
+      BinaryWriter(std::string& buffer) : m_buffer(buffer) {}
+
+      template<typename T>
+      void Write(const T& value)
+      {
+        static_assert(std::is_trivially_copyable<T>::value, "BinaryWriter can only write plain values");
+        m_buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+      }
+
+      void Write(const std::string& value)
+      {
+        Write(static_cast<uint32_t>(value.size()));
+        m_buffer.append(value);
+      }
+
+    private:
+      std::string& m_buffer;
+    };
+
+    /**
+     * Reads back what BinaryWriter wrote. Every read is bounds checked and once one
+     * fails all further reads fail, so callers can check once at the end.
+     */
+    class BinaryReader
+    {
+    public:
+      BinaryReader(const std::string& buffer) : m_buffer(buffer) {}
+
+      template<typename T>
+      bool Read(T& value)
+      {
+        static_assert(std::is_trivially_copyable<T>::value, "BinaryReader can only read plain values");
+        if (!m_ok || m_buffer.size() - m_position < sizeof(T))
+          return m_ok = false;
+
+        std::memcpy(&value, m_buffer.data() + m_position, sizeof(T));
+        m_position += sizeof(T);
+        return true;
+      }
+
+      bool Read(std::string& value)
+      {
+        uint32_t size = 0;
+        if (!Read(size) || m_buffer.size() - m_position < size)
+          return m_ok = false;
+
+        value.assign(m_buffer, m_position, size);
+        m_position += size;
+        return true;
+      }
+
+      bool IsOk() const { return m_ok; }
+      bool AtEnd() const { return m_position == m_buffer.size(); }
+
+    private:
+      const std::string& m_buffer;
+      size_t m_position = 0;
+      bool m_ok = true;
+    };
+  } // namespace utilities
+} // namespace tvlink
@@ -0,0 +1,63 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace tvlink
+{
+  namespace utilities
+  {
+    /**
+     * Shared cancellation flag. Copies refer to the same flag so a token can be
+     * handed to any number of tasks and cancelled from the owner. Long running
+     * work checks IsCancelled() at its checkpoints and sleeps with WaitFor().
+     */
+    class CancellationToken
+    {
+    public:
+      CancellationToken() : m_state(std::make_shared<State>()) {}
+
+      void Cancel()
+      {
+        {
+          std::lock_guard<std::mutex> lock(m_state->mutex);
+          m_state->cancelled = true;
+        }
+        m_state->condition.notify_all();
+      }
+
+      bool IsCancelled() const { return m_state->cancelled; }
+
+      /**
+       * Sleep for the given time, waking early if the token is cancelled.
+       * Returns false if the token was cancelled.
+       */
+      bool WaitFor(std::chrono::milliseconds timeout) const
+      {
+        std::unique_lock<std::mutex> lock(m_state->mutex);
+        return !m_state->condition.wait_for(lock, timeout, [this] { return m_state->cancelled.load(); });
+      }
+
+    private:
+      struct State
+      {
+        std::atomic<bool> cancelled{false};
+        std::mutex mutex;
+        std::condition_variable condition;
+      };
+
+      std::shared_ptr<State> m_state;
+    };
+  } // namespace utilities
+} // namespace tvlink
@@ -10,11 +10,21 @@
 
 #include "../Settings.h"
 
+#include <algorithm>
+
 #include <zlib.h>
 
 using namespace tvlink;
 using namespace tvlink::utilities;
 
+namespace
+{
+
+// Upper bound on the output of a single inflate() call, so cancellation is seen between chunks
+const unsigned INFLATE_CHUNK_SIZE = 1024 * 1024;
+
+} // unnamed namespace
+
 std::string FileUtils::PathCombine(const std::string& path, const std::string& fileName)
 {
   std::string result = path;
@@ -45,7 +55,8 @@ std::string FileUtils::GetUserDataAddonFilePath(const std::string& fileName)
   return PathCombine(Settings::GetInstance().GetUserPath(), fileName);
 }
 
-int FileUtils::GetFileContents(const std::string& url, std::string& content)
+int FileUtils::GetFileContents(const std::string& url, std::string& content,
+                               const CancellationToken& token /* CancellationToken() */)
 {
   content.clear();
   kodi::vfs::CFile file;
@@ -53,7 +64,16 @@ int FileUtils::GetFileContents(const std::string& url, std::string& content)
   {
     char buffer[1024];
     while (int bytesRead = file.Read(buffer, 1024))
+    {
+      if (token.IsCancelled())
+      {
+        Logger::Log(LEVEL_DEBUG, "%s - Read of '%s' cancelled", __FUNCTION__, url.c_str());
+        content.clear();
+        break;
+      }
+
       content.append(buffer, bytesRead);
+    }
   }
 
   return content.length();
@@ -65,7 +85,8 @@ int FileUtils::GetFileContents(const std::string& url, std::string& content)
  * http://windrealm.org
  */
 
-bool FileUtils::GzipInflate(const std::string& compressedBytes, std::string& uncompressedBytes)
+bool FileUtils::GzipInflate(const std::string& compressedBytes, std::string& uncompressedBytes,
+                            const CancellationToken& token /* CancellationToken() */)
 {
   if (compressedBytes.size() == 0)
   {
@@ -97,6 +118,9 @@ bool FileUtils::GzipInflate(const std::string& compressedBytes, std::string& unc
   bool done = false;
   while (!done)
   {
+    if (token.IsCancelled())
+      break;
+
     // If our output buffer is too small
     if (strm.total_out >= uncompLength)
     {
@@ -108,7 +132,7 @@ bool FileUtils::GzipInflate(const std::string& compressedBytes, std::string& unc
     }
 
     strm.next_out = reinterpret_cast<Bytef*>(uncomp + strm.total_out);
-    strm.avail_out = uncompLength - strm.total_out;
+    strm.avail_out = std::min<unsigned>(uncompLength - strm.total_out, INFLATE_CHUNK_SIZE);
 
     // Inflate another chunk.
     int err = inflate(&strm, Z_SYNC_FLUSH);
@@ -119,7 +143,7 @@ bool FileUtils::GzipInflate(const std::string& compressedBytes, std::string& unc
   }
 
   status = inflateEnd(&strm);
-  if (status != Z_OK)
+  if (status != Z_OK || token.IsCancelled())
   {
     free(uncomp);
     return false;
@@ -133,30 +157,14 @@ bool FileUtils::GzipInflate(const std::string& compressedBytes, std::string& unc
 }
 
 int FileUtils::GetCachedFileContents(const std::string& cachedName, const std::string& filePath,
-                                       std::string& contents, const bool useCache /* false */)
+                                       std::string& contents, const bool useCache /* false */,
+                                       const CancellationToken& token /* CancellationToken() */)
 {
-  bool needReload = false;
   const std::string cachedPath = FileUtils::GetUserDataAddonFilePath(cachedName);
 
-  // check cached file is exists
-  if (useCache && kodi::vfs::FileExists(cachedPath, false))
-  {
-    kodi::vfs::FileStatus statCached;
-    kodi::vfs::FileStatus statOrig;
-
-    kodi::vfs::StatFile(cachedPath, statCached);
-    kodi::vfs::StatFile(filePath, statOrig);
-
-    needReload = statCached.GetModificationTime() < statOrig.GetModificationTime() || statOrig.GetModificationTime() == 0;
-  }
-  else
-  {
-    needReload = true;
-  }
-
-  if (needReload)
+  if (!useCache || IsCachedFileStale(cachedName, filePath))
   {
-    FileUtils::GetFileContents(filePath, contents);
+    FileUtils::GetFileContents(filePath, contents, token);
 
     // write to cache
     if (useCache && contents.length() > 0)
@@ -170,7 +178,24 @@ int FileUtils::GetCachedFileContents(const std::string& cachedName, const std::s
     return contents.length();
   }
 
-  return FileUtils::GetFileContents(cachedPath, contents);
+  return FileUtils::GetFileContents(cachedPath, contents, token);
+}
+
+bool FileUtils::IsCachedFileStale(const std::string& cachedName, const std::string& filePath)
+{
+  const std::string cachedPath = FileUtils::GetUserDataAddonFilePath(cachedName);
+
+  // check cached file is exists
+  if (!kodi::vfs::FileExists(cachedPath, false))
+    return true;
+
+  kodi::vfs::FileStatus statCached;
+  kodi::vfs::FileStatus statOrig;
+
+  kodi::vfs::StatFile(cachedPath, statCached);
+  kodi::vfs::StatFile(filePath, statOrig);
+
+  return statCached.GetModificationTime() < statOrig.GetModificationTime() || statOrig.GetModificationTime() == 0;
 }
 
 bool FileUtils::FileExists(const std::string& file)
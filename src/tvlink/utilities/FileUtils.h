@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include "CancellationToken.h"
+
 #include <kodi/Filesystem.h>
 #include <string>
 
@@ -20,10 +22,14 @@ namespace tvlink
     public:
       static std::string PathCombine(const std::string& path, const std::string& fileName);
       static std::string GetUserDataAddonFilePath(const std::string& fileName);
-      static int GetFileContents(const std::string& url, std::string& content);
-      static bool GzipInflate(const std::string& compressedBytes, std::string& uncompressedBytes);
+      static int GetFileContents(const std::string& url, std::string& content,
+                                 const CancellationToken& token = CancellationToken());
+      static bool GzipInflate(const std::string& compressedBytes, std::string& uncompressedBytes,
+                              const CancellationToken& token = CancellationToken());
       static int GetCachedFileContents(const std::string& cachedName, const std::string& filePath,
-                                       std::string& content, const bool useCache = false);
+                                       std::string& content, const bool useCache = false,
+                                       const CancellationToken& token = CancellationToken());
+      static bool IsCachedFileStale(const std::string& cachedName, const std::string& filePath);
       static bool FileExists(const std::string& file);
       static bool DeleteFile(const std::string& file);
       static bool CopyFile(const std::string& sourceFile, const std::string& targetFile);
@@ -0,0 +1,33 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace tvlink
+{
+  namespace utilities
+  {
+    constexpr uint64_t FNV1A_64_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+    constexpr uint64_t FNV1A_64_PRIME = 0x100000001b3ULL;
+
+    // 64-bit FNV-1a, pass a previous result as the hash to continue over several values
+    inline uint64_t Fnv1a64(const std::string& value, uint64_t hash = FNV1A_64_OFFSET_BASIS)
+    {
+      for (unsigned char c : value)
+      {
+        hash ^= c;
+        hash *= FNV1A_64_PRIME;
+      }
+
+      return hash;
+    }
+  } // namespace utilities
+} // namespace tvlink
@@ -0,0 +1,88 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "StreamBuffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace tvlink
+{
+  namespace utilities
+  {
+    /**
+     * A fixed size byte ring buffer for exactly one producer thread and one
+     * consumer thread. Neither side takes a lock, the positions only ever grow
+     * and each is written by one side only, so an acquire load of the other
+     * side's position is enough to know which bytes are safe to touch.
+     */
+    class RingBuffer : public StreamBuffer
+    {
+    public:
+      explicit RingBuffer(size_t capacity)
+        : m_buffer(new uint8_t[capacity]), m_capacity(capacity) {}
+
+      RingBuffer(const RingBuffer&) = delete;
+      RingBuffer& operator=(const RingBuffer&) = delete;
+
+      size_t Write(const uint8_t* data, size_t size) override
+      {
+        const size_t writePosition = m_writePosition.load(std::memory_order_relaxed);
+        const size_t readPosition = m_readPosition.load(std::memory_order_acquire);
+
+        size = std::min(size, m_capacity - (writePosition - readPosition));
+        const size_t offset = writePosition % m_capacity;
+        const size_t firstPart = std::min(size, m_capacity - offset);
+
+        std::memcpy(m_buffer.get() + offset, data, firstPart);
+        std::memcpy(m_buffer.get(), data + firstPart, size - firstPart);
+
+        m_writePosition.store(writePosition + size, std::memory_order_release);
+        return size;
+      }
+
+      size_t Read(uint8_t* data, size_t size) override
+      {
+        const size_t readPosition = m_readPosition.load(std::memory_order_relaxed);
+        const size_t writePosition = m_writePosition.load(std::memory_order_acquire);
+
+        size = std::min(size, writePosition - readPosition);
+        const size_t offset = readPosition % m_capacity;
+        const size_t firstPart = std::min(size, m_capacity - offset);
+
+        std::memcpy(data, m_buffer.get() + offset, firstPart);
+        std::memcpy(data + firstPart, m_buffer.get(), size - firstPart);
+
+        m_readPosition.store(readPosition + size, std::memory_order_release);
+        return size;
+      }
+
+      // Safe from either side, the read position is loaded first so the result never wraps
+      size_t GetUsed() const override
+      {
+        const size_t readPosition = m_readPosition.load(std::memory_order_acquire);
+        return m_writePosition.load(std::memory_order_acquire) - readPosition;
+      }
+
+      size_t GetCapacity() const override { return m_capacity; }
+
+    private:
+      std::unique_ptr<uint8_t[]> m_buffer;
+      const size_t m_capacity;
+
+      // On separate cache lines so the two sides don't keep invalidating each other
+      alignas(64) std::atomic<size_t> m_writePosition{0};
+      alignas(64) std::atomic<size_t> m_readPosition{0};
+    };
+  } // namespace utilities
+} // namespace tvlink
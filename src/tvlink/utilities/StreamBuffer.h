@@ -0,0 +1,37 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tvlink
+{
+  namespace utilities
+  {
+    /**
+     * A buffer between one producer thread writing a stream and one consumer
+     * thread reading it. Used counts the bytes written but not read yet.
+     */
+    class StreamBuffer
+    {
+    public:
+      virtual ~StreamBuffer() = default;
+
+      // Producer only, returns the number of bytes that fitted
+      virtual size_t Write(const uint8_t* data, size_t size) = 0;
+      // Consumer only, returns the number of bytes copied out
+      virtual size_t Read(uint8_t* data, size_t size) = 0;
+
+      virtual size_t GetUsed() const = 0;
+      virtual size_t GetCapacity() const = 0;
+      size_t GetFree() const { return GetCapacity() - GetUsed(); }
+    };
+  } // namespace utilities
+} // namespace tvlink
@@ -21,7 +21,7 @@ using namespace tvlink;
 using namespace tvlink::data;
 using namespace tvlink::utilities;
 
-void StreamUtils::SetAllStreamProperties(std::vector<kodi::addon::PVRStreamProperty>& properties, const tvlink::data::Channel& channel, const std::string& streamURL, bool isChannelURL, std::map<std::string, std::string>& catchupProperties)
+void StreamUtils::SetAllStreamProperties(std::vector<kodi::addon::PVRStreamProperty>& properties, const tvlink::data::Channel& channel, const std::string& streamURL, bool isChannelURL, std::map<std::string, std::string>& catchupProperties, StreamType streamType /* OTHER_TYPE */)
 {
   if (ChannelSpecifiesInputstream(channel))
   {
@@ -36,9 +36,8 @@ void StreamUtils::SetAllStreamProperties(std::vector<kodi::addon::PVRStreamPrope
   }
   else
   {
-    StreamType streamType = StreamUtils::GetStreamType(streamURL, channel);
     if (streamType == StreamType::OTHER_TYPE)
-      streamType = StreamUtils::InspectStreamType(streamURL, channel);
+      streamType = StreamUtils::GetStreamType(streamURL, channel);
 
     // Using kodi's built in inputstreams
     if (StreamUtils::UseKodiInputstreams(streamType))
@@ -207,16 +206,89 @@ std::string StreamUtils::GetEffectiveInputStreamName(const StreamType& streamTyp
 
 const StreamType StreamUtils::GetStreamType(const std::string& url, const Channel& channel)
 {
+  // The TVLINK server streams MPEG-TS, so that is the answer for any URL that
+  // does not say otherwise. Only the background prober inspects the stream itself.
+  StreamType streamType;
+  if (GetStreamTypeFromUrlShape(url, channel, streamType))
+    return streamType;
+
   return StreamType::TS;
 }
 
-const StreamType StreamUtils::InspectStreamType(const std::string& url, const Channel& channel)
+bool StreamUtils::GetStreamTypeFromUrlShape(const std::string& url, const Channel& channel, StreamType& streamType)
 {
-  if (!FileUtils::FileExists(url))
-    return StreamType::OTHER_TYPE;
+  if (StringUtils::StartsWith(url, "plugin://"))
+  {
+    streamType = StreamType::PLUGIN;
+    return true;
+  }
 
-  int httpCode = 0;
-  const std::string source = WebUtils::ReadFileContentsStartOnly(url, &httpCode);
+  if (channel.HasMimeType())
+  {
+    const std::string& mimeType = channel.GetMimeType();
+    if (StringUtils::EqualsNoCase(mimeType, "application/x-mpegURL") || StringUtils::EqualsNoCase(mimeType, "application/vnd.apple.mpegurl"))
+      streamType = StreamType::HLS;
+    else if (StringUtils::EqualsNoCase(mimeType, "application/xml+dash") || StringUtils::EqualsNoCase(mimeType, "application/dash+xml"))
+      streamType = StreamType::DASH;
+    else if (StringUtils::EqualsNoCase(mimeType, "application/vnd.ms-sstr+xml"))
+      streamType = StreamType::SMOOTH_STREAMING;
+    else if (StringUtils::EqualsNoCase(mimeType, "video/mp2t"))
+      streamType = StreamType::TS;
+    else
+      streamType = StreamType::MIME_TYPE_UNRECOGNISED;
+
+    return streamType != StreamType::MIME_TYPE_UNRECOGNISED;
+  }
+
+  // Only the path counts, not the query string or any kodi protocol options
+  std::string path = url.substr(0, url.find_first_of("?|#"));
+  StringUtils::ToLower(path);
+
+  if (StringUtils::EndsWith(path, ".m3u8"))
+    streamType = StreamType::HLS;
+  else if (StringUtils::EndsWith(path, ".mpd"))
+    streamType = StreamType::DASH;
+  else if (StringUtils::EndsWith(path, ".ism/manifest") || StringUtils::EndsWith(path, ".isml/manifest"))
+    streamType = StreamType::SMOOTH_STREAMING;
+  else if (StringUtils::EndsWith(path, ".ts"))
+    streamType = StreamType::TS;
+  else
+    return false;
+
+  return true;
+}
+
+const StreamType StreamUtils::InspectStreamType(const std::string& url, const Channel& channel, int* httpCode /* nullptr */)
+{
+  int readHttpCode = 0;
+  std::string source;
+
+  if (FileUtils::FileExists(url))
+    source = WebUtils::ReadFileContentsStartOnly(url, &readHttpCode);
+
+  if (httpCode)
+    *httpCode = readHttpCode;
+
+  return GetStreamTypeFromContents(source, readHttpCode, channel);
+}
+
+const StreamType StreamUtils::InspectStreamType(const std::string& url, const Channel& channel, int timeoutSecs,
+                                                const CancellationToken& token, int* httpCode /* nullptr */)
+{
+  // No separate existence check, that would be a second request without the timeout
+  int readHttpCode = 0;
+  const std::string source = WebUtils::ReadFileContentsStartOnly(url, &readHttpCode, timeoutSecs, token);
+
+  if (httpCode)
+    *httpCode = readHttpCode;
+
+  return GetStreamTypeFromContents(source, readHttpCode, channel);
+}
+
+const StreamType StreamUtils::GetStreamTypeFromContents(const std::string& source, int httpCode, const Channel& channel)
+{
+  if (httpCode == 0)
+    return StreamType::OTHER_TYPE;
 
   if (httpCode == 200)
   {
@@ -10,6 +10,7 @@
 
 #include "../data/Channel.h"
 #include "../data/StreamEntry.h"
+#include "CancellationToken.h"
 
 #include <map>
 #include <string>
@@ -27,9 +28,14 @@ namespace tvlink
     class StreamUtils
     {
     public:
-      static void SetAllStreamProperties(std::vector<kodi::addon::PVRStreamProperty>& properties, const tvlink::data::Channel& channel, const std::string& streamUrl, bool isChannelURL, std::map<std::string, std::string>& catchupProperties);
+      // A known streamType skips classifying the URL again, OTHER_TYPE if unknown
+      static void SetAllStreamProperties(std::vector<kodi::addon::PVRStreamProperty>& properties, const tvlink::data::Channel& channel, const std::string& streamUrl, bool isChannelURL, std::map<std::string, std::string>& catchupProperties, StreamType streamType = StreamType::OTHER_TYPE);
       static const StreamType GetStreamType(const std::string& url, const tvlink::data::Channel& channel);
-      static const StreamType InspectStreamType(const std::string& url, const tvlink::data::Channel& channel);
+      static bool GetStreamTypeFromUrlShape(const std::string& url, const tvlink::data::Channel& channel, StreamType& streamType);
+      static const StreamType InspectStreamType(const std::string& url, const tvlink::data::Channel& channel, int* httpCode = nullptr);
+      // Bounded by timeoutSecs for the connect and for each wait on data, and cancellable, for background probes
+      static const StreamType InspectStreamType(const std::string& url, const tvlink::data::Channel& channel, int timeoutSecs,
+                                                const CancellationToken& token, int* httpCode = nullptr);
       static const std::string GetManifestType(const StreamType& streamType);
       static const std::string GetMimeType(const StreamType& streamType);
       static bool HasMimeType(const StreamType& streamType);
@@ -42,6 +48,7 @@ namespace tvlink
       static std::string GetEffectiveInputStreamName(const StreamType& streamType, const tvlink::data::Channel& channel);
 
     private:
+      static const StreamType GetStreamTypeFromContents(const std::string& source, int httpCode, const tvlink::data::Channel& channel);
       static bool SupportsFFmpegReconnect(const StreamType& streamType, const tvlink::data::Channel& channel);
       static void InspectAndSetFFmpegDirectStreamProperties(std::vector<kodi::addon::PVRStreamProperty>& properties, const tvlink::data::Channel& channel, const std::string& streamUrl, bool isChannelURL);
       static void SetFFmpegDirectManifestTypeStreamProperty(std::vector<kodi::addon::PVRStreamProperty>& properties, const tvlink::data::Channel& channel, const std::string& streamURL, const StreamType& streamType);
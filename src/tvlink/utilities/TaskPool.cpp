@@ -0,0 +1,198 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "TaskPool.h"
+
+#include "Logger.h"
+
+using namespace tvlink;
+using namespace tvlink::utilities;
+
+namespace
+{
+
+// Lets Submit() called from a worker push to that worker's own queue
+thread_local const void* currentPool = nullptr;
+thread_local size_t currentWorkerIndex = 0;
+
+} // unnamed namespace
+
+TaskPool::TaskPool(size_t threadCount)
+{
+  if (threadCount == 0)
+    threadCount = 1;
+
+  m_categoryLimits.fill(threadCount);
+  m_categoryRunning.fill(0);
+
+  for (size_t i = 0; i < threadCount; i++)
+    m_queues.emplace_back(new WorkerQueue());
+
+  for (size_t i = 0; i < threadCount; i++)
+    m_workers.emplace_back([this, i] { WorkerLoop(i); });
+}
+
+TaskPool::~TaskPool()
+{
+  Shutdown();
+}
+
+void TaskPool::SetCategoryLimit(TaskCategory category, size_t limit)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_categoryLimits[static_cast<int>(category)] = limit > 0 ? limit : 1;
+}
+
+void TaskPool::Shutdown()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stopping && m_workers.empty())
+      return;
+
+    m_stopping = true;
+  }
+  m_condition.notify_all();
+
+  for (auto& worker : m_workers)
+  {
+    if (worker.joinable())
+      worker.join();
+  }
+  m_workers.clear();
+
+  // Anything still queued is dropped, which breaks the promise of its future
+  int dropped = 0;
+  for (auto& queue : m_queues)
+  {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    dropped += static_cast<int>(queue->tasks.size());
+    queue->tasks.clear();
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto& deferredTasks : m_deferredTasks)
+  {
+    dropped += static_cast<int>(deferredTasks.size());
+    deferredTasks.clear();
+  }
+  m_pendingTasks = 0;
+
+  Logger::Log(LEVEL_DEBUG, "%s - Task pool stopped, %d queued tasks dropped", __FUNCTION__, dropped);
+}
+
+void TaskPool::Enqueue(Task&& task)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stopping)
+      return;
+  }
+
+  PushToQueue(std::move(task));
+}
+
+void TaskPool::PushToQueue(Task&& task)
+{
+  const size_t queueIndex = currentPool == this ? currentWorkerIndex : m_nextQueue++ % m_queues.size();
+  {
+    std::lock_guard<std::mutex> lock(m_queues[queueIndex]->mutex);
+    m_queues[queueIndex]->tasks.emplace_back(std::move(task));
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pendingTasks++;
+  }
+  m_condition.notify_one();
+}
+
+bool TaskPool::TryDequeue(size_t workerIndex, Task& task)
+{
+  // Newest first from our own queue, oldest first when stealing from the others
+  {
+    WorkerQueue& ownQueue = *m_queues[workerIndex];
+    std::lock_guard<std::mutex> lock(ownQueue.mutex);
+    if (!ownQueue.tasks.empty())
+    {
+      task = std::move(ownQueue.tasks.back());
+      ownQueue.tasks.pop_back();
+      return true;
+    }
+  }
+
+  for (size_t i = 1; i < m_queues.size(); i++)
+  {
+    WorkerQueue& victimQueue = *m_queues[(workerIndex + i) % m_queues.size()];
+    std::lock_guard<std::mutex> lock(victimQueue.mutex);
+    if (!victimQueue.tasks.empty())
+    {
+      task = std::move(victimQueue.tasks.front());
+      victimQueue.tasks.pop_front();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void TaskPool::WorkerLoop(size_t workerIndex)
+{
+  currentPool = this;
+  currentWorkerIndex = workerIndex;
+
+  while (true)
+  {
+    Task task;
+    if (TryDequeue(workerIndex, task))
+    {
+      const int category = static_cast<int>(task.category);
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pendingTasks--;
+
+        if (m_categoryRunning[category] >= m_categoryLimits[category])
+        {
+          // Wait for a task of the same category to finish
+          m_deferredTasks[category].emplace_back(std::move(task));
+          continue;
+        }
+        m_categoryRunning[category]++;
+      }
+
+      if (!task.token.IsCancelled())
+        task.function();
+      task.function = nullptr;
+
+      Task deferredTask;
+      bool hasDeferredTask = false;
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_categoryRunning[category]--;
+
+        if (!m_stopping && !m_deferredTasks[category].empty())
+        {
+          deferredTask = std::move(m_deferredTasks[category].front());
+          m_deferredTasks[category].pop_front();
+          hasDeferredTask = true;
+        }
+      }
+
+      if (hasDeferredTask)
+        PushToQueue(std::move(deferredTask));
+
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [this] { return m_stopping || m_pendingTasks > 0; });
+    if (m_stopping)
+      return;
+  }
+}
@@ -0,0 +1,110 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "CancellationToken.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace tvlink
+{
+  namespace utilities
+  {
+    enum class TaskCategory
+      : int
+    {
+      SCHEDULER = 0, // the refresh scheduler loop, runs for the lifetime of the pool
+      LOADER,        // building and publishing channel/EPG generations
+      FETCH,         // downloads and parsing that a loader waits on
+      MAINTENANCE,   // cache revalidation and eviction
+      PROBE,         // background stream inspection, one task per channel
+      PREWARM        // connecting streams ahead of a channel change
+    };
+
+    /**
+     * A small work-stealing thread pool. Each worker owns a queue, submits from a
+     * worker go to its own queue and idle workers steal from the others. Each
+     * category has a concurrency limit, tasks over the limit wait until a task of
+     * the same category finishes.
+     *
+     * A task whose token is cancelled before it starts, or that is still queued at
+     * shutdown, is not run and its future reports std::future_error (broken_promise).
+     * Tasks that block on other tasks must leave enough workers free for them, so
+     * the limits of the blocking categories add up to less than the thread count.
+     */
+    class TaskPool
+    {
+    public:
+      explicit TaskPool(size_t threadCount);
+      ~TaskPool();
+
+      TaskPool(const TaskPool&) = delete;
+      TaskPool& operator=(const TaskPool&) = delete;
+
+      void SetCategoryLimit(TaskCategory category, size_t limit);
+
+      template<typename F>
+      std::future<typename std::result_of<F()>::type> Submit(TaskCategory category, const CancellationToken& token, F&& function)
+      {
+        using Result = typename std::result_of<F()>::type;
+
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(function));
+        std::future<Result> future = task->get_future();
+        Enqueue({category, token, [task]() { (*task)(); }});
+
+        return future;
+      }
+
+      void Shutdown();
+
+    private:
+      static const int CATEGORY_COUNT = static_cast<int>(TaskCategory::PREWARM) + 1;
+
+      struct Task
+      {
+        TaskCategory category;
+        CancellationToken token;
+        std::function<void()> function;
+      };
+
+      struct WorkerQueue
+      {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+      };
+
+      void Enqueue(Task&& task);
+      void PushToQueue(Task&& task);
+      bool TryDequeue(size_t workerIndex, Task& task);
+      void WorkerLoop(size_t workerIndex);
+
+      std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+      std::vector<std::thread> m_workers;
+      std::atomic<size_t> m_nextQueue{0};
+
+      std::mutex m_mutex;
+      std::condition_variable m_condition;
+      size_t m_pendingTasks = 0;
+      bool m_stopping = false;
+      std::array<size_t, CATEGORY_COUNT> m_categoryLimits;
+      std::array<size_t, CATEGORY_COUNT> m_categoryRunning;
+      std::array<std::deque<Task>, CATEGORY_COUNT> m_deferredTasks;
+    };
+  } // namespace utilities
+} // namespace tvlink
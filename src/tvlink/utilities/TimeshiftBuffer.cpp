@@ -0,0 +1,187 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "TimeshiftBuffer.h"
+
+#include "Logger.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace tvlink::utilities;
+
+TimeshiftBuffer::~TimeshiftBuffer()
+{
+  Close();
+}
+
+bool TimeshiftBuffer::Open(const std::string& filePath, size_t capacity)
+{
+  Close();
+
+  if (!m_writeFile.OpenFileForWrite(filePath, true))
+  {
+    Logger::Log(LEVEL_ERROR, "%s - Could not create timeshift file: %s", __FUNCTION__, filePath.c_str());
+    return false;
+  }
+
+  if (!m_readFile.OpenFile(filePath, ADDON_READ_NO_CACHE))
+  {
+    Logger::Log(LEVEL_ERROR, "%s - Could not open timeshift file for reading: %s", __FUNCTION__, filePath.c_str());
+    m_writeFile.Close();
+    kodi::vfs::DeleteFile(filePath);
+    return false;
+  }
+
+  m_filePath = filePath;
+  m_capacity = capacity;
+  m_writePosition = 0;
+  m_readPosition = 0;
+  m_openTime = std::time(nullptr);
+  m_opened = Clock::now();
+  m_lastWritten = m_opened;
+  m_timeIndex.clear();
+
+  return true;
+}
+
+void TimeshiftBuffer::Close()
+{
+  if (m_filePath.empty())
+    return;
+
+  m_writeFile.Close();
+  m_readFile.Close();
+  kodi::vfs::DeleteFile(m_filePath);
+  m_filePath.clear();
+}
+
+size_t TimeshiftBuffer::Write(const uint8_t* data, size_t size)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  const int64_t writePosition = m_writePosition.load();
+  size = std::min(size, GetFree());
+
+  if (size == 0 || !WriteAt(writePosition, data, size))
+    return 0;
+
+  // Everything a full ring behind the new end has just been overwritten
+  const int64_t startPosition = std::max<int64_t>(0, writePosition + static_cast<int64_t>(size) - static_cast<int64_t>(m_capacity));
+  while (m_timeIndex.size() > 1 && m_timeIndex[1].first <= startPosition)
+    m_timeIndex.pop_front();
+
+  m_lastWritten = Clock::now();
+  if (m_timeIndex.empty() || m_lastWritten - m_timeIndex.back().second >= std::chrono::seconds(TIME_INDEX_INTERVAL_SECS))
+    m_timeIndex.emplace_back(writePosition, m_lastWritten);
+
+  m_writePosition = writePosition + static_cast<int64_t>(size);
+  return size;
+}
+
+size_t TimeshiftBuffer::Read(uint8_t* data, size_t size)
+{
+  const int64_t readPosition = m_readPosition.load();
+  size = std::min(size, GetUsed());
+
+  if (size == 0 || !ReadAt(readPosition, data, size))
+    return 0;
+
+  m_readPosition = readPosition + static_cast<int64_t>(size);
+  return size;
+}
+
+size_t TimeshiftBuffer::GetUsed() const
+{
+  const int64_t readPosition = m_readPosition.load();
+  return static_cast<size_t>(m_writePosition.load() - readPosition);
+}
+
+int64_t TimeshiftBuffer::Seek(int64_t position)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  position = std::min(std::max(position, GetStartPosition()), m_writePosition.load());
+  m_readPosition = position;
+
+  return position;
+}
+
+int64_t TimeshiftBuffer::GetStartPosition() const
+{
+  return std::max<int64_t>(0, m_writePosition.load() - static_cast<int64_t>(m_capacity));
+}
+
+void TimeshiftBuffer::GetTimes(std::chrono::milliseconds& startMillis, std::chrono::milliseconds& endMillis) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  // The index entry at or before the start, the start arrived no earlier than that
+  Clock::time_point started = m_opened;
+  const int64_t startPosition = GetStartPosition();
+  for (const auto& indexEntry : m_timeIndex)
+  {
+    if (indexEntry.first > startPosition)
+      break;
+    started = indexEntry.second;
+  }
+
+  startMillis = std::chrono::duration_cast<std::chrono::milliseconds>(started - m_opened);
+  endMillis = std::chrono::duration_cast<std::chrono::milliseconds>(m_lastWritten - m_opened);
+}
+
+bool TimeshiftBuffer::WriteAt(int64_t position, const uint8_t* data, size_t size)
+{
+  // Wraps around at most once, the size never exceeds the capacity
+  const size_t offset = static_cast<size_t>(position % static_cast<int64_t>(m_capacity));
+  const size_t firstPart = std::min(size, m_capacity - offset);
+
+  if (m_writeFile.Seek(offset, SEEK_SET) != static_cast<int64_t>(offset) ||
+      m_writeFile.Write(data, firstPart) != static_cast<ssize_t>(firstPart))
+  {
+    Logger::Log(LEVEL_ERROR, "%s - Could not write to timeshift file: %s", __FUNCTION__, m_filePath.c_str());
+    return false;
+  }
+
+  if (firstPart == size)
+    return true;
+
+  if (m_writeFile.Seek(0, SEEK_SET) != 0 ||
+      m_writeFile.Write(data + firstPart, size - firstPart) != static_cast<ssize_t>(size - firstPart))
+  {
+    Logger::Log(LEVEL_ERROR, "%s - Could not write to timeshift file: %s", __FUNCTION__, m_filePath.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+bool TimeshiftBuffer::ReadAt(int64_t position, uint8_t* data, size_t size)
+{
+  size_t totalRead = 0;
+  while (totalRead < size)
+  {
+    const size_t offset = static_cast<size_t>((position + static_cast<int64_t>(totalRead)) % static_cast<int64_t>(m_capacity));
+    const size_t wanted = std::min(size - totalRead, m_capacity - offset);
+
+    // A local file can return less than asked for, the rest is there anyway
+    ssize_t bytesRead = 0;
+    if (m_readFile.Seek(offset, SEEK_SET) == static_cast<int64_t>(offset))
+      bytesRead = m_readFile.Read(data + totalRead, wanted);
+
+    if (bytesRead <= 0)
+    {
+      Logger::Log(LEVEL_ERROR, "%s - Could not read from timeshift file: %s", __FUNCTION__, m_filePath.c_str());
+      return false;
+    }
+
+    totalRead += static_cast<size_t>(bytesRead);
+  }
+
+  return true;
+}
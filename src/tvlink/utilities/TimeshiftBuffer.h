@@ -0,0 +1,94 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "StreamBuffer.h"
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <kodi/Filesystem.h>
+
+namespace tvlink
+{
+  namespace utilities
+  {
+    /**
+     * A size capped ring kept in a file, so a live stream can be buffered far
+     * beyond what fits in memory. The producer keeps appending while the
+     * consumer reads at its own position, which can be moved back over the data
+     * already played for as long as it is still in the file. The oldest data
+     * are overwritten once the file is full, never the data not read yet.
+     *
+     * Positions count the bytes since the buffer was opened. The file is written
+     * and read through separate handles, the read handle bypasses the file cache
+     * so it always sees what was just written.
+     */
+    class TimeshiftBuffer : public StreamBuffer
+    {
+    public:
+      using Clock = std::chrono::steady_clock;
+
+      TimeshiftBuffer() = default;
+      ~TimeshiftBuffer() override;
+
+      TimeshiftBuffer(const TimeshiftBuffer&) = delete;
+      TimeshiftBuffer& operator=(const TimeshiftBuffer&) = delete;
+
+      // Creates or truncates the file, it is deleted again by Close
+      bool Open(const std::string& filePath, size_t capacity);
+      void Close();
+
+      size_t Write(const uint8_t* data, size_t size) override;
+      size_t Read(uint8_t* data, size_t size) override;
+
+      size_t GetUsed() const override;
+      size_t GetCapacity() const override { return m_capacity; }
+
+      // Consumer only, clamps to the data still in the file and returns the new read position
+      int64_t Seek(int64_t position);
+
+      int64_t GetStartPosition() const;
+      int64_t GetReadPosition() const { return m_readPosition; }
+      int64_t GetWritePosition() const { return m_writePosition; }
+
+      // When the buffer was opened, and how long after that the oldest and the newest data arrived
+      time_t GetOpenTime() const { return m_openTime; }
+      void GetTimes(std::chrono::milliseconds& startMillis, std::chrono::milliseconds& endMillis) const;
+
+    private:
+      static constexpr int TIME_INDEX_INTERVAL_SECS = 1;
+
+      bool WriteAt(int64_t position, const uint8_t* data, size_t size);
+      bool ReadAt(int64_t position, uint8_t* data, size_t size);
+
+      std::string m_filePath;
+      kodi::vfs::CFile m_writeFile;
+      kodi::vfs::CFile m_readFile;
+      size_t m_capacity = 0;
+
+      std::atomic<int64_t> m_writePosition{0};
+      std::atomic<int64_t> m_readPosition{0};
+
+      time_t m_openTime = 0;
+      Clock::time_point m_opened;
+      Clock::time_point m_lastWritten;
+      std::deque<std::pair<int64_t, Clock::time_point>> m_timeIndex; // arrival time of a position, about once a second
+
+      // Held by the producer while writing and by seeks, so a seek back never
+      // lands on data that are being overwritten
+      mutable std::mutex m_mutex;
+    };
+  } // namespace utilities
+} // namespace tvlink
@@ -0,0 +1,172 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "TsFramer.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TSFRAMER_USE_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+using namespace tvlink::utilities;
+
+namespace
+{
+
+#if defined(TSFRAMER_USE_SSE2)
+int CountTrailingZeros(unsigned int mask)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+// Position of the next sync byte candidate at or after from, size if there is none
+size_t FindSyncByte(const uint8_t* data, size_t from, size_t size)
+{
+  size_t position = from;
+
+#if defined(TSFRAMER_USE_SSE2)
+  // Compare 16 bytes at a time, the mask has a bit set for each byte that matched
+  const __m128i syncBytes = _mm_set1_epi8(static_cast<char>(TsFramer::SYNC_BYTE));
+  for (; position + 16 <= size; position += 16)
+  {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position));
+    const unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, syncBytes)));
+    if (mask != 0)
+      return position + CountTrailingZeros(mask);
+  }
+#endif
+
+  if (position >= size)
+    return size;
+
+  const void* found = std::memchr(data + position, TsFramer::SYNC_BYTE, size - position);
+  return found ? static_cast<const uint8_t*>(found) - data : size;
+}
+
+} // unnamed namespace
+
+bool TsFramer::IsTransportStream(const uint8_t* data, size_t size)
+{
+  for (size_t offset = FindSyncByte(data, 0, size); offset < PACKET_SIZE && offset + PACKET_SIZE < size; offset = FindSyncByte(data, offset + 1, size))
+  {
+    if (data[offset + PACKET_SIZE] == SYNC_BYTE && (offset + 2 * PACKET_SIZE >= size || data[offset + 2 * PACKET_SIZE] == SYNC_BYTE))
+      return true;
+  }
+
+  return false;
+}
+
+size_t TsFramer::TakeCarry(uint8_t* buffer)
+{
+  const size_t carrySize = m_carrySize;
+  std::memcpy(buffer, m_carry.data(), carrySize);
+  m_carrySize = 0;
+
+  return carrySize;
+}
+
+size_t TsFramer::Frame(uint8_t* data, size_t size)
+{
+  size_t framedSize = 0;
+  size_t position = 0;
+
+  while (position + PACKET_SIZE <= size)
+  {
+    if (data[position] != SYNC_BYTE)
+    {
+      if (m_synced)
+      {
+        m_syncErrors++;
+        m_synced = false;
+      }
+      position = FindSyncByte(data, position + 1, size);
+      continue;
+    }
+
+    // Out of sync a candidate only counts once the next packet starts where expected
+    if (!m_synced)
+    {
+      if (position + PACKET_SIZE == size)
+        break;
+      if (data[position + PACKET_SIZE] != SYNC_BYTE)
+      {
+        position = FindSyncByte(data, position + 1, size);
+        continue;
+      }
+      m_synced = true;
+    }
+
+    if (framedSize != position)
+      std::memmove(data + framedSize, data + position, PACKET_SIZE);
+
+    CheckContinuity(data + framedSize);
+    m_packets++;
+    framedSize += PACKET_SIZE;
+    position += PACKET_SIZE;
+  }
+
+  // At most one packet is left, it is completed by the next read
+  m_carrySize = size - position;
+  std::memcpy(m_carry.data(), data + position, m_carrySize);
+
+  return framedSize;
+}
+
+void TsFramer::CheckContinuity(const uint8_t* packet)
+{
+  const int pid = ((packet[1] & 0x1F) << 8) | packet[2];
+  if (pid == PID_COUNT - 1) // null packets
+    return;
+
+  const uint8_t adaptationFieldControl = (packet[3] >> 4) & 0x03;
+  const uint8_t continuity = packet[3] & 0x0F;
+
+  // A flagged discontinuity starts the counter over
+  if ((adaptationFieldControl & 0x02) && packet[4] > 0 && (packet[5] & 0x80))
+  {
+    m_lastContinuity[pid] = continuity;
+    return;
+  }
+
+  // The counter only advances on packets with payload, a repeat of the last packet is allowed
+  if (!(adaptationFieldControl & 0x01))
+    return;
+
+  const uint8_t lastContinuity = m_lastContinuity[pid];
+  if (lastContinuity != NO_CONTINUITY && continuity != lastContinuity && continuity != ((lastContinuity + 1) & 0x0F))
+    m_continuityErrors++;
+
+  m_lastContinuity[pid] = continuity;
+}
+
+void TsFramer::Reset()
+{
+  m_carrySize = 0;
+  m_synced = false;
+  m_lastContinuity.fill(NO_CONTINUITY);
+}
+
+void TsFramer::Clear()
+{
+  Reset();
+  m_packets = 0;
+  m_syncErrors = 0;
+  m_continuityErrors = 0;
+}
@@ -0,0 +1,71 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace tvlink
+{
+  namespace utilities
+  {
+    /**
+     * Cuts an MPEG-TS byte stream into whole 188 byte packets. Data is framed in
+     * place, bytes that are not part of a packet are dropped and the tail of a
+     * packet that has not fully arrived is carried over to the next read. While
+     * framing it counts lost syncs and continuity counter errors, which is a
+     * cheap way to notice a corrupt stream.
+     *
+     * Only used from the thread reading the network.
+     */
+    class TsFramer
+    {
+    public:
+      static constexpr size_t PACKET_SIZE = 188;
+      static constexpr uint8_t SYNC_BYTE = 0x47;
+
+      TsFramer() { Clear(); }
+
+      // Returns whether the data looks like MPEG-TS, a sync byte confirmed by the following packets
+      static bool IsTransportStream(const uint8_t* data, size_t size);
+
+      // Copies the carried over bytes to the buffer start, the next read goes after them
+      size_t TakeCarry(uint8_t* buffer);
+
+      // Frames data in place, returns the size of the whole packets now at the start of data
+      size_t Frame(uint8_t* data, size_t size);
+
+      // Forgets the carried over bytes and the sync and continuity state, for a seam in the stream
+      void Reset();
+      // Reset and zero the counters, for a new stream
+      void Clear();
+
+      unsigned int GetPackets() const { return m_packets; }
+      unsigned int GetSyncErrors() const { return m_syncErrors; }
+      unsigned int GetContinuityErrors() const { return m_continuityErrors; }
+
+    private:
+      static const int PID_COUNT = 0x2000;
+      static constexpr uint8_t NO_CONTINUITY = 0xFF;
+
+      void CheckContinuity(const uint8_t* packet);
+
+      std::array<uint8_t, PACKET_SIZE> m_carry;
+      size_t m_carrySize;
+      bool m_synced;
+
+      std::array<uint8_t, PID_COUNT> m_lastContinuity;
+
+      unsigned int m_packets;
+      unsigned int m_syncErrors;
+      unsigned int m_continuityErrors;
+    };
+  } // namespace utilities
+} // namespace tvlink
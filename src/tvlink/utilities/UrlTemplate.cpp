@@ -0,0 +1,276 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "UrlTemplate.h"
+
+#include "TimeUtils.h"
+
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+using namespace tvlink;
+using namespace tvlink::utilities;
+
+namespace
+{
+
+struct SpecifierPattern
+{
+  const char* text;
+  int value; // UrlTemplate::TimeValue
+  bool inNowScope;
+};
+
+// Matched as written, e.g. {utc}
+const SpecifierPattern EPOCH_PATTERNS[] = {
+  {"{utc}", 0, false},
+  {"${start}", 0, false},
+  {"{utcend}", 1, false},
+  {"${end}", 1, false},
+  {"{lutc}", 2, true},
+  {"${now}", 2, true},
+  {"${timestamp}", 2, true},
+  {"{duration}", 3, false},
+  {"${offset}", 4, false},
+};
+
+// Followed by a format and a closing brace, e.g. {utc:Y-m-d}
+const SpecifierPattern TIME_FORMAT_PATTERNS[] = {
+  {"{utc:", 0, false},
+  {"${start:", 0, false},
+  {"{utcend:", 1, false},
+  {"${end:", 1, false},
+  {"{lutc:", 2, true},
+  {"${now:", 2, true},
+  {"${timestamp:", 2, true},
+};
+
+// Followed by a divider and a closing brace, e.g. {offset:60}
+const SpecifierPattern UNITS_PATTERNS[] = {
+  {"{duration:", 3, false},
+  {"{offset:", 4, false},
+};
+
+const char* const START_TIME_FIELDS = "YmdHMS";
+const std::string CATCHUP_ID_SPECIFIER = "{catchup-id}";
+
+const int EPOCH_PATTERN_COUNT = sizeof(EPOCH_PATTERNS) / sizeof(EPOCH_PATTERNS[0]);
+const int TIME_FORMAT_PATTERN_COUNT = sizeof(TIME_FORMAT_PATTERNS) / sizeof(TIME_FORMAT_PATTERNS[0]);
+const int UNITS_PATTERN_COUNT = sizeof(UNITS_PATTERNS) / sizeof(UNITS_PATTERNS[0]);
+
+bool MatchesAt(const std::string& format, size_t pos, const char* text)
+{
+  return format.compare(pos, std::strlen(text), text) == 0;
+}
+
+} // unnamed namespace
+
+UrlTemplate::UrlTemplate(const std::string& format, UrlTemplateScope scope)
+  : m_format(format)
+{
+  Compile(scope);
+}
+
+void UrlTemplate::AddLiteral(size_t pos, size_t length)
+{
+  if (!m_tokens.empty() && m_tokens.back().type == TokenType::LITERAL &&
+      m_tokens.back().sourcePos + m_tokens.back().sourceLength == pos)
+  {
+    m_tokens.back().sourceLength += length;
+    return;
+  }
+
+  m_tokens.push_back({TokenType::LITERAL, TimeValue::START, pos, length, 0, ""});
+}
+
+void UrlTemplate::Compile(UrlTemplateScope scope)
+{
+  const bool nowOnly = scope == UrlTemplateScope::NOW_ONLY;
+
+  bool epochSeen[EPOCH_PATTERN_COUNT] = {};
+  bool timeFormatSeen[TIME_FORMAT_PATTERN_COUNT] = {};
+  std::vector<size_t> unitsCandidates[UNITS_PATTERN_COUNT];
+
+  size_t pos = 0;
+  while (pos < m_format.size())
+  {
+    const char ch = m_format[pos];
+    if (ch != '{' && ch != '$')
+    {
+      AddLiteral(pos++, 1);
+      continue;
+    }
+
+    bool matched = false;
+
+    if (!nowOnly && ch == '{' && pos + 2 < m_format.size() && m_format[pos + 2] == '}' &&
+        std::strchr(START_TIME_FIELDS, m_format[pos + 1]))
+    {
+      m_tokens.push_back({TokenType::TIME_FORMAT, TimeValue::START, pos, 3, 0, std::string("%") + m_format[pos + 1]});
+      m_usesLocalTime[static_cast<int>(TimeValue::START)] = true;
+      pos += 3;
+      continue;
+    }
+
+    if (MatchesAt(m_format, pos, CATCHUP_ID_SPECIFIER.c_str()))
+    {
+      m_tokens.push_back({TokenType::CATCHUP_ID, TimeValue::START, pos, CATCHUP_ID_SPECIFIER.size(), 0, ""});
+      pos += CATCHUP_ID_SPECIFIER.size();
+      continue;
+    }
+
+    for (int i = 0; i < EPOCH_PATTERN_COUNT && !matched; i++)
+    {
+      const SpecifierPattern& pattern = EPOCH_PATTERNS[i];
+      if ((nowOnly && !pattern.inNowScope) || !MatchesAt(m_format, pos, pattern.text))
+        continue;
+
+      const size_t length = std::strlen(pattern.text);
+      if (epochSeen[i])
+        AddLiteral(pos, length);
+      else
+        m_tokens.push_back({TokenType::EPOCH, static_cast<TimeValue>(pattern.value), pos, length, 0, ""});
+
+      epochSeen[i] = true;
+      pos += length;
+      matched = true;
+    }
+
+    for (int i = 0; i < TIME_FORMAT_PATTERN_COUNT && !matched; i++)
+    {
+      const SpecifierPattern& pattern = TIME_FORMAT_PATTERNS[i];
+      if ((nowOnly && !pattern.inNowScope) || timeFormatSeen[i] || !MatchesAt(m_format, pos, pattern.text))
+        continue;
+
+      // Only the first occurrence counts, even if it has no closing brace
+      timeFormatSeen[i] = true;
+
+      // The format is at least one character long
+      const size_t formatStart = pos + std::strlen(pattern.text);
+      const size_t formatEnd = m_format.find('}', formatStart + 1);
+      if (formatEnd == std::string::npos)
+        continue;
+
+      std::string timeFormat;
+      for (size_t formatPos = formatStart; formatPos < formatEnd; formatPos++)
+      {
+        if (std::strchr(START_TIME_FIELDS, m_format[formatPos]))
+          timeFormat += '%';
+        timeFormat += m_format[formatPos];
+      }
+
+      m_tokens.push_back({TokenType::TIME_FORMAT, static_cast<TimeValue>(pattern.value), pos, formatEnd - pos + 1, 0, timeFormat});
+      m_usesLocalTime[pattern.value] = true;
+      pos = formatEnd + 1;
+      matched = true;
+    }
+
+    for (int i = 0; i < UNITS_PATTERN_COUNT && !matched && !nowOnly; i++)
+    {
+      const SpecifierPattern& pattern = UNITS_PATTERNS[i];
+      if (!MatchesAt(m_format, pos, pattern.text))
+        continue;
+
+      const size_t digitsStart = pos + std::strlen(pattern.text);
+      size_t digitsEnd = digitsStart;
+      while (digitsEnd < m_format.size() && std::isdigit(static_cast<unsigned char>(m_format[digitsEnd])))
+        digitsEnd++;
+
+      if (digitsEnd == digitsStart || digitsEnd >= m_format.size() || m_format[digitsEnd] != '}')
+        continue;
+
+      const long long divider = digitsEnd - digitsStart > 10 ? 0 : std::strtoll(m_format.c_str() + digitsStart, nullptr, 10);
+      unitsCandidates[i].emplace_back(m_tokens.size());
+      m_tokens.push_back({TokenType::UNITS, static_cast<TimeValue>(pattern.value), pos, digitsEnd - pos + 1,
+                          static_cast<time_t>(divider <= INT_MAX ? divider : 0), ""});
+      pos = digitsEnd + 1;
+      matched = true;
+    }
+
+    if (!matched)
+      AddLiteral(pos++, 1);
+  }
+
+  // Of the units specifiers only the last one written is used, and that text
+  // is replaced where it first occurs. All the others stay as they are.
+  for (const auto& candidates : unitsCandidates)
+  {
+    if (candidates.empty())
+      continue;
+
+    const Token& last = m_tokens[candidates.back()];
+    const std::string lastText = m_format.substr(last.sourcePos, last.sourceLength);
+    bool replaced = false;
+    for (size_t index : candidates)
+    {
+      Token& token = m_tokens[index];
+      if (!replaced && token.divider != 0 && m_format.compare(token.sourcePos, token.sourceLength, lastText) == 0)
+        replaced = true;
+      else
+        token.type = TokenType::LITERAL;
+    }
+  }
+}
+
+std::string UrlTemplate::Render(time_t start, time_t duration, time_t now, const std::string& catchupId) const
+{
+  const time_t values[] = {start, start + duration, now, duration, now - start};
+
+  std::tm localTimes[3];
+  for (int i = 0; i < 3; i++)
+  {
+    if (m_usesLocalTime[i])
+      localTimes[i] = SafeLocaltime(values[i]);
+  }
+
+  std::string url;
+  url.reserve(m_format.size() + 32);
+
+  for (const auto& token : m_tokens)
+  {
+    const int value = static_cast<int>(token.value);
+    switch (token.type)
+    {
+      case TokenType::EPOCH:
+        url += std::to_string(static_cast<unsigned long>(values[value]));
+        continue;
+      case TokenType::UNITS:
+      {
+        time_t units = values[value] / token.divider;
+        url += std::to_string(units < 0 ? 0 : units);
+        continue;
+      }
+      case TokenType::TIME_FORMAT:
+      {
+        char buffer[256];
+        size_t length = std::strftime(buffer, sizeof(buffer), token.timeFormat.c_str(), &localTimes[value]);
+        if (length > 0)
+        {
+          url.append(buffer, length);
+          continue;
+        }
+        break;
+      }
+      case TokenType::CATCHUP_ID:
+        if (!catchupId.empty())
+        {
+          url += catchupId;
+          continue;
+        }
+        break;
+      case TokenType::LITERAL:
+        break;
+    }
+
+    url.append(m_format, token.sourcePos, token.sourceLength);
+  }
+
+  return url;
+}
@@ -0,0 +1,88 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace tvlink
+{
+  namespace utilities
+  {
+    enum class UrlTemplateScope
+    {
+      ALL,     // catchup sources: start, end, now, duration, offset and catchup-id specifiers
+      NOW_ONLY // stream URLs: only the current time and catchup-id specifiers
+    };
+
+    /**
+     * A catchup/stream URL format string compiled into a list of tokens, so a URL
+     * is rendered in a single pass without any searching or regex work.
+     *
+     * Rendering gives the same result as applying the specifiers one after the
+     * other: {Y}, {m}, {d}, {H}, {M}, {S} and {catchup-id} are replaced everywhere,
+     * for all other specifiers only the first occurrence is replaced, and for
+     * {duration:N}/{offset:N} only the first occurrence of the last one written.
+     * Specifiers are not expected to nest, a time format is read up to the first
+     * closing brace.
+     */
+    class UrlTemplate
+    {
+    public:
+      UrlTemplate() = default;
+      UrlTemplate(const std::string& format, UrlTemplateScope scope);
+
+      const std::string& GetFormat() const { return m_format; }
+      bool IsEmpty() const { return m_format.empty(); }
+
+      /**
+       * An empty catchupId leaves {catchup-id} in the URL as is.
+       */
+      std::string Render(time_t start, time_t duration, time_t now, const std::string& catchupId) const;
+
+    private:
+      enum class TokenType
+      {
+        LITERAL,
+        EPOCH,
+        UNITS,
+        TIME_FORMAT,
+        CATCHUP_ID
+      };
+
+      enum class TimeValue
+      {
+        START = 0,
+        END,
+        NOW,
+        DURATION,
+        OFFSET
+      };
+
+      struct Token
+      {
+        TokenType type;
+        TimeValue value;
+        // The literal text or the specifier as written, which is output if it can't be rendered
+        size_t sourcePos;
+        size_t sourceLength;
+        time_t divider;
+        std::string timeFormat;
+      };
+
+      void Compile(UrlTemplateScope scope);
+      void AddLiteral(size_t pos, size_t length);
+
+      std::string m_format;
+      std::vector<Token> m_tokens;
+      bool m_usesLocalTime[3] = {false, false, false}; // START, END, NOW
+    };
+  } // namespace utilities
+} // namespace tvlink
@@ -63,11 +63,78 @@ std::string WebUtils::ReadFileContentsStartOnly(const std::string& url, int* htt
   return strContent;
 }
 
+std::string WebUtils::ReadFileContentsStartOnly(const std::string& url, int* httpCode, int timeoutSecs, const CancellationToken& token)
+{
+  // 0 as when the file does not exist, the connect failed or was not tried
+  *httpCode = 0;
+  if (token.IsCancelled())
+    return {};
+
+  kodi::vfs::CFile file;
+  file.CURLCreate(url);
+  file.CURLAddOption(ADDON_CURL_OPTION_PROTOCOL, "connection-timeout", std::to_string(timeoutSecs));
+  file.CURLAddOption(ADDON_CURL_OPTION_PROTOCOL, "lowspeed-time", std::to_string(timeoutSecs));
+
+  if (!file.CURLOpen(ADDON_READ_NO_CACHE) || token.IsCancelled())
+    return {};
+
+  std::string strContent;
+  char buffer[1024];
+  const ssize_t bytesRead = file.Read(buffer, sizeof(buffer));
+  if (bytesRead > 0)
+    strContent.append(buffer, bytesRead);
+
+  if (token.IsCancelled())
+    return {};
+
+  *httpCode = strContent.empty() ? 500 : 200;
+
+  return strContent;
+}
+
 bool WebUtils::IsHttpUrl(const std::string& url)
 {
   return StringUtils::StartsWith(url, HTTP_PREFIX) || StringUtils::StartsWith(url, HTTPS_PREFIX);
 }
 
+bool WebUtils::SplitHttpUrl(const std::string& url, std::string& schemeAndHost, std::string& path)
+{
+  // "http[s]://host[:port]/path", the host must not be empty and must be followed by a '/'
+  size_t hostStart;
+  if (StringUtils::StartsWith(url, HTTP_PREFIX))
+    hostStart = HTTP_PREFIX.size();
+  else if (StringUtils::StartsWith(url, HTTPS_PREFIX))
+    hostStart = HTTPS_PREFIX.size();
+  else
+    return false;
+
+  const size_t hostEnd = url.find('/', hostStart);
+  if (hostEnd == std::string::npos || hostEnd == hostStart)
+    return false;
+
+  schemeAndHost = url.substr(0, hostEnd);
+  path = url.substr(hostEnd + 1);
+
+  return true;
+}
+
+std::vector<std::string> WebUtils::SplitPath(const std::string& path)
+{
+  // Empty segments are kept so callers can reject "a//b"
+  std::vector<std::string> segments;
+
+  size_t segmentStart = 0;
+  size_t segmentEnd;
+  while ((segmentEnd = path.find('/', segmentStart)) != std::string::npos)
+  {
+    segments.emplace_back(path, segmentStart, segmentEnd - segmentStart);
+    segmentStart = segmentEnd + 1;
+  }
+  segments.emplace_back(path, segmentStart, std::string::npos);
+
+  return segments;
+}
+
 std::string WebUtils::RedactUrl(const std::string& url)
 {
   std::string redactedUrl = url;
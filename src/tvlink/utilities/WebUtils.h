@@ -8,7 +8,10 @@
 
 #pragma once
 
+#include "CancellationToken.h"
+
 #include <string>
+#include <vector>
 
 namespace tvlink
 {
@@ -24,7 +27,11 @@ namespace tvlink
     public:
       static const std::string UrlEncode(const std::string& value);
       static std::string ReadFileContentsStartOnly(const std::string& url, int* httpCode);
+      // For background reads, gives up on a server that is silent for timeoutSecs and drops the read once the token is cancelled
+      static std::string ReadFileContentsStartOnly(const std::string& url, int* httpCode, int timeoutSecs, const CancellationToken& token);
       static bool IsHttpUrl(const std::string& url);
+      static bool SplitHttpUrl(const std::string& url, std::string& schemeAndHost, std::string& path);
+      static std::vector<std::string> SplitPath(const std::string& path);
       static std::string RedactUrl(const std::string& url);
     };
   } // namespace utilities
@@ -0,0 +1,42 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace tvlink
+{
+  namespace test
+  {
+    using Clock = std::chrono::steady_clock;
+
+    inline double GetMillis(Clock::duration duration)
+    {
+      return std::chrono::duration_cast<std::chrono::microseconds>(duration).count() / 1000.0;
+    }
+
+    inline void PrintLatencies(const char* mode, std::vector<double> latencies)
+    {
+      if (latencies.empty())
+        return;
+
+      std::sort(latencies.begin(), latencies.end());
+
+      double total = 0;
+      for (double latency : latencies)
+        total += latency;
+
+      std::printf("%-17s mean %7.2f ms, p50 %7.2f ms, p95 %7.2f ms\n", mode, total / latencies.size(),
+                  latencies[latencies.size() / 2], latencies[std::min(latencies.size() - 1, latencies.size() * 95 / 100)]);
+    }
+  } // namespace test
+} // namespace tvlink
@@ -0,0 +1,256 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "TestUtils.h"
+
+#include "tvlink/data/Channel.h"
+
+#include <chrono>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace tvlink::data;
+
+namespace
+{
+
+struct CatchupSource
+{
+  bool m_generated = false;
+  std::string m_catchupSource;
+  bool m_isCatchupTSStream = false;
+
+  bool operator==(const CatchupSource& right) const
+  {
+    return m_generated == right.m_generated && m_catchupSource == right.m_catchupSource &&
+           m_isCatchupTSStream == right.m_isCatchupTSStream;
+  }
+};
+
+// The regex matching that Channel used before the URLs were split by hand,
+// kept as the reference the current implementation has to agree with
+
+CatchupSource GenerateFlussonicCatchupSourceByRegex(const std::string& url)
+{
+  static std::regex fsRegex("^(http[s]?://[^/]+)/([^/]+)/([^/]*)(mpegts|\\.m3u8)(\\?.+=.+)?$");
+  std::smatch matches;
+
+  CatchupSource catchupSource;
+  if (std::regex_match(url, matches, fsRegex) && matches.size() == 6)
+  {
+    const std::string fsHost = matches[1].str();
+    const std::string fsChannelId = matches[2].str();
+    const std::string fsListType = matches[3].str();
+    const std::string fsStreamType = matches[4].str();
+    const std::string fsUrlAppend = matches[5].str();
+
+    catchupSource.m_generated = true;
+    catchupSource.m_isCatchupTSStream = fsStreamType == "mpegts";
+    if (catchupSource.m_isCatchupTSStream)
+      catchupSource.m_catchupSource = fsHost + "/" + fsChannelId + "/timeshift_abs-${start}.ts" + fsUrlAppend;
+    else if (fsListType == "index")
+      catchupSource.m_catchupSource = fsHost + "/" + fsChannelId + "/timeshift_rel-{offset:1}.m3u8" + fsUrlAppend;
+    else
+      catchupSource.m_catchupSource = fsHost + "/" + fsChannelId + "/" + fsListType + "-timeshift_rel-{offset:1}.m3u8" + fsUrlAppend;
+  }
+
+  return catchupSource;
+}
+
+CatchupSource GenerateXtreamCodesCatchupSourceByRegex(const std::string& url)
+{
+  static std::regex xcRegex("^(http[s]?://[^/]+)/(?:live/)?([^/]+)/([^/]+)/([^/\\.]+)(\\.m3u[8]?)?$");
+  std::smatch matches;
+
+  CatchupSource catchupSource;
+  if (std::regex_match(url, matches, xcRegex) && matches.size() == 6)
+  {
+    const std::string xcHost = matches[1].str();
+    const std::string xcUsername = matches[2].str();
+    const std::string xcPasssword = matches[3].str();
+    const std::string xcChannelId = matches[4].str();
+    std::string xcExtension;
+    if (matches[5].matched)
+      xcExtension = matches[5].str();
+
+    if (xcExtension.empty())
+    {
+      catchupSource.m_isCatchupTSStream = true;
+      xcExtension = ".ts";
+    }
+
+    catchupSource.m_generated = true;
+    catchupSource.m_catchupSource = xcHost + "/timeshift/" + xcUsername + "/" + xcPasssword +
+                                    "/{duration:60}/{Y}-{m}-{d}:{H}-{M}/" + xcChannelId + xcExtension;
+  }
+
+  return catchupSource;
+}
+
+CatchupSource GenerateFlussonicCatchupSource(const std::string& url)
+{
+  Channel channel;
+  CatchupSource catchupSource;
+  catchupSource.m_generated = channel.GenerateFlussonicCatchupSource(url);
+  if (catchupSource.m_generated)
+  {
+    catchupSource.m_catchupSource = channel.GetCatchupSource();
+    catchupSource.m_isCatchupTSStream = channel.IsCatchupTSStream();
+  }
+  return catchupSource;
+}
+
+CatchupSource GenerateXtreamCodesCatchupSource(const std::string& url)
+{
+  Channel channel;
+  CatchupSource catchupSource;
+  catchupSource.m_generated = channel.GenerateXtreamCodesCatchupSource(url);
+  if (catchupSource.m_generated)
+  {
+    catchupSource.m_catchupSource = channel.GetCatchupSource();
+    catchupSource.m_isCatchupTSStream = channel.IsCatchupTSStream();
+  }
+  return catchupSource;
+}
+
+// Stream URLs as they appear in provider playlists, with the hosts and
+// credentials replaced, plus the near misses around each form
+const std::vector<std::string> STREAM_URLS = {
+  // Flussonic
+  "http://ch01.spr24.net/151/mpegts?token=my_token",
+  "http://list.tv:8888/325/index.m3u8?token=secret",
+  "http://list.tv:8888/325/mono.m3u8?token=secret",
+  "http://list.tv:8888/325/video.m3u8",
+  "https://edge3.example.net:443/rtl_hd/tracks-v1a1/mono.m3u8?token=abc",
+  "http://178.62.10.4:8080/first_hd/mpegts",
+  "http://178.62.10.4:8080/first_hd/mpegts?token=a&sid=b",
+  "http://list.tv:8888/325/mpegts.m3u8",
+  "http://list.tv:8888/325/index.m3u8?token=abc/def=ghi",
+  "http://list.tv:8888/325/index.m3u8?token",
+  "http://list.tv:8888/325/index.m3u8?==",
+  "http://list.tv:8888/325/index.m3u8?===",
+  "http://list.tv:8888/325/index.m3u8?a=b?c=d",
+  "http://list.tv:8888/325/.m3u8",
+  "http://list.tv:8888//index.m3u8",
+  "http://list.tv:8888/325/index.m3u8/",
+  "http://list.tv:8888/325/index.m3u",
+  "http:///325/index.m3u8",
+  "rtmp://list.tv:8888/325/index.m3u8",
+  "HTTP://list.tv:8888/325/index.m3u8",
+  // Xtream codes
+  "http://list.tv:8080/my@account.xc/my_password/1477",
+  "http://list.tv:8080/live/my@account.xc/my_password/1477.m3u8",
+  "http://list.tv:8080/live/my@account.xc/my_password/1477.m3u",
+  "http://list.tv:8080/live/my@account.xc/my_password/1477.ts",
+  "http://list.tv:8080/live/my@account.xc/my_password/1477",
+  "http://list.tv:8080/live/my_password/1477",
+  "http://list.tv:8080/live/live/my_password/1477",
+  "https://xc.example.com/user/pass/1477.m3u8",
+  "http://list.tv:8080/user/pass/1477.m3u8?token=x",
+  "http://list.tv:8080/user/pass/1477.m3u88",
+  "http://list.tv:8080/user//1477",
+  "http://list.tv:8080/user/pass/",
+  "http://list.tv:8080/movie/user/pass/1477.mkv",
+  "http://list.tv:8080/a/b/c/d/e",
+  "http://list.tv:8080/user/pass/14.77",
+  // Neither
+  "",
+  "http://",
+  "http://list.tv:8080",
+  "http://list.tv:8080/",
+  "udp://@239.0.0.1:1234",
+};
+
+// Random URLs put together from the pieces the two forms are made of
+std::vector<std::string> GenerateRandomStreamURLs(size_t count)
+{
+  static const std::vector<std::string> pieces = {
+    "http://", "https://", "list.tv:8080", "/", "/", "/", "live/", "live", "index", "mono", "mpegts",
+    ".m3u8", ".m3u", ".ts", ".", "?", "=", "?token=", "a", "1477", "user@xc", "",
+  };
+
+  std::mt19937 random(20201019);
+  std::uniform_int_distribution<size_t> pieceDistribution(0, pieces.size() - 1);
+  std::uniform_int_distribution<int> lengthDistribution(1, 12);
+
+  std::vector<std::string> urls;
+  urls.reserve(count);
+  for (size_t i = 0; i < count; i++)
+  {
+    // Mostly starting with a scheme and host, otherwise nearly nothing matches
+    std::string url = i % 4 == 0 ? "" : "http://list.tv:8080/";
+    const int length = lengthDistribution(random);
+    for (int piece = 0; piece < length; piece++)
+      url += pieces[pieceDistribution(random)];
+    urls.emplace_back(url);
+  }
+
+  return urls;
+}
+
+template<typename Generate>
+long long TimeMillis(const std::vector<std::string>& urls, Generate generate)
+{
+  const auto started = std::chrono::steady_clock::now();
+  int generated = 0;
+  for (const auto& url : urls)
+    generated += generate(url).m_generated ? 1 : 0;
+  const auto elapsed = std::chrono::steady_clock::now() - started;
+
+  // Keeps the calls from being optimised away
+  if (generated < 0)
+    std::printf("%d\n", generated);
+
+  return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+}
+
+} // unnamed namespace
+
+int main()
+{
+  std::vector<std::string> urls = STREAM_URLS;
+  const std::vector<std::string> randomUrls = GenerateRandomStreamURLs(50000);
+  urls.insert(urls.end(), randomUrls.begin(), randomUrls.end());
+
+  int flussonicGenerated = 0;
+  int xtreamCodesGenerated = 0;
+  for (const auto& url : urls)
+  {
+    const CatchupSource flussonic = GenerateFlussonicCatchupSource(url);
+    if (!(flussonic == GenerateFlussonicCatchupSourceByRegex(url)))
+    {
+      std::fprintf(stderr, "Flussonic mismatch: %s\n", url.c_str());
+      tvlink::test::GetFailures()++;
+    }
+
+    const CatchupSource xtreamCodes = GenerateXtreamCodesCatchupSource(url);
+    if (!(xtreamCodes == GenerateXtreamCodesCatchupSourceByRegex(url)))
+    {
+      std::fprintf(stderr, "Xtream codes mismatch: %s\n", url.c_str());
+      tvlink::test::GetFailures()++;
+    }
+
+    flussonicGenerated += flussonic.m_generated ? 1 : 0;
+    xtreamCodesGenerated += xtreamCodes.m_generated ? 1 : 0;
+  }
+
+  // Both forms have to be covered, or agreeing on them proves nothing
+  TVLINK_CHECK(flussonicGenerated > 0);
+  TVLINK_CHECK(xtreamCodesGenerated > 0);
+
+  std::printf("%zu URLs compared, %d Flussonic and %d Xtream codes catchup sources generated\n",
+              urls.size(), flussonicGenerated, xtreamCodesGenerated);
+  std::printf("Flussonic: %lld ms with regex, %lld ms now\n",
+              TimeMillis(urls, GenerateFlussonicCatchupSourceByRegex), TimeMillis(urls, GenerateFlussonicCatchupSource));
+  std::printf("Xtream codes: %lld ms with regex, %lld ms now\n",
+              TimeMillis(urls, GenerateXtreamCodesCatchupSourceByRegex), TimeMillis(urls, GenerateXtreamCodesCatchupSource));
+
+  return tvlink::test::GetResult();
+}
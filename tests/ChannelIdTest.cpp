@@ -0,0 +1,77 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "TestUtils.h"
+
+#include "tvlink/ChannelGroups.h"
+#include "tvlink/Channels.h"
+#include "tvlink/data/Channel.h"
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace tvlink;
+using namespace tvlink::data;
+
+namespace
+{
+
+constexpr int CHANNEL_COUNT = 1000000;
+
+// Names and URLs the way large provider playlists look, many channels share a
+// name and differ only in the stream id
+std::vector<int> LoadChannelIds()
+{
+  Channels channels;
+  channels.Init();
+  ChannelGroups channelGroups(channels);
+  channelGroups.Init();
+
+  std::vector<int> groupIdList;
+  for (int i = 0; i < CHANNEL_COUNT; i++)
+  {
+    Channel channel;
+    channel.SetChannelNumber(i + 1);
+    channel.SetChannelName("Channel " + std::to_string(i % 50000));
+    channel.SetStreamURL("http://list.tv:8080/live/user/pass/" + std::to_string(i) + ".ts");
+    channels.AddChannel(channel, groupIdList, channelGroups);
+  }
+
+  std::vector<int> channelIds;
+  channelIds.reserve(CHANNEL_COUNT);
+  for (const auto& channel : channels.GetChannelsList())
+    channelIds.emplace_back(channel->GetUniqueId());
+
+  return channelIds;
+}
+
+} // unnamed namespace
+
+int main()
+{
+  const std::vector<int> channelIds = LoadChannelIds();
+  TVLINK_CHECK(static_cast<int>(channelIds.size()) == CHANNEL_COUNT);
+
+  // Every channel gets its own positive id
+  std::unordered_set<int> uniqueIds;
+  uniqueIds.reserve(channelIds.size());
+  int nonPositiveIds = 0;
+  for (int channelId : channelIds)
+  {
+    nonPositiveIds += channelId <= 0 ? 1 : 0;
+    uniqueIds.insert(channelId);
+  }
+  TVLINK_CHECK(nonPositiveIds == 0);
+  TVLINK_CHECK(uniqueIds.size() == channelIds.size());
+
+  // Loading the same playlist again hands out the same ids, collisions included
+  TVLINK_CHECK(LoadChannelIds() == channelIds);
+
+  return tvlink::test::GetResult();
+}
@@ -0,0 +1,143 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "TestUtils.h"
+
+#include "tvlink/ChannelGroups.h"
+#include "tvlink/Channels.h"
+#include "tvlink/DataGeneration.h"
+#include "tvlink/data/Channel.h"
+#include "tvlink/data/ChannelGroup.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tvlink;
+using namespace tvlink::data;
+
+namespace
+{
+
+// Readers take generations the same way PVRLinkData::GetGeneration() does
+// while a loader builds and publishes new ones like PVRLinkData::PublishGeneration()
+constexpr unsigned int GENERATIONS = 100;
+constexpr int READERS = 4;
+constexpr int UNIQUE_IDS_PER_GENERATION = 100000;
+
+int GetChannelCount(unsigned int version)
+{
+  // Big enough for a build to take a while, and different for every version
+  return 5000 + static_cast<int>(version % 7) * 1000;
+}
+
+std::shared_ptr<const DataGeneration> BuildGeneration(unsigned int version)
+{
+  Channels channels;
+  channels.Init();
+  ChannelGroups channelGroups(channels);
+  channelGroups.Init();
+
+  ChannelGroup channelGroup;
+  channelGroup.SetUniqueId(1);
+  channelGroup.SetGroupName("All");
+
+  for (int i = 0; i < GetChannelCount(version); i++)
+  {
+    Channel channel;
+    channel.SetUniqueId(static_cast<int>(version) * UNIQUE_IDS_PER_GENERATION + i);
+    channel.SetChannelNumber(i + 1);
+    channel.SetChannelName("Channel " + std::to_string(i));
+    channel.SetStreamURL("http://127.0.0.1:2020/stream/" + std::to_string(i));
+    channels.AddSnapshotChannel(channel);
+    channelGroup.AddMemberChannelIndex(i);
+  }
+  channelGroups.AddSnapshotChannelGroup(channelGroup);
+
+  return std::make_shared<DataGeneration>(version, channels, channelGroups);
+}
+
+// Everything a reader sees has to come from one and the same generation
+void CheckGeneration(const DataGeneration& generation)
+{
+  const unsigned int version = generation.GetVersion();
+  const int channelCount = GetChannelCount(version);
+
+  TVLINK_CHECK(generation.GetChannels().GetChannelsAmount() == channelCount);
+
+  const auto& channelsList = generation.GetChannels().GetChannelsList();
+  TVLINK_CHECK(static_cast<int>(channelsList.size()) == channelCount);
+  for (const auto& channel : channelsList)
+  {
+    TVLINK_CHECK(channel->GetUniqueId() / UNIQUE_IDS_PER_GENERATION == static_cast<int>(version));
+    TVLINK_CHECK(generation.GetChannels().GetChannel(channel->GetUniqueId()) == channel);
+  }
+
+  const auto& channelGroupsList = generation.GetChannelGroups().GetChannelGroupsList();
+  TVLINK_CHECK(channelGroupsList.size() == 1);
+  if (!channelGroupsList.empty())
+    TVLINK_CHECK(static_cast<int>(channelGroupsList.front().GetMemberChannelIndexes().size()) == channelCount);
+}
+
+} // unnamed namespace
+
+int main()
+{
+  std::shared_ptr<const DataGeneration> published = std::make_shared<DataGeneration>(DataGeneration::PLACEHOLDER_VERSION);
+
+  std::atomic<bool> building{false};
+  std::atomic<bool> done{false};
+  std::atomic<int> readsWhileBuilding{0};
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < READERS; i++)
+  {
+    readers.emplace_back([&]
+    {
+      unsigned int lastVersion = DataGeneration::PLACEHOLDER_VERSION;
+      while (!done)
+      {
+        const bool wasBuilding = building;
+        std::shared_ptr<const DataGeneration> generation = std::atomic_load(&published);
+
+        // Versions only ever move forward
+        TVLINK_CHECK(generation->GetVersion() >= lastVersion);
+        lastVersion = generation->GetVersion();
+
+        if (!generation->IsPlaceholder())
+          CheckGeneration(*generation);
+
+        // A read that started and ended during a build did not wait for it
+        if (wasBuilding && building)
+          readsWhileBuilding++;
+      }
+    });
+  }
+
+  for (unsigned int version = 1; version <= GENERATIONS; version++)
+  {
+    building = true;
+    std::shared_ptr<const DataGeneration> generation = BuildGeneration(version);
+    building = false;
+
+    std::atomic_store(&published, generation);
+  }
+
+  done = true;
+  for (auto& reader : readers)
+    reader.join();
+
+  TVLINK_CHECK(std::atomic_load(&published)->GetVersion() == GENERATIONS);
+  TVLINK_CHECK(readsWhileBuilding > 0);
+  std::printf("%u generations published, %d reads completed while a generation was being built\n",
+              GENERATIONS, readsWhileBuilding.load());
+
+  return tvlink::test::GetResult();
+}
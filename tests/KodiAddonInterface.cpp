@@ -0,0 +1,13 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include <kodi/AddonBase.h>
+
+// The add-on defines this in ADDONCREATOR. The tests never call into Kodi,
+// the interface only has to exist for the add-on code to link.
+AddonGlobalInterface* kodi::addon::CAddonBase::m_interface = nullptr;
@@ -0,0 +1,121 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "BenchmarkUtils.h"
+#include "StandInServer.h"
+
+#include "tvlink/StreamSources.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace tvlink;
+using namespace tvlink::test;
+
+namespace
+{
+
+constexpr int MAX_REDIRECTS = 5;
+
+// Opens the URL and follows its redirects, as a CURL open does
+bool OpenFollowingRedirects(StreamConnection& connection, const std::string& url, std::string& effectiveUrl)
+{
+  effectiveUrl = url;
+  for (int redirect = 0; redirect <= MAX_REDIRECTS; redirect++)
+  {
+    const int status = connection.Open(effectiveUrl);
+    if (status == 200)
+      return true;
+    if (status < 300 || status >= 400 || connection.GetLocation().empty())
+      return false;
+
+    effectiveUrl = connection.GetLocation();
+  }
+  return false;
+}
+
+// Opens each of the channels in turn, a number of rounds, and returns the open latencies
+std::vector<double> OpenChannels(const StandInServer& server, StreamSources& streamSources, int channels, int rounds, bool cacheRedirects)
+{
+  std::vector<double> latencies;
+
+  for (int round = 0; round < rounds; round++)
+  {
+    for (int channel = 0; channel < channels; channel++)
+    {
+      const Clock::time_point started = Clock::now();
+
+      const std::string streamUrl = server.GetURL("/redirect/" + std::to_string(channel));
+      StreamConnection connection;
+      std::string effectiveUrl;
+
+      // With cached redirects the open goes through the add-on's own ordering, as in PVRLinkData::OpenStreamSource()
+      const bool opened = cacheRedirects ? streamSources.OpenSource(streamUrl, [&connection](const std::string& connectUrl, std::string& openedUrl) {
+                                             return OpenFollowingRedirects(connection, connectUrl, openedUrl);
+                                           })
+                                         : OpenFollowingRedirects(connection, streamUrl, effectiveUrl);
+      if (!opened)
+      {
+        std::fprintf(stderr, "Could not open channel %d\n", channel);
+        return {};
+      }
+      latencies.emplace_back(GetMillis(Clock::now() - started));
+    }
+  }
+
+  return latencies;
+}
+
+} // unnamed namespace
+
+/*
+ * Measures stream opens through a redirect, following it every time and with
+ * StreamSources remembering where each source redirected to, against a local
+ * server that takes the given time to answer each request.
+ *
+ * Usage: RedirectCacheBenchmark [response delay ms] [channels] [rounds]
+ */
+int main(int argc, char* argv[])
+{
+  const std::chrono::milliseconds responseDelay(argc > 1 ? std::atoi(argv[1]) : 100);
+  const int channels = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+  const int rounds = argc > 3 ? std::max(1, std::atoi(argv[3])) : 4;
+
+  StandInServer server(responseDelay);
+  if (!server.Start())
+  {
+    std::fprintf(stderr, "Could not start the stand-in server\n");
+    return 1;
+  }
+
+  std::printf("%d channels opened %d times each, server response delay %d ms\n", channels, rounds,
+              static_cast<int>(responseDelay.count()));
+
+  StreamSources followingSources;
+  const unsigned int requestsBefore = server.GetRequests();
+  const std::vector<double> followingLatencies = OpenChannels(server, followingSources, channels, rounds, false);
+  const unsigned int followingRequests = server.GetRequests() - requestsBefore;
+
+  StreamSources cachingSources;
+  const std::vector<double> cachingLatencies = OpenChannels(server, cachingSources, channels, rounds, true);
+  const unsigned int cachingRequests = server.GetRequests() - requestsBefore - followingRequests;
+
+  if (followingLatencies.empty() || cachingLatencies.empty())
+    return 1;
+
+  PrintLatencies("following:", followingLatencies);
+  PrintLatencies("cached redirects:", cachingLatencies);
+  std::printf("%u requests following, %u with cached redirects, %u cache hits and %u misses\n", followingRequests,
+              cachingRequests, cachingSources.GetRedirectHits(), cachingSources.GetRedirectMisses());
+
+  return 0;
+}
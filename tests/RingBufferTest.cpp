@@ -0,0 +1,133 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "TestUtils.h"
+
+#include "tvlink/utilities/RingBuffer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace tvlink::utilities;
+
+namespace
+{
+
+// Odd and prime, so reads and writes keep ending at a different offset when they wrap
+constexpr size_t CAPACITY = 1021;
+constexpr size_t STREAM_BYTES = 16 * 1024 * 1024;
+constexpr size_t MAX_CHUNK_SIZE = 3 * CAPACITY;
+
+// Not a multiple of the capacity, a byte read from the wrong offset shows
+uint8_t GetStreamByte(size_t position)
+{
+  return static_cast<uint8_t>(position % 251);
+}
+
+} // unnamed namespace
+
+int main()
+{
+  // One thread, every write and read wraps at another offset
+  {
+    RingBuffer ringBuffer(7);
+    TVLINK_CHECK(ringBuffer.GetCapacity() == 7);
+
+    uint8_t data[16];
+    TVLINK_CHECK(ringBuffer.Read(data, sizeof(data)) == 0);
+
+    size_t writePosition = 0;
+    size_t readPosition = 0;
+    for (int round = 0; round < 100; round++)
+    {
+      for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = GetStreamByte(writePosition + i);
+
+      // Never more than the free space is taken
+      const size_t toWrite = 1 + round % 9;
+      const size_t freeSpace = 7 - (writePosition - readPosition);
+      const size_t written = ringBuffer.Write(data, toWrite);
+      TVLINK_CHECK(written == std::min(toWrite, freeSpace));
+      writePosition += written;
+      TVLINK_CHECK(ringBuffer.GetUsed() == writePosition - readPosition);
+
+      // Never more than what is there is handed out
+      const size_t toRead = 1 + round % 5;
+      const size_t used = writePosition - readPosition;
+      const size_t read = ringBuffer.Read(data, toRead);
+      TVLINK_CHECK(read == std::min(toRead, used));
+      for (size_t i = 0; i < read; i++)
+        TVLINK_CHECK(data[i] == GetStreamByte(readPosition + i));
+      readPosition += read;
+      TVLINK_CHECK(ringBuffer.GetUsed() == writePosition - readPosition);
+    }
+
+    // Still the same stream after wrapping many times
+    TVLINK_CHECK(readPosition > 10 * 7);
+  }
+
+  // A producer and a consumer thread, in chunks larger and smaller than the buffer
+  {
+    RingBuffer ringBuffer(CAPACITY);
+
+    std::thread producer([&ringBuffer] {
+      std::mt19937 random(1);
+      std::uniform_int_distribution<size_t> chunkSizeDistribution(1, MAX_CHUNK_SIZE);
+      std::vector<uint8_t> chunk(MAX_CHUNK_SIZE);
+
+      size_t position = 0;
+      while (position < STREAM_BYTES)
+      {
+        const size_t chunkSize = std::min(chunkSizeDistribution(random), STREAM_BYTES - position);
+        for (size_t i = 0; i < chunkSize; i++)
+          chunk[i] = GetStreamByte(position + i);
+
+        size_t written = 0;
+        while (written < chunkSize)
+        {
+          const size_t size = ringBuffer.Write(chunk.data() + written, chunkSize - written);
+          TVLINK_CHECK(size <= CAPACITY);
+          written += size;
+          if (size == 0)
+            std::this_thread::yield();
+        }
+        position += chunkSize;
+      }
+    });
+
+    std::mt19937 random(2);
+    std::uniform_int_distribution<size_t> chunkSizeDistribution(1, MAX_CHUNK_SIZE);
+    std::vector<uint8_t> chunk(MAX_CHUNK_SIZE);
+
+    size_t position = 0;
+    size_t wrongBytes = 0;
+    while (position < STREAM_BYTES)
+    {
+      const size_t used = ringBuffer.GetUsed();
+      TVLINK_CHECK(used <= CAPACITY);
+
+      const size_t size = ringBuffer.Read(chunk.data(), chunkSizeDistribution(random));
+      for (size_t i = 0; i < size; i++)
+        wrongBytes += chunk[i] != GetStreamByte(position + i) ? 1 : 0;
+      position += size;
+      if (size == 0)
+        std::this_thread::yield();
+    }
+
+    producer.join();
+
+    TVLINK_CHECK(wrongBytes == 0);
+    TVLINK_CHECK(position == STREAM_BYTES);
+    TVLINK_CHECK(ringBuffer.GetUsed() == 0);
+  }
+
+  return tvlink::test::GetResult();
+}
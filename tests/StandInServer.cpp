@@ -0,0 +1,270 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "StandInServer.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace tvlink::test;
+
+namespace
+{
+
+constexpr size_t TS_PACKET_SIZE = 188;
+constexpr size_t TS_PACKETS_PER_CHUNK = 7;
+constexpr int CHUNK_INTERVAL_MILLIS = 10;
+
+bool SendAll(int socket, const char* data, size_t size)
+{
+  while (size > 0)
+  {
+    const ssize_t sent = send(socket, data, size, MSG_NOSIGNAL);
+    if (sent <= 0)
+      return false;
+    data += sent;
+    size -= static_cast<size_t>(sent);
+  }
+  return true;
+}
+
+// Reads up to and including the blank line after the headers, anything after it is left in the socket
+bool ReadHeaders(int socket, std::string& headers)
+{
+  headers.clear();
+  char c;
+  while (headers.size() < 8192)
+  {
+    if (recv(socket, &c, 1, 0) != 1)
+      return false;
+    headers += c;
+    if (headers.size() >= 4 && headers.compare(headers.size() - 4, 4, "\r\n\r\n") == 0)
+      return true;
+  }
+  return false;
+}
+
+bool SplitURL(const std::string& url, int& port, std::string& path)
+{
+  // Only what the stand-in server hands out: http://127.0.0.1:<port>/<path>
+  static const std::string prefix = "http://127.0.0.1:";
+  if (url.compare(0, prefix.size(), prefix) != 0)
+    return false;
+
+  const size_t pathStart = url.find('/', prefix.size());
+  if (pathStart == std::string::npos)
+    return false;
+
+  port = std::atoi(url.substr(prefix.size(), pathStart - prefix.size()).c_str());
+  path = url.substr(pathStart);
+  return port > 0;
+}
+
+} // unnamed namespace
+
+StandInServer::~StandInServer()
+{
+  Stop();
+}
+
+bool StandInServer::Start()
+{
+  m_listener = socket(AF_INET, SOCK_STREAM, 0);
+  if (m_listener < 0)
+    return false;
+
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = 0;
+
+  socklen_t addressLength = sizeof(address);
+  if (bind(m_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      listen(m_listener, 64) != 0 ||
+      getsockname(m_listener, reinterpret_cast<sockaddr*>(&address), &addressLength) != 0)
+  {
+    close(m_listener);
+    m_listener = -1;
+    return false;
+  }
+
+  m_port = ntohs(address.sin_port);
+  m_stopping = false;
+  m_acceptThread = std::thread([this] { Accept(); });
+
+  return true;
+}
+
+void StandInServer::Stop()
+{
+  if (m_listener < 0)
+    return;
+
+  m_stopping = true;
+  shutdown(m_listener, SHUT_RDWR);
+  if (m_acceptThread.joinable())
+    m_acceptThread.join();
+  close(m_listener);
+  m_listener = -1;
+
+  std::vector<std::thread> connectionThreads;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (int connection : m_connections)
+      shutdown(connection, SHUT_RDWR);
+    connectionThreads.swap(m_connectionThreads);
+  }
+
+  for (auto& connectionThread : connectionThreads)
+    connectionThread.join();
+}
+
+std::string StandInServer::GetURL(const std::string& path) const
+{
+  return "http://127.0.0.1:" + std::to_string(m_port) + path;
+}
+
+void StandInServer::Accept()
+{
+  while (!m_stopping)
+  {
+    const int connection = accept(m_listener, nullptr, nullptr);
+    if (connection < 0)
+      continue;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_connections.emplace_back(connection);
+    m_connectionThreads.emplace_back([this, connection] { Serve(connection); });
+  }
+}
+
+void StandInServer::Serve(int connection)
+{
+  std::string request;
+  if (ReadHeaders(connection, request))
+  {
+    m_requests++;
+
+    const size_t pathStart = request.find(' ');
+    const size_t pathEnd = pathStart != std::string::npos ? request.find(' ', pathStart + 1) : std::string::npos;
+    const std::string path = pathEnd != std::string::npos ? request.substr(pathStart + 1, pathEnd - pathStart - 1) : "";
+
+    std::this_thread::sleep_for(m_responseDelay);
+
+    if (path.compare(0, 8, "/stream/") == 0)
+    {
+      const std::string response = "HTTP/1.1 200 OK\r\nContent-Type: video/mp2t\r\nConnection: close\r\n\r\n";
+      std::string chunk(TS_PACKET_SIZE * TS_PACKETS_PER_CHUNK, '\xff');
+      for (size_t packet = 0; packet < TS_PACKETS_PER_CHUNK; packet++)
+        chunk[packet * TS_PACKET_SIZE] = 0x47;
+
+      bool sending = SendAll(connection, response.data(), response.size());
+      while (sending && !m_stopping)
+      {
+        sending = SendAll(connection, chunk.data(), chunk.size());
+        std::this_thread::sleep_for(std::chrono::milliseconds(CHUNK_INTERVAL_MILLIS));
+      }
+    }
+    else if (path.compare(0, 10, "/redirect/") == 0)
+    {
+      const std::string response = "HTTP/1.1 302 Found\r\nLocation: " + GetURL("/stream/" + path.substr(10)) +
+                                   "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+      SendAll(connection, response.data(), response.size());
+    }
+    else
+    {
+      const std::string response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+      SendAll(connection, response.data(), response.size());
+    }
+  }
+
+  // Stop() shuts the remaining connections down, so the socket is only closed here
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto it = m_connections.begin(); it != m_connections.end(); ++it)
+  {
+    if (*it == connection)
+    {
+      m_connections.erase(it);
+      break;
+    }
+  }
+  close(connection);
+}
+
+int StreamConnection::Open(const std::string& url)
+{
+  Close();
+  m_location.clear();
+
+  int port = 0;
+  std::string path;
+  if (!SplitURL(url, port, path))
+    return 0;
+
+  m_socket = socket(AF_INET, SOCK_STREAM, 0);
+  if (m_socket < 0)
+    return 0;
+
+  const int noDelay = 1;
+  setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(static_cast<uint16_t>(port));
+
+  const std::string request = "GET " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+  std::string headers;
+  if (connect(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      !SendAll(m_socket, request.data(), request.size()) || !ReadHeaders(m_socket, headers) ||
+      headers.compare(0, 9, "HTTP/1.1 ") != 0)
+  {
+    Close();
+    return 0;
+  }
+
+  const int status = std::atoi(headers.c_str() + 9);
+
+  static const std::string locationHeader = "\r\nLocation: ";
+  const size_t locationStart = headers.find(locationHeader);
+  if (locationStart != std::string::npos)
+  {
+    const size_t valueStart = locationStart + locationHeader.size();
+    m_location = headers.substr(valueStart, headers.find("\r\n", valueStart) - valueStart);
+  }
+
+  // A stream open only returns once there are data to read, as a CURL open does
+  if (status == 200 && !ReadSome())
+  {
+    Close();
+    return 0;
+  }
+
+  return status;
+}
+
+void StreamConnection::Close()
+{
+  if (m_socket < 0)
+    return;
+
+  close(m_socket);
+  m_socket = -1;
+}
+
+bool StreamConnection::ReadSome()
+{
+  char buffer[TS_PACKET_SIZE * TS_PACKETS_PER_CHUNK];
+  return m_socket >= 0 && recv(m_socket, buffer, sizeof(buffer), 0) > 0;
+}
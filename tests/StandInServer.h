@@ -0,0 +1,90 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tvlink
+{
+  namespace test
+  {
+    /**
+     * A local HTTP server standing in for a TVLINK server in the benchmarks.
+     * Every request waits for the response delay, the time a real server takes
+     * to set up a stream, then /stream/<id> answers with an endless MPEG-TS
+     * stream and /redirect/<id> redirects to /stream/<id>, as load balancing
+     * servers do. Only plain HTTP/1.1 GETs are understood, one per connection.
+     */
+    class StandInServer
+    {
+    public:
+      explicit StandInServer(std::chrono::milliseconds responseDelay) : m_responseDelay(responseDelay) {}
+      ~StandInServer();
+
+      StandInServer(const StandInServer&) = delete;
+      StandInServer& operator=(const StandInServer&) = delete;
+
+      // Listens on an ephemeral port of the loopback interface
+      bool Start();
+      void Stop();
+
+      std::string GetURL(const std::string& path) const;
+
+      unsigned int GetRequests() const { return m_requests; }
+
+    private:
+      void Accept();
+      void Serve(int connection);
+
+      const std::chrono::milliseconds m_responseDelay;
+      int m_listener = -1;
+      int m_port = 0;
+
+      std::atomic<bool> m_stopping{false};
+      std::atomic<unsigned int> m_requests{0};
+      std::thread m_acceptThread;
+      std::mutex m_mutex;
+      std::vector<std::thread> m_connectionThreads;
+      std::vector<int> m_connections;
+    };
+
+    /**
+     * The client side, the same steps a stream open takes: connect, send the
+     * request and wait for the headers and the first bytes of the stream.
+     */
+    class StreamConnection
+    {
+    public:
+      StreamConnection() = default;
+      ~StreamConnection() { Close(); }
+
+      StreamConnection(const StreamConnection&) = delete;
+      StreamConnection& operator=(const StreamConnection&) = delete;
+
+      // Returns the status code, 0 if the connection failed. A redirect is not followed,
+      // its target is in GetLocation().
+      int Open(const std::string& url);
+      void Close();
+
+      // Blocks until stream data is there
+      bool ReadSome();
+
+      const std::string& GetLocation() const { return m_location; }
+
+    private:
+      int m_socket = -1;
+      std::string m_location;
+    };
+  } // namespace test
+} // namespace tvlink
@@ -0,0 +1,73 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "TestUtils.h"
+
+#include "tvlink/StreamManager.h"
+
+#include <string>
+
+using namespace tvlink;
+
+namespace
+{
+
+std::string GetStreamKey(int channel)
+{
+  return std::to_string(channel) + "-http://127.0.0.1:2020/stream/" + std::to_string(channel);
+}
+
+void ProbeChannels(StreamManager& streamManager, int firstChannel, int channelCount)
+{
+  for (int channel = firstChannel; channel < firstChannel + channelCount; channel++)
+    streamManager.AddProbedStreamEntry(GetStreamKey(channel), StreamType::TS, true, 100);
+}
+
+int CountFreshEntries(StreamManager& streamManager, int firstChannel, int channelCount)
+{
+  int fresh = 0;
+  for (int channel = firstChannel; channel < firstChannel + channelCount; channel++)
+    fresh += streamManager.HasFreshStreamEntry(GetStreamKey(channel)) ? 1 : 0;
+  return fresh;
+}
+
+} // unnamed namespace
+
+int main()
+{
+  // Far more channels than the smallest cache holds, every probe has to stay
+  {
+    StreamManager streamManager;
+    streamManager.SetChannelCount(20000);
+    ProbeChannels(streamManager, 0, 20000);
+    TVLINK_CHECK(CountFreshEntries(streamManager, 0, 20000) == 20000);
+  }
+
+  // Below the smallest cache size no shard evicts on its own, however unevenly the keys spread
+  {
+    StreamManager streamManager;
+    streamManager.SetChannelCount(100);
+    ProbeChannels(streamManager, 0, 4096);
+    TVLINK_CHECK(CountFreshEntries(streamManager, 0, 4096) == 4096);
+  }
+
+  // A new playlist pushes out the entries of the old one, not its own
+  {
+    StreamManager streamManager;
+    streamManager.SetChannelCount(5000);
+    ProbeChannels(streamManager, 0, 5000);
+    ProbeChannels(streamManager, 100000, 5000);
+    ProbeChannels(streamManager, 200000, 5000);
+    TVLINK_CHECK(CountFreshEntries(streamManager, 200000, 5000) == 5000);
+    TVLINK_CHECK(CountFreshEntries(streamManager, 0, 5000) < 5000);
+    TVLINK_CHECK(CountFreshEntries(streamManager, 0, 5000) + CountFreshEntries(streamManager, 100000, 5000) +
+                 CountFreshEntries(streamManager, 200000, 5000) <= 10000);
+  }
+
+  return tvlink::test::GetResult();
+}
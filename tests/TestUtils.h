@@ -0,0 +1,44 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+
+namespace tvlink
+{
+  namespace test
+  {
+    inline std::atomic<int>& GetFailures()
+    {
+      static std::atomic<int> failures{0};
+      return failures;
+    }
+
+    // The exit code of a test, 0 if no check failed
+    inline int GetResult()
+    {
+      const int failures = GetFailures();
+      if (failures > 0)
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+      return failures > 0 ? 1 : 0;
+    }
+  } // namespace test
+} // namespace tvlink
+
+// Safe from any thread, a failed check is reported and the test carries on
+#define TVLINK_CHECK(condition) \
+  do \
+  { \
+    if (!(condition)) \
+    { \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      tvlink::test::GetFailures()++; \
+    } \
+  } while (false)
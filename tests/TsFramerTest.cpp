@@ -0,0 +1,226 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "TestUtils.h"
+
+#include "tvlink/utilities/TsFramer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace tvlink::utilities;
+
+namespace
+{
+
+constexpr size_t PACKET_SIZE = TsFramer::PACKET_SIZE;
+constexpr uint8_t SYNC_BYTE = TsFramer::SYNC_BYTE;
+constexpr int PACKET_COUNT = 20000;
+constexpr int NULL_PID = 0x1FFF;
+constexpr size_t READ_BUFFER_SIZE = 4096;
+constexpr size_t MAX_READ_SIZE = 2000;
+
+// A stream with garbage between some of the packets and gaps in some of the
+// continuity counters, and the faults put into it
+struct TestStream
+{
+  std::vector<uint8_t> m_data;
+  std::vector<uint8_t> m_packets; // what the framer has to hand on
+  unsigned int m_packetCount = 0;
+  unsigned int m_garbageRuns = 0;
+  unsigned int m_continuityGaps = 0;
+};
+
+uint8_t GetPayloadByte(std::mt19937& random)
+{
+  // Never a sync byte, so only the faults put in can look like a packet start
+  const uint8_t byte = static_cast<uint8_t>(random());
+  return byte == SYNC_BYTE ? byte + 1 : byte;
+}
+
+TestStream GenerateStream(unsigned int seed)
+{
+  static const int pids[] = {0x100, 0x101, 0x200, NULL_PID};
+
+  std::mt19937 random(seed);
+  uint8_t continuity[4] = {0, 0, 0, 0};
+  bool started[4] = {false, false, false, false};
+
+  TestStream stream;
+  std::vector<std::pair<size_t, size_t>> garbageRuns;
+  int packetsSinceGarbage = 0;
+
+  for (int i = 0; i < PACKET_COUNT; i++)
+  {
+    // A packet after garbage is only confirmed by the one after it, so runs are at least two packets apart
+    if (packetsSinceGarbage >= 2 && random() % 50 == 0)
+    {
+      const size_t garbageSize = 1 + random() % 400;
+      const size_t garbageStart = stream.m_data.size();
+      for (size_t j = 0; j < garbageSize; j++)
+        stream.m_data.emplace_back(random() % 16 == 0 ? SYNC_BYTE : GetPayloadByte(random));
+
+      // In sync the framer takes a sync byte for a packet without checking further
+      if (stream.m_data[garbageStart] == SYNC_BYTE)
+        stream.m_data[garbageStart] = 0;
+
+      garbageRuns.emplace_back(garbageStart, garbageSize);
+      stream.m_garbageRuns++;
+      packetsSinceGarbage = 0;
+    }
+
+    const int pidIndex = static_cast<int>(random() % 4);
+    const int pid = pids[pidIndex];
+
+    uint8_t packet[PACKET_SIZE];
+    for (size_t j = 4; j < PACKET_SIZE; j++)
+      packet[j] = GetPayloadByte(random);
+
+    // Mostly payload only, with the cases the continuity check has to let through mixed in
+    uint8_t adaptationFieldControl = 1;
+    const unsigned int kind = random() % 40;
+    if (pid == NULL_PID)
+    {
+      continuity[pidIndex] = static_cast<uint8_t>(random() % 16);
+    }
+    else if (kind == 0 && started[pidIndex])
+    {
+      // Adaptation field only, the counter stays where it is
+      adaptationFieldControl = 2;
+      packet[4] = static_cast<uint8_t>(1 + random() % 20);
+      packet[5] = 0;
+    }
+    else if (kind == 1)
+    {
+      // Flagged discontinuity, the counter starts over anywhere
+      adaptationFieldControl = 3;
+      packet[4] = static_cast<uint8_t>(1 + random() % 20);
+      packet[5] = 0x80;
+      continuity[pidIndex] = static_cast<uint8_t>(random() % 16);
+    }
+    else if (kind == 2 && started[pidIndex])
+    {
+      // A repeat of the last packet keeps its counter
+    }
+    else if (kind == 3 && started[pidIndex])
+    {
+      // A gap of one to fourteen lost packets
+      continuity[pidIndex] = static_cast<uint8_t>((continuity[pidIndex] + 2 + random() % 14) & 0x0F);
+      stream.m_continuityGaps++;
+    }
+    else if (started[pidIndex])
+    {
+      continuity[pidIndex] = (continuity[pidIndex] + 1) & 0x0F;
+    }
+    started[pidIndex] = true;
+
+    packet[0] = SYNC_BYTE;
+    packet[1] = static_cast<uint8_t>((pid >> 8) & 0x1F);
+    packet[2] = static_cast<uint8_t>(pid & 0xFF);
+    packet[3] = static_cast<uint8_t>((adaptationFieldControl << 4) | continuity[pidIndex]);
+
+    stream.m_data.insert(stream.m_data.end(), packet, packet + PACKET_SIZE);
+    stream.m_packets.insert(stream.m_packets.end(), packet, packet + PACKET_SIZE);
+    stream.m_packetCount++;
+    packetsSinceGarbage++;
+  }
+
+  // A sync byte in the garbage may be confirmed by another one a packet further
+  // on, the framer rightly takes that for a packet, so only keep the ones that aren't
+  for (const auto& garbageRun : garbageRuns)
+  {
+    for (size_t j = garbageRun.first; j < garbageRun.first + garbageRun.second; j++)
+    {
+      if (stream.m_data[j] == SYNC_BYTE && j + PACKET_SIZE < stream.m_data.size() && stream.m_data[j + PACKET_SIZE] == SYNC_BYTE)
+        stream.m_data[j] = 0;
+    }
+  }
+
+  return stream;
+}
+
+// Reads the stream in random sizes the way LiveStream::ReadFromNetwork() does
+std::vector<uint8_t> FrameInRandomReads(TsFramer& tsFramer, const std::vector<uint8_t>& data, unsigned int seed, size_t maxReadSize)
+{
+  std::mt19937 random(seed);
+  std::vector<uint8_t> buffer(READ_BUFFER_SIZE);
+  std::vector<uint8_t> framed;
+
+  size_t position = 0;
+  while (position < data.size())
+  {
+    const size_t carrySize = tsFramer.TakeCarry(buffer.data());
+    TVLINK_CHECK(carrySize <= PACKET_SIZE);
+
+    const size_t readSize = std::min<size_t>(1 + random() % maxReadSize, data.size() - position);
+    std::memcpy(buffer.data() + carrySize, data.data() + position, readSize);
+    position += readSize;
+
+    const size_t framedSize = tsFramer.Frame(buffer.data(), carrySize + readSize);
+    TVLINK_CHECK(framedSize % PACKET_SIZE == 0);
+    framed.insert(framed.end(), buffer.begin(), buffer.begin() + framedSize);
+  }
+
+  return framed;
+}
+
+} // unnamed namespace
+
+int main()
+{
+  for (unsigned int seed = 1; seed <= 4; seed++)
+  {
+    const TestStream stream = GenerateStream(seed);
+    TVLINK_CHECK(stream.m_garbageRuns > 0);
+    TVLINK_CHECK(stream.m_continuityGaps > 0);
+    TVLINK_CHECK(TsFramer::IsTransportStream(stream.m_data.data(), 4 * PACKET_SIZE));
+
+    // Reads below a packet and above a few packets, the scan crosses read and 16 byte boundaries everywhere
+    for (size_t maxReadSize : {PACKET_SIZE - 1, MAX_READ_SIZE})
+    {
+      TsFramer tsFramer;
+      const std::vector<uint8_t> framed = FrameInRandomReads(tsFramer, stream.m_data, seed * 1000 + maxReadSize, maxReadSize);
+
+      TVLINK_CHECK(framed == stream.m_packets);
+      TVLINK_CHECK(tsFramer.GetPackets() == stream.m_packetCount);
+      TVLINK_CHECK(tsFramer.GetSyncErrors() == stream.m_garbageRuns);
+      TVLINK_CHECK(tsFramer.GetContinuityErrors() == stream.m_continuityGaps);
+    }
+  }
+
+  // Data that only has a sync byte here and there is not MPEG-TS
+  {
+    std::vector<uint8_t> data(4 * PACKET_SIZE, 0);
+    data[10] = SYNC_BYTE;
+    data[10 + PACKET_SIZE + 1] = SYNC_BYTE;
+    TVLINK_CHECK(!TsFramer::IsTransportStream(data.data(), data.size()));
+  }
+
+  // A reset drops the carried over part of a packet, as at a reconnect
+  {
+    const TestStream stream = GenerateStream(5);
+    std::vector<uint8_t> buffer(READ_BUFFER_SIZE);
+
+    TsFramer tsFramer;
+    std::memcpy(buffer.data(), stream.m_data.data(), 3 * PACKET_SIZE + 100);
+    TVLINK_CHECK(tsFramer.Frame(buffer.data(), 3 * PACKET_SIZE + 100) == 3 * PACKET_SIZE);
+
+    tsFramer.Reset();
+    TVLINK_CHECK(tsFramer.TakeCarry(buffer.data()) == 0);
+    TVLINK_CHECK(tsFramer.GetPackets() == 3);
+
+    tsFramer.Clear();
+    TVLINK_CHECK(tsFramer.GetPackets() == 0);
+  }
+
+  return tvlink::test::GetResult();
+}
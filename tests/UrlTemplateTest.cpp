@@ -0,0 +1,302 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "TestUtils.h"
+
+#include "tvlink/utilities/TimeUtils.h"
+#include "tvlink/utilities/UrlTemplate.h"
+
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace tvlink::utilities;
+
+namespace
+{
+
+// The find/replace formatter CatchupController used before URL templates were
+// compiled, kept as the reference the templates have to agree with. The
+// current time is passed in instead of read, and FormatUnits reports when it
+// takes the text after the specifier for part of it.
+
+void FormatUnits(const std::string& name, time_t tTime, std::string &urlFormatString, bool& mangled)
+{
+  const std::regex timeSecondsRegex(".*(\\{" + name + ":(\\d+)\\}).*");
+  std::cmatch mr;
+  if (std::regex_match(urlFormatString.c_str(), mr, timeSecondsRegex) && mr.length() >= 3)
+  {
+    std::string timeSecondsExp = mr[1].first;
+    std::string second = mr[1].second;
+    if (second.length() > 0)
+      timeSecondsExp = timeSecondsExp.erase(timeSecondsExp.find(second));
+    std::string dividerStr = mr[2].first;
+    second = mr[2].second;
+    if (second.length() > 0)
+      dividerStr = dividerStr.erase(dividerStr.find(second));
+
+    const time_t divider = stoi(dividerStr);
+    if (divider != 0)
+    {
+      time_t units = tTime / divider;
+      if (units < 0)
+        units = 0;
+      mangled = mangled || timeSecondsExp.length() != static_cast<size_t>(mr.length(1));
+      urlFormatString.replace(urlFormatString.find(timeSecondsExp), timeSecondsExp.length(), std::to_string(units));
+    }
+  }
+}
+
+void FormatTime(const char ch, const struct tm *pTime, std::string &urlFormatString)
+{
+  std::string str = {'{', ch, '}'};
+  size_t pos = urlFormatString.find(str);
+  while (pos != std::string::npos)
+  {
+    std::ostringstream os;
+    os << std::put_time(pTime, (std::string("%") + ch).c_str());
+    std::string timeString = os.str();
+
+    if (timeString.size() > 0)
+      urlFormatString.replace(pos, str.size(), timeString);
+
+    pos = urlFormatString.find(str);
+  }
+}
+
+void FormatTime(const std::string name, const struct tm *pTime, std::string &urlFormatString, bool hasVarPrefix)
+{
+  std::string qualifier = hasVarPrefix ? "$" : "";
+  qualifier += "{" + name + ":";
+  size_t found = urlFormatString.find(qualifier);
+  if (found != std::string::npos)
+  {
+    size_t foundStart = found + qualifier.size();
+    size_t foundEnd = urlFormatString.find("}", foundStart + 1);
+    if (foundEnd != std::string::npos)
+    {
+      std::string formatString = urlFormatString.substr(foundStart, foundEnd - foundStart);
+      const std::regex timeSpecifiers("([YmdHMS])");
+      formatString = std::regex_replace(formatString, timeSpecifiers, R"(%$&)");
+
+      std::ostringstream os;
+      os << std::put_time(pTime, formatString.c_str());
+      std::string timeString = os.str();
+
+      if (timeString.size() > 0)
+        urlFormatString.replace(found, foundEnd - found + 1, timeString);
+    }
+  }
+}
+
+void FormatUtc(const std::string& str, time_t tTime, std::string &urlFormatString)
+{
+  auto pos = urlFormatString.find(str);
+  if (pos != std::string::npos)
+  {
+    char utcTimeAsString[32];
+    std::snprintf(utcTimeAsString, sizeof(utcTimeAsString), "%lu", static_cast<unsigned long>(tTime));
+    urlFormatString.replace(pos, str.size(), utcTimeAsString);
+  }
+}
+
+std::string FormatDateTime(time_t timeStart, time_t duration, time_t timeNow, const std::string &urlFormatString, bool& mangled)
+{
+  std::string formattedUrl = urlFormatString;
+
+  std::tm dateTimeStart = SafeLocaltime(timeStart);
+  std::tm dateTimeEnd = SafeLocaltime(timeStart + duration);
+  std::tm dateTimeNow = SafeLocaltime(timeNow);
+
+  FormatTime('Y', &dateTimeStart, formattedUrl);
+  FormatTime('m', &dateTimeStart, formattedUrl);
+  FormatTime('d', &dateTimeStart, formattedUrl);
+  FormatTime('H', &dateTimeStart, formattedUrl);
+  FormatTime('M', &dateTimeStart, formattedUrl);
+  FormatTime('S', &dateTimeStart, formattedUrl);
+  FormatUtc("{utc}", timeStart, formattedUrl);
+  FormatUtc("${start}", timeStart, formattedUrl);
+  FormatUtc("{utcend}", timeStart + duration, formattedUrl);
+  FormatUtc("${end}", timeStart + duration, formattedUrl);
+  FormatUtc("{lutc}", timeNow, formattedUrl);
+  FormatUtc("${now}", timeNow, formattedUrl);
+  FormatUtc("${timestamp}", timeNow, formattedUrl);
+  FormatUtc("{duration}", duration, formattedUrl);
+  FormatUnits("duration", duration, formattedUrl, mangled);
+  FormatUtc("${offset}", timeNow - timeStart, formattedUrl);
+  FormatUnits("offset", timeNow - timeStart, formattedUrl, mangled);
+
+  FormatTime("utc", &dateTimeStart, formattedUrl, false);
+  FormatTime("start", &dateTimeStart, formattedUrl, true);
+
+  FormatTime("utcend", &dateTimeEnd, formattedUrl, false);
+  FormatTime("end", &dateTimeEnd, formattedUrl, true);
+
+  FormatTime("lutc", &dateTimeNow, formattedUrl, false);
+  FormatTime("now", &dateTimeNow, formattedUrl, true);
+  FormatTime("timestamp", &dateTimeNow, formattedUrl, true);
+
+  return formattedUrl;
+}
+
+std::string FormatDateTimeNowOnly(time_t timeNow, const std::string &urlFormatString)
+{
+  std::string formattedUrl = urlFormatString;
+  std::tm dateTimeNow = SafeLocaltime(timeNow);
+
+  FormatUtc("{lutc}", timeNow, formattedUrl);
+  FormatUtc("${now}", timeNow, formattedUrl);
+  FormatUtc("${timestamp}", timeNow, formattedUrl);
+  FormatTime("lutc", &dateTimeNow, formattedUrl, false);
+  FormatTime("now", &dateTimeNow, formattedUrl, true);
+  FormatTime("timestamp", &dateTimeNow, formattedUrl, true);
+
+  return formattedUrl;
+}
+
+// As BuildEpgTagUrl() put the two together
+std::string FormatByReplacing(const std::string& format, UrlTemplateScope scope, time_t start, time_t duration, time_t now,
+                              const std::string& catchupId, bool& mangled)
+{
+  mangled = false;
+  std::string url = scope == UrlTemplateScope::ALL ? FormatDateTime(start, duration, now, format, mangled)
+                                                   : FormatDateTimeNowOnly(now, format);
+
+  static const std::regex CATCHUP_ID_REGEX("\\{catchup-id\\}");
+  if (!catchupId.empty())
+    url = std::regex_replace(url, CATCHUP_ID_REGEX, catchupId);
+  return url;
+}
+
+// Random templates put together from specifiers, near misses and literal text.
+// Specifiers are never nested, which the templates knowingly do differently.
+std::string GenerateRandomTemplate(std::mt19937& random)
+{
+  static const std::vector<std::string> specifiers = {
+    "{Y}", "{m}", "{d}", "{H}", "{M}", "{S}", "{utc}", "${start}", "{utcend}", "${end}", "{lutc}", "${now}",
+    "${timestamp}", "{duration}", "${offset}", "{catchup-id}",
+  };
+  static const std::vector<std::string> timeFormatSpecifiers = {
+    "{utc:", "${start:", "{utcend:", "${end:", "{lutc:", "${now:", "${timestamp:",
+  };
+  static const std::vector<std::string> unitsSpecifiers = {"{duration:", "{offset:"};
+  static const std::vector<std::string> dividers = {"0", "1", "60", "060", "3600"};
+  static const std::vector<std::string> literals = {
+    "http://list.tv:8080/", "/", "?token=", "&", "a", "t", "0", "1", "60", "-", ".ts", "set", "ion",
+    "$", "{X}", "{utc", "{offset:x}", "{catchup-id", "start",
+  };
+  static const std::string timeFormatFields = "YmdHMS-:/._T";
+
+  std::uniform_int_distribution<int> lengthDistribution(1, 10);
+  std::uniform_int_distribution<int> kindDistribution(0, 9);
+  std::uniform_int_distribution<int> formatLengthDistribution(1, 6);
+
+  std::string format;
+  const int length = lengthDistribution(random);
+  for (int piece = 0; piece < length; piece++)
+  {
+    const int kind = kindDistribution(random);
+    if (kind < 3)
+    {
+      format += specifiers[random() % specifiers.size()];
+    }
+    else if (kind < 5)
+    {
+      format += timeFormatSpecifiers[random() % timeFormatSpecifiers.size()];
+      const int formatLength = formatLengthDistribution(random);
+      for (int i = 0; i < formatLength; i++)
+        format += timeFormatFields[random() % timeFormatFields.size()];
+      format += '}';
+    }
+    else if (kind < 7)
+    {
+      format += unitsSpecifiers[random() % unitsSpecifiers.size()] + dividers[random() % dividers.size()] + "}";
+    }
+    else
+    {
+      format += literals[random() % literals.size()];
+    }
+  }
+
+  return format;
+}
+
+} // unnamed namespace
+
+int main()
+{
+  const time_t now = 1603101600; // 2020-10-19 10:00 UTC
+  const std::vector<std::string> catchupIds = {"", "4711"};
+
+  std::mt19937 random(20201019);
+  std::uniform_int_distribution<time_t> startDistribution(now - 7 * 24 * 60 * 60, now + 60 * 60);
+  std::uniform_int_distribution<time_t> durationDistribution(0, 4 * 60 * 60);
+
+  int compared = 0;
+  int mangledByReplacing = 0;
+  for (int i = 0; i < 100000; i++)
+  {
+    const std::string format = GenerateRandomTemplate(random);
+    const time_t start = startDistribution(random);
+    const time_t duration = durationDistribution(random);
+    const std::string& catchupId = catchupIds[i % catchupIds.size()];
+
+    for (UrlTemplateScope scope : {UrlTemplateScope::ALL, UrlTemplateScope::NOW_ONLY})
+    {
+      bool mangled = false;
+      const std::string expected = FormatByReplacing(format, scope, start, duration, now, catchupId, mangled);
+      const std::string rendered = UrlTemplate(format, scope).Render(start, duration, now, catchupId);
+      compared++;
+
+      // The only difference allowed on these templates is the one where the old code mangled the URL
+      if (mangled)
+      {
+        mangledByReplacing++;
+        continue;
+      }
+
+      if (rendered != expected)
+      {
+        std::fprintf(stderr, "Mismatch for '%s': '%s', expected '%s'\n", format.c_str(), rendered.c_str(), expected.c_str());
+        tvlink::test::GetFailures()++;
+      }
+    }
+  }
+
+  // The mangling has to come up, or the check above proves nothing about it
+  TVLINK_CHECK(mangledByReplacing > 0);
+
+  // The two documented differences, with the templates' side pinned down
+  {
+    // The units specifier is replaced where it is, the old code took the
+    // trailing "0" for the end of it and left "0}" behind
+    bool mangled = false;
+    const std::string format = "http://list.tv/{offset:60}0";
+    TVLINK_CHECK(UrlTemplate(format, UrlTemplateScope::ALL).Render(now - 600, 0, now, "") == "http://list.tv/100");
+    TVLINK_CHECK(FormatByReplacing(format, UrlTemplateScope::ALL, now - 600, 0, now, "", mangled) == "http://list.tv/100}0");
+    TVLINK_CHECK(mangled);
+  }
+  {
+    // A time format is read up to the first closing brace, the old code
+    // replaced the inner specifier first and then the outer one
+    bool mangled = false;
+    const std::string format = "{utc:{Y}}";
+    const std::string year = UrlTemplate("{Y}", UrlTemplateScope::ALL).Render(now, 0, now, "");
+    TVLINK_CHECK(UrlTemplate(format, UrlTemplateScope::ALL).Render(now, 0, now, "") == "{" + year + "}");
+    TVLINK_CHECK(FormatByReplacing(format, UrlTemplateScope::ALL, now, 0, now, "", mangled) == year);
+  }
+
+  std::printf("%d renders compared, %d mangled by the old formatter\n", compared, mangledByReplacing);
+
+  return tvlink::test::GetResult();
+}
@@ -0,0 +1,147 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *  https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "BenchmarkUtils.h"
+#include "StandInServer.h"
+
+#include "tvlink/StreamPrewarmer.h"
+#include "tvlink/utilities/CancellationToken.h"
+#include "tvlink/utilities/TaskPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tvlink;
+using namespace tvlink::test;
+using namespace tvlink::utilities;
+
+namespace
+{
+
+// The add-on's pre-warm logic, connecting to the stand-in server instead of through Kodi
+using StandInPrewarmer = BasicStreamPrewarmer<StreamConnection>;
+
+constexpr int CONNECT_TIMEOUT_SECS = 10;
+constexpr std::chrono::seconds IDLE_TIMEOUT(15);
+constexpr size_t PREWARM_CONCURRENCY = 1;
+
+std::unique_ptr<StreamConnection> Connect(const std::string& url, unsigned int flags, int connectTimeoutSecs)
+{
+  std::unique_ptr<StreamConnection> connection(new StreamConnection());
+  if (connection->Open(url) != 200)
+    return {};
+  return connection;
+}
+
+std::string GetStreamURL(const StandInServer& server, int channel)
+{
+  return server.GetURL("/stream/" + std::to_string(channel));
+}
+
+// Zaps channel up through the channels, watching each for the dwell time. With
+// a budget the next and previous channels are pre-warmed after each zap, the
+// way PVRLinkData::PrewarmZapCandidates() does.
+std::vector<double> Zap(const StandInServer& server, int zaps, std::chrono::milliseconds dwell, size_t budget, StandInPrewarmer& prewarmer)
+{
+  TaskPool taskPool(4);
+  taskPool.SetCategoryLimit(TaskCategory::PREWARM, PREWARM_CONCURRENCY);
+  CancellationToken cancellation;
+
+  std::vector<double> latencies;
+
+  for (int channel = 0; channel < zaps; channel++)
+  {
+    const Clock::time_point zapped = Clock::now();
+    const std::string url = GetStreamURL(server, channel);
+
+    // The zap latency is the time until the first stream data can be read
+    std::unique_ptr<StreamConnection> connection;
+    if (budget > 0)
+      connection = prewarmer.Adopt(channel, url, IDLE_TIMEOUT);
+    if (!connection)
+      connection = Connect(url, 0, CONNECT_TIMEOUT_SECS);
+
+    if (!connection || !connection->ReadSome())
+    {
+      std::fprintf(stderr, "Could not open channel %d\n", channel);
+      cancellation.Cancel();
+      return {};
+    }
+    latencies.emplace_back(GetMillis(Clock::now() - zapped));
+
+    if (budget > 0)
+    {
+      std::vector<int> candidates = {channel + 1, channel - 1};
+      if (candidates.size() > budget)
+        candidates.resize(budget);
+      prewarmer.Retain(candidates);
+
+      for (int candidate : candidates)
+      {
+        taskPool.Submit(TaskCategory::PREWARM, cancellation, [&server, &prewarmer, &cancellation, candidate, budget] {
+          prewarmer.Warm(candidate, GetStreamURL(server, candidate), 0, CONNECT_TIMEOUT_SECS, budget, cancellation);
+        });
+      }
+    }
+
+    std::this_thread::sleep_for(dwell);
+  }
+
+  cancellation.Cancel();
+  taskPool.Shutdown();
+  prewarmer.Clear();
+
+  return latencies;
+}
+
+} // unnamed namespace
+
+/*
+ * Measures how long a channel change takes with and without StreamPrewarmer
+ * keeping connections for the likely next channels, against a local server
+ * that takes the given time to answer each request.
+ *
+ * Usage: ZapLatencyBenchmark [response delay ms] [dwell ms] [zaps] [budget]
+ */
+int main(int argc, char* argv[])
+{
+  const std::chrono::milliseconds responseDelay(argc > 1 ? std::atoi(argv[1]) : 150);
+  const std::chrono::milliseconds dwell(argc > 2 ? std::atoi(argv[2]) : 500);
+  const int zaps = argc > 3 ? std::max(1, std::atoi(argv[3])) : 20;
+  const size_t budget = argc > 4 ? std::max(1, std::atoi(argv[4])) : 2;
+
+  StandInServer server(responseDelay);
+  if (!server.Start())
+  {
+    std::fprintf(stderr, "Could not start the stand-in server\n");
+    return 1;
+  }
+
+  std::printf("%d zaps, server response delay %d ms, %d ms on each channel, pre-warm budget %d\n", zaps,
+              static_cast<int>(responseDelay.count()), static_cast<int>(dwell.count()), static_cast<int>(budget));
+
+  StandInPrewarmer coldPrewarmer(Connect);
+  const std::vector<double> coldLatencies = Zap(server, zaps, dwell, 0, coldPrewarmer);
+
+  StandInPrewarmer prewarmer(Connect);
+  const std::vector<double> warmLatencies = Zap(server, zaps, dwell, budget, prewarmer);
+  if (coldLatencies.empty() || warmLatencies.empty())
+    return 1;
+
+  PrintLatencies("cold:", coldLatencies);
+  PrintLatencies("pre-warmed:", warmLatencies);
+  std::printf("pre-warm hits: %u, misses: %u\n", prewarmer.GetHits(), prewarmer.GetMisses());
+
+  return 0;
+}